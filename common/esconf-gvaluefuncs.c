@@ -140,6 +140,169 @@ _esconf_string_from_gtype(GType gtype)
     return NULL;
 }
 
+/* powers of ten that are exactly representable as a double */
+static const gdouble esconf_exact_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* (1 << 53): every integer up to this is exactly representable */
+#define ESCONF_EXACT_MANTISSA_MAX  G_GUINT64_CONSTANT(9007199254740992)
+
+/* locale-independent strtod(), with the same results as
+ * g_ascii_strtod().  plain decimal numbers of up to 15 significant
+ * digits and a small exponent, which is everything
+ * _esconf_format_double() writes for most values, are converted
+ * without going through the C library: both the digits and the power
+ * of ten are exact doubles, so one multiplication or division gives
+ * the correctly rounded result.  anything else falls back to
+ * g_ascii_strtod(). */
+gdouble
+_esconf_ascii_strtod(const gchar *nptr,
+                     gchar **endptr)
+{
+    const gchar *p = nptr;
+    gboolean negative = FALSE;
+    guint64 mantissa = 0;
+    gint n_digits = 0, n_significant = 0, exp10 = 0;
+    gdouble result;
+
+    if(*p == '-' || *p == '+')
+        negative = (*p++ == '-');
+
+    for(; g_ascii_isdigit(*p); ++p, ++n_digits) {
+        if(mantissa || *p != '0') {
+            mantissa = mantissa * 10 + (*p - '0');
+            ++n_significant;
+        }
+    }
+    if(*p == '.') {
+        for(++p; g_ascii_isdigit(*p); ++p, ++n_digits, --exp10) {
+            if(mantissa || *p != '0') {
+                mantissa = mantissa * 10 + (*p - '0');
+                ++n_significant;
+            }
+        }
+    }
+
+    if(n_digits == 0 || n_significant > 15)
+        return g_ascii_strtod(nptr, endptr);
+
+    if(*p == 'e' || *p == 'E') {
+        const gchar *q = p + 1;
+        gboolean exp_negative = FALSE;
+        gint exp = 0;
+
+        if(*q == '-' || *q == '+')
+            exp_negative = (*q++ == '-');
+        if(!g_ascii_isdigit(*q))
+            return g_ascii_strtod(nptr, endptr);
+        for(; g_ascii_isdigit(*q) && exp < 1000; ++q)
+            exp = exp * 10 + (*q - '0');
+        if(g_ascii_isdigit(*q))
+            return g_ascii_strtod(nptr, endptr);
+
+        exp10 += exp_negative ? -exp : exp;
+        p = q;
+    }
+
+    /* hex floats, "inf", trailing garbage and the like */
+    if(g_ascii_isalnum(*p) || *p == '.'
+       || mantissa > ESCONF_EXACT_MANTISSA_MAX
+       || exp10 < -22 || exp10 > 22)
+    {
+        return g_ascii_strtod(nptr, endptr);
+    }
+
+    result = (gdouble)mantissa;
+    if(exp10 < 0)
+        result /= esconf_exact_pow10[-exp10];
+    else
+        result *= esconf_exact_pow10[exp10];
+
+    if(endptr)
+        *endptr = (gchar *)p;
+
+    return negative ? -result : result;
+}
+
+/* writes |val| as a plain integer if it is one that the double can
+ * hold exactly, returns FALSE otherwise */
+static gboolean
+esconf_format_integral_double(gchar *buf,
+                              gdouble val)
+{
+    gchar tmp[24];
+    guint64 n;
+    gint i = 0;
+
+    /* -0.0 is left to the general path so it keeps its sign */
+    if(!(ABS(val) < 1e15) || val == 0.0 || val != (gdouble)(gint64)val)
+        return FALSE;
+
+    n = (guint64)ABS(val);
+    while(n) {
+        tmp[i++] = '0' + n % 10;
+        n /= 10;
+    }
+    if(val < 0)
+        *buf++ = '-';
+    while(i)
+        *buf++ = tmp[--i];
+    *buf = 0;
+
+    return TRUE;
+}
+
+/* writes the shortest decimal representation of |val| that
+ * _esconf_ascii_strtod() (or g_ascii_strtod()) reads back as exactly
+ * |val| into |buf|, which must hold G_ASCII_DTOSTR_BUF_SIZE bytes.
+ * rounding to 15 significant digits already gives the shortest string
+ * for every double whose shortest form has no more than 15 digits;
+ * 16 or 17 digits are only tried when that doesn't read back. */
+gchar *
+_esconf_format_double(gchar *buf,
+                      gdouble val)
+{
+    if(esconf_format_integral_double(buf, val))
+        return buf;
+
+    g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.15g", val);
+    if(_esconf_ascii_strtod(buf, NULL) == val)
+        return buf;
+
+    g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.16g", val);
+    if(_esconf_ascii_strtod(buf, NULL) == val)
+        return buf;
+
+    return g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.17g", val);
+}
+
+/* same as _esconf_format_double(), for the shortest string that reads
+ * back as |val| once narrowed to a float */
+gchar *
+_esconf_format_float(gchar *buf,
+                     gfloat val)
+{
+    if(esconf_format_integral_double(buf, val))
+        return buf;
+
+    g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.6g", val);
+    if((gfloat)_esconf_ascii_strtod(buf, NULL) == val)
+        return buf;
+
+    g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.7g", val);
+    if((gfloat)_esconf_ascii_strtod(buf, NULL) == val)
+        return buf;
+
+    g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.8g", val);
+    if((gfloat)_esconf_ascii_strtod(buf, NULL) == val)
+        return buf;
+
+    return g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%.9g", val);
+}
+
 gboolean
 _esconf_gvalue_from_string(GValue *value,
                            const gchar *str)
@@ -205,18 +368,18 @@ _esconf_gvalue_from_string(GValue *value,
 
         case G_TYPE_FLOAT:
             errno = 0;
-            dval = g_ascii_strtod(str, &endptr);
+            dval = _esconf_ascii_strtod(str, &endptr);
             if(0.0 == dval && ERANGE == errno)
                 return FALSE;
             CHECK_CONVERT_STATUS();
-            if(dval < G_MINFLOAT || dval > G_MAXFLOAT)
+            if(dval < -G_MAXFLOAT || dval > G_MAXFLOAT)
                 return FALSE;
             g_value_set_float(value, (gfloat)dval);
             return TRUE;
 
         case G_TYPE_DOUBLE:
             errno = 0;
-            dval = g_ascii_strtod(str, &endptr);
+            dval = _esconf_ascii_strtod(str, &endptr);
             if(0.0 == dval && ERANGE == errno)
                 return FALSE;
             CHECK_CONVERT_STATUS();
@@ -334,9 +497,45 @@ _esconf_gvalue_is_equal(const GValue *value1,
 
         default:
             if(G_VALUE_TYPE(value1) == ESCONF_TYPE_INT16)
-                return esconf_g_value_get_int16(value1) == esconf_g_value_get_uint16(value2);
+                return esconf_g_value_get_int16(value1) == esconf_g_value_get_int16(value2);
             else if(G_VALUE_TYPE(value1) == ESCONF_TYPE_UINT16)
                 return esconf_g_value_get_uint16(value1) == esconf_g_value_get_uint16(value2);
+            else if(G_VALUE_TYPE(value1) == G_TYPE_PTR_ARRAY) {
+                GPtrArray *arr1 = g_value_get_boxed(value1);
+                GPtrArray *arr2 = g_value_get_boxed(value2);
+                guint i;
+
+                if(arr1 == arr2)
+                    return TRUE;
+                if(!arr1 || !arr2 || arr1->len != arr2->len)
+                    return FALSE;
+
+                for(i = 0; i < arr1->len; ++i) {
+                    if(!_esconf_gvalue_is_equal(g_ptr_array_index(arr1, i),
+                                                g_ptr_array_index(arr2, i)))
+                    {
+                        return FALSE;
+                    }
+                }
+
+                return TRUE;
+            } else if(G_VALUE_TYPE(value1) == G_TYPE_STRV) {
+                gchar **strv1 = g_value_get_boxed(value1);
+                gchar **strv2 = g_value_get_boxed(value2);
+                guint i;
+
+                if(strv1 == strv2)
+                    return TRUE;
+                if(!strv1 || !strv2)
+                    return FALSE;
+
+                for(i = 0; strv1[i] && strv2[i]; ++i) {
+                    if(strcmp(strv1[i], strv2[i]))
+                        return FALSE;
+                }
+
+                return !strv1[i] && !strv2[i];
+            }
             break;
 #undef HANDLE_CMP_GV
     }
@@ -344,6 +543,92 @@ _esconf_gvalue_is_equal(const GValue *value1,
     return FALSE;
 }
 
+/* mixes |hash| into |seed|; same as boost's hash_combine() */
+#define ESCONF_HASH_COMBINE(seed, hash) \
+    ((seed) ^ ((hash) + 0x9e3779b9 + ((seed) << 6) + ((seed) >> 2)))
+
+/* returns a hash of the contents of |value| that is consistent with
+ * _esconf_gvalue_is_equal(): equal values hash the same.  the result
+ * is never 0, so callers can use 0 to mean "not computed yet". */
+guint
+_esconf_gvalue_hash(const GValue *value)
+{
+    guint hash = 0;
+
+    if(!value || G_VALUE_TYPE(value) == G_TYPE_INVALID)
+        return 1;
+
+    switch(G_VALUE_TYPE(value)) {
+        case G_TYPE_CHAR:
+            hash = (guint)g_value_get_schar(value);
+            break;
+        case G_TYPE_UCHAR:
+            hash = g_value_get_uchar(value);
+            break;
+        case G_TYPE_BOOLEAN:
+            hash = g_value_get_boolean(value) ? 1 : 0;
+            break;
+        case G_TYPE_INT:
+            hash = (guint)g_value_get_int(value);
+            break;
+        case G_TYPE_UINT:
+            hash = g_value_get_uint(value);
+            break;
+        case G_TYPE_INT64:
+        case G_TYPE_UINT64: {
+            guint64 v = G_VALUE_TYPE(value) == G_TYPE_INT64
+                        ? (guint64)g_value_get_int64(value)
+                        : g_value_get_uint64(value);
+            hash = (guint)(v ^ (v >> 32));
+            break;
+        }
+        case G_TYPE_FLOAT:
+        case G_TYPE_DOUBLE: {
+            gdouble v = G_VALUE_TYPE(value) == G_TYPE_FLOAT
+                        ? (gdouble)g_value_get_float(value)
+                        : g_value_get_double(value);
+            /* 0.0 and -0.0 are equal, but differ in their bits */
+            if(v == 0.0)
+                v = 0.0;
+            hash = g_double_hash(&v);
+            break;
+        }
+        case G_TYPE_STRING:
+            hash = g_value_get_string(value)
+                   ? g_str_hash(g_value_get_string(value)) : 0;
+            break;
+
+        default:
+            if(G_VALUE_TYPE(value) == ESCONF_TYPE_INT16)
+                hash = (guint)esconf_g_value_get_int16(value);
+            else if(G_VALUE_TYPE(value) == ESCONF_TYPE_UINT16)
+                hash = esconf_g_value_get_uint16(value);
+            else if(G_VALUE_TYPE(value) == G_TYPE_PTR_ARRAY) {
+                GPtrArray *arr = g_value_get_boxed(value);
+                guint i;
+
+                if(arr) {
+                    hash = arr->len;
+                    for(i = 0; i < arr->len; ++i) {
+                        hash = ESCONF_HASH_COMBINE(hash,
+                                                   _esconf_gvalue_hash(g_ptr_array_index(arr, i)));
+                    }
+                }
+            } else if(G_VALUE_TYPE(value) == G_TYPE_STRV) {
+                gchar **strv = g_value_get_boxed(value);
+                guint i;
+
+                for(i = 0; strv && strv[i]; ++i)
+                    hash = ESCONF_HASH_COMBINE(hash, g_str_hash(strv[i]));
+            }
+            break;
+    }
+
+    hash = ESCONF_HASH_COMBINE(hash, (guint)G_VALUE_TYPE(value));
+
+    return hash ? hash : 1;
+}
+
 void
 _esconf_gvalue_free(GValue *value)
 {
@@ -354,44 +639,46 @@ _esconf_gvalue_free(GValue *value)
 }
 
 
-GVariant *
-esconf_basic_gvalue_to_gvariant (const GValue *value) {
-
-    const GVariantType *type = NULL;
-
-    switch (G_VALUE_TYPE(value)){
+/* variant type of a basic value of type |gtype|, NULL if there is no
+ * direct mapping (G_TYPE_CHAR is sent as int16 by hand) */
+static const GVariantType *
+esconf_basic_gtype_to_gvariant_type (GType gtype)
+{
+    switch (gtype){
     case G_TYPE_UINT:
-        type = G_VARIANT_TYPE_UINT32;
-        break;
+        return G_VARIANT_TYPE_UINT32;
     case G_TYPE_INT:
-        type = G_VARIANT_TYPE_INT32;
-        break;
+        return G_VARIANT_TYPE_INT32;
     case G_TYPE_BOOLEAN:
-        type = G_VARIANT_TYPE_BOOLEAN;
-        break;
+        return G_VARIANT_TYPE_BOOLEAN;
     case G_TYPE_UCHAR:
-        type = G_VARIANT_TYPE_BYTE;
-        break;
+        return G_VARIANT_TYPE_BYTE;
     case G_TYPE_INT64:
-        type = G_VARIANT_TYPE_INT64;
-        break;
+        return G_VARIANT_TYPE_INT64;
     case G_TYPE_UINT64:
-        type = G_VARIANT_TYPE_UINT64;
-        break;
+        return G_VARIANT_TYPE_UINT64;
     case G_TYPE_DOUBLE:
-        type = G_VARIANT_TYPE_DOUBLE;
-        break;
+        return G_VARIANT_TYPE_DOUBLE;
     case G_TYPE_STRING:
-        type = G_VARIANT_TYPE_STRING;
-        break;
+        return G_VARIANT_TYPE_STRING;
     default:
-        if (G_VALUE_TYPE(value) == ESCONF_TYPE_INT16)
-            type = G_VARIANT_TYPE_INT16;
-        else if (G_VALUE_TYPE(value) == ESCONF_TYPE_UINT16)
-            type = G_VARIANT_TYPE_UINT16;
+        if (gtype == ESCONF_TYPE_INT16)
+            return G_VARIANT_TYPE_INT16;
+        else if (gtype == ESCONF_TYPE_UINT16)
+            return G_VARIANT_TYPE_UINT16;
         break;
     }
 
+    return NULL;
+}
+
+GVariant *
+esconf_basic_gvalue_to_gvariant (const GValue *value) {
+
+    const GVariantType *type;
+
+    type = esconf_basic_gtype_to_gvariant_type (G_VALUE_TYPE(value));
+
     if (type) {
         return g_dbus_gvalue_to_gvariant (value, type);
     }
@@ -456,6 +743,116 @@ gboolean esconf_basic_gvariant_to_gvalue (GVariant *variant, GValue *value)
     return (ret);
 }
 
+/* variant type shared by all elements of |arr|, or NULL if the array
+ * is empty, mixed, or holds a type that has to go through "av" */
+static const GVariantType *
+esconf_value_array_get_element_type (GPtrArray *arr)
+{
+    GType gtype;
+    guint i;
+
+    if (arr->len == 0 || !g_ptr_array_index (arr, 0))
+        return NULL;
+
+    gtype = G_VALUE_TYPE (g_ptr_array_index (arr, 0));
+    for (i = 1; i < arr->len; ++i) {
+        const GValue *v = g_ptr_array_index (arr, i);
+
+        if (!v || G_VALUE_TYPE (v) != gtype)
+            return NULL;
+    }
+
+    return esconf_basic_gtype_to_gvariant_type (gtype);
+}
+
+/* homogeneous arrays of a basic type are sent as a typed array ("ai",
+ * "ad", "as", ...) so the elements are packed in one block instead of
+ * each being wrapped in its own variant; mixed (or empty) arrays are
+ * sent as "av".  returns a floating reference. */
+static GVariant *
+esconf_value_array_to_gvariant (GPtrArray *arr)
+{
+    const GVariantType *elem_type;
+    GVariantBuilder builder;
+    guint i;
+
+    g_return_val_if_fail (arr, NULL);
+
+    elem_type = esconf_value_array_get_element_type (arr);
+
+    if (elem_type && g_variant_type_equal (elem_type, G_VARIANT_TYPE_STRING)) {
+        const gchar **strv = g_new (const gchar *, arr->len);
+        GVariant *variant = NULL;
+
+        for (i = 0; i < arr->len; ++i) {
+            strv[i] = g_value_get_string (g_ptr_array_index (arr, i));
+            /* "as" can't carry NULL strings, leave those to "av" */
+            if (!strv[i])
+                break;
+        }
+
+        if (i == arr->len)
+            variant = g_variant_new_strv (strv, arr->len);
+        g_free (strv);
+
+        if (variant)
+            return variant;
+    }
+    else if (elem_type) {
+        gchar type_str[3] = { 'a', g_variant_type_peek_string (elem_type)[0], 0 };
+        gsize elem_size;
+        guint8 *data;
+
+        switch (type_str[1]) {
+        case 'b': case 'y': elem_size = 1; break;
+        case 'n': case 'q': elem_size = 2; break;
+        case 'i': case 'u': elem_size = 4; break;
+        default:            elem_size = 8; break;  /* x, t, d */
+        }
+
+        data = g_malloc (arr->len * elem_size);
+
+        for (i = 0; i < arr->len; ++i) {
+            const GValue *v = g_ptr_array_index (arr, i);
+            gpointer p = data + i * elem_size;
+
+            switch (type_str[1]) {
+            case 'b': *(guint8 *)p = g_value_get_boolean (v) ? 1 : 0; break;
+            case 'y': *(guint8 *)p = g_value_get_uchar (v); break;
+            case 'n': *(gint16 *)p = esconf_g_value_get_int16 (v); break;
+            case 'q': *(guint16 *)p = esconf_g_value_get_uint16 (v); break;
+            case 'i': *(gint32 *)p = g_value_get_int (v); break;
+            case 'u': *(guint32 *)p = g_value_get_uint (v); break;
+            case 'x': *(gint64 *)p = g_value_get_int64 (v); break;
+            case 't': *(guint64 *)p = g_value_get_uint64 (v); break;
+            case 'd': *(gdouble *)p = g_value_get_double (v); break;
+            }
+        }
+
+        return g_variant_new_from_data (G_VARIANT_TYPE (type_str),
+                                        data, arr->len * elem_size, TRUE,
+                                        g_free, data);
+    }
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("av"));
+
+    for (i = 0; i < arr->len; ++i) {
+        const GValue *v = g_ptr_array_index (arr, i);
+        GVariant *var;
+
+        if (!v)
+            continue;
+
+        var = esconf_basic_gvalue_to_gvariant (v);
+        if (var) {
+            g_variant_builder_add (&builder, "v", var);
+            g_variant_unref (var);
+        }
+    }
+
+    return g_variant_builder_end (&builder);
+}
+
 GVariant *
 esconf_gvalue_to_gvariant (const GValue *value)
 {
@@ -469,28 +866,7 @@ esconf_gvalue_to_gvariant (const GValue *value)
         /* Check for array  */
         g_return_val_if_fail (arr, NULL);
 
-        if (arr->len == 0) {
-            variant = g_variant_ref_sink(g_variant_new ("av", NULL));
-        }
-        else {
-            GVariantBuilder builder;
-            guint i = 0;
-
-            g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
-
-            for (i=0; i < arr->len; ++i) {
-                GValue *v = g_ptr_array_index (arr, i);
-                GVariant *var = NULL;
-
-                var = esconf_basic_gvalue_to_gvariant (v);
-                if (var) {
-                    g_variant_builder_add (&builder, "v", var, NULL);
-                    g_variant_unref (var);
-                }
-            }
-
-            variant = g_variant_ref_sink(g_variant_builder_end (&builder));
-        }
+        variant = g_variant_ref_sink(esconf_value_array_to_gvariant (arr));
     }
     else if (G_VALUE_TYPE(value) == G_TYPE_STRV) {
         gchar **strlist;
@@ -520,28 +896,7 @@ GVariant *esconf_hash_to_gvariant (GHashTable *hash)
         GVariant *v;
 
         if (G_VALUE_TYPE (value) == G_TYPE_PTR_ARRAY) {
-            GPtrArray *arr;
-            GVariantBuilder arr_builder;
-            uint i;
-
-            arr = g_value_get_boxed(value);
-
-            g_variant_builder_init (&arr_builder, G_VARIANT_TYPE ("av"));
-
-            for (i = 0; i < arr->len; ++i) {
-                GValue *item_value = g_ptr_array_index(arr, i);
-
-                if(item_value)
-                {
-                    v = esconf_basic_gvalue_to_gvariant(item_value);
-                    if (v) {
-                        g_variant_builder_add (&arr_builder, "v", v);
-                        g_variant_unref (v);
-                    }
-                }
-            }
-
-            v = g_variant_builder_end (&arr_builder);
+            v = esconf_value_array_to_gvariant (g_value_get_boxed(value));
             g_variant_builder_add (&builder, "{sv}", key, v);
         }
         else if (G_VALUE_TYPE (value) == G_TYPE_STRV) {
@@ -595,6 +950,154 @@ esconf_dup_value_array (GPtrArray *arr, gboolean auto_destroy_value) {
     return retArr;
 }
 
+static void
+esconf_value_array_add_copy (GPtrArray *arr, const GValue *value)
+{
+    GValue *v = g_new0(GValue, 1);
+
+    g_value_init (v, G_VALUE_TYPE(value));
+    g_value_copy (value, v);
+    g_ptr_array_add(arr, v);
+}
+
+/* returns a new array, owning its values, with |change| applied to
+ * |arr|, or NULL if |index| is out of range.  |arr| is not modified
+ * and may be NULL, in which case the only valid change is an insert
+ * at index 0.  |value| is ignored for ESCONF_ARRAY_CHANGE_REMOVE. */
+GPtrArray *
+esconf_value_array_apply_change (const GPtrArray *arr,
+                                 EsconfArrayChange change,
+                                 guint index,
+                                 const GValue *value)
+{
+    GPtrArray *retArr;
+    guint len = arr ? arr->len : 0;
+    guint i;
+
+    if (change == ESCONF_ARRAY_CHANGE_INSERT ? index > len : index >= len)
+        return NULL;
+
+    g_return_val_if_fail (change == ESCONF_ARRAY_CHANGE_REMOVE
+                          || G_IS_VALUE (value), NULL);
+
+    retArr = g_ptr_array_new_full(len + 1, (GDestroyNotify)xfonf_free_array_elem_val);
+
+    for (i = 0; i < len; i++) {
+        const GValue *src = g_ptr_array_index(arr, i);
+
+        if (i == index) {
+            if (change == ESCONF_ARRAY_CHANGE_REMOVE)
+                continue;
+            else if (change == ESCONF_ARRAY_CHANGE_SET)
+                src = value;
+            else
+                esconf_value_array_add_copy (retArr, value);
+        }
+
+        esconf_value_array_add_copy (retArr, src);
+    }
+
+    /* append */
+    if (change == ESCONF_ARRAY_CHANGE_INSERT && index == len)
+        esconf_value_array_add_copy (retArr, value);
+
+    return retArr;
+}
+
+
+/* decodes a typed array of a basic type, as sent by
+ * esconf_value_array_to_gvariant(), into an array of values.  the
+ * elements are read straight from the serialized data rather than
+ * through a child variant each. */
+static GPtrArray *
+esconf_typed_gvariant_to_value_array (GVariant *variant)
+{
+    GPtrArray *arr;
+    gchar elem_class;
+    gsize n_elements = 0;
+    gsize elem_size = 0;
+    gsize i;
+
+    elem_class = g_variant_type_peek_string (g_variant_get_type (variant))[1];
+
+    if (elem_class == 's') {
+        const gchar **strv = g_variant_get_strv (variant, &n_elements);
+
+        arr = g_ptr_array_new_full(n_elements, (GDestroyNotify)xfonf_free_array_elem_val);
+        for (i = 0; i < n_elements; ++i) {
+            GValue *v = g_new0(GValue, 1);
+
+            g_value_init (v, G_TYPE_STRING);
+            g_value_set_string (v, strv[i]);
+            g_ptr_array_add (arr, v);
+        }
+        g_free (strv);
+
+        return arr;
+    }
+
+    switch (elem_class) {
+    case 'b': case 'y': elem_size = 1; break;
+    case 'n': case 'q': elem_size = 2; break;
+    case 'i': case 'u': elem_size = 4; break;
+    default:            elem_size = 8; break;  /* x, t, d */
+    }
+
+    {
+        const guint8 *data = g_variant_get_fixed_array (variant, &n_elements, elem_size);
+
+        arr = g_ptr_array_new_full(n_elements, (GDestroyNotify)xfonf_free_array_elem_val);
+
+        for (i = 0; i < n_elements; ++i) {
+            const guint8 *p = data + i * elem_size;
+            GValue *v = g_new0(GValue, 1);
+
+            /* same mapping as esconf_basic_gvariant_to_gvalue() */
+            switch (elem_class) {
+            case 'b':
+                g_value_init (v, G_TYPE_BOOLEAN);
+                g_value_set_boolean (v, *p != 0);
+                break;
+            case 'y':
+                g_value_init (v, G_TYPE_UCHAR);
+                g_value_set_uchar (v, *p);
+                break;
+            case 'n':
+                g_value_init (v, G_TYPE_INT);
+                g_value_set_int (v, *(const gint16 *)p);
+                break;
+            case 'q':
+                g_value_init (v, G_TYPE_UINT);
+                g_value_set_uint (v, *(const guint16 *)p);
+                break;
+            case 'i':
+                g_value_init (v, G_TYPE_INT);
+                g_value_set_int (v, *(const gint32 *)p);
+                break;
+            case 'u':
+                g_value_init (v, G_TYPE_UINT);
+                g_value_set_uint (v, *(const guint32 *)p);
+                break;
+            case 'x':
+                g_value_init (v, G_TYPE_INT64);
+                g_value_set_int64 (v, *(const gint64 *)p);
+                break;
+            case 't':
+                g_value_init (v, G_TYPE_UINT64);
+                g_value_set_uint64 (v, *(const guint64 *)p);
+                break;
+            case 'd':
+                g_value_init (v, G_TYPE_DOUBLE);
+                g_value_set_double (v, *(const gdouble *)p);
+                break;
+            }
+
+            g_ptr_array_add (arr, v);
+        }
+    }
+
+    return arr;
+}
 
 GValue * esconf_gvariant_to_gvalue (GVariant *in_variant)
 {
@@ -636,9 +1139,10 @@ GValue * esconf_gvariant_to_gvalue (GVariant *in_variant)
 
         g_value_take_boxed(value, arr);
     }
-    else if (g_variant_is_of_type (variant, G_VARIANT_TYPE("as"))) {
-        g_value_init(value, G_TYPE_STRV);
-        g_value_set_boxed (value, g_variant_get_strv (variant, NULL));
+    else if (g_variant_is_of_type (variant, G_VARIANT_TYPE_ARRAY)
+             && strchr ("bynqiuxtds", g_variant_get_type_string (variant)[1])) {
+        g_value_init(value, G_TYPE_PTR_ARRAY);
+        g_value_take_boxed(value, esconf_typed_gvariant_to_value_array (variant));
     }
     else {/* Should be a basic type */
       if (!esconf_basic_gvariant_to_gvalue(variant, value)) {
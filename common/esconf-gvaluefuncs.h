@@ -25,6 +25,15 @@
 
 G_BEGIN_DECLS
 
+/* element-level array changes, as sent with the ArraySetIndex,
+ * ArrayInsert and ArrayRemove methods and the ArrayChanged signal */
+typedef enum
+{
+    ESCONF_ARRAY_CHANGE_SET = 0,
+    ESCONF_ARRAY_CHANGE_INSERT,
+    ESCONF_ARRAY_CHANGE_REMOVE,
+} EsconfArrayChange;
+
 G_GNUC_INTERNAL GType _esconf_gtype_from_string(const gchar *type);
 G_GNUC_INTERNAL const gchar *_esconf_string_from_gtype(GType gtype);
 
@@ -33,13 +42,27 @@ G_GNUC_INTERNAL gboolean _esconf_gvalue_from_string(GValue *value,
 
 G_GNUC_INTERNAL gchar *_esconf_string_from_gvalue(GValue *value);
 
+G_GNUC_INTERNAL gdouble _esconf_ascii_strtod(const gchar *nptr,
+                                             gchar **endptr);
+G_GNUC_INTERNAL gchar *_esconf_format_double(gchar *buf,
+                                             gdouble val);
+G_GNUC_INTERNAL gchar *_esconf_format_float(gchar *buf,
+                                            gfloat val);
+
 G_GNUC_INTERNAL gboolean _esconf_gvalue_is_equal(const GValue *value1,
                                                  const GValue *value2);
 
+G_GNUC_INTERNAL guint _esconf_gvalue_hash(const GValue *value);
+
 G_GNUC_INTERNAL void _esconf_gvalue_free(GValue *value);
 
 G_GNUC_INTERNAL GPtrArray *esconf_dup_value_array (GPtrArray *arr, gboolean auto_destroy_value);
 
+G_GNUC_INTERNAL GPtrArray *esconf_value_array_apply_change (const GPtrArray *arr,
+                                                            EsconfArrayChange change,
+                                                            guint index,
+                                                            const GValue *value);
+
 G_GNUC_INTERNAL GVariant *esconf_basic_gvalue_to_gvariant (const GValue *value);
 
 G_GNUC_INTERNAL GVariant *esconf_gvalue_to_gvariant (const GValue *value);
@@ -49,19 +49,60 @@
  * all this.
  **/
 
+typedef struct _EsconfGBindingDispatcher EsconfGBindingDispatcher;
+
 typedef struct
 {
+    /* the id handed out to the user */
+    gulong id;
+
+    /* held by the object handler, and by anyone walking a copy of a
+     * binding list while handlers may unbind */
+    gint ref_count;
+
     EsconfChannel *channel;
     gchar *esconf_property;
     GType esconf_property_type;
     gulong channel_handler;
+    /* set for bindings created by esconf_g_property_bind_many(), which
+     * share one channel handler */
+    EsconfGBindingDispatcher *dispatcher;
+    /* set while the binding writes to the channel, so it ignores its
+     * own change; the channel handler can't be blocked instead since
+     * bindings of a dispatcher share it */
+    gboolean writing;
 
     GObject *object;
     gchar *object_property;
     GType object_property_type;
     gulong object_handler;
+
+    /* rate limiting of object to channel writes, see
+     * esconf_g_property_set_throttle() */
+    guint throttle_interval;
+    guint throttle_id;
+    GValue throttle_value;
+
+    /* links in the registry indexes, data points to the binding; the
+     * channel is kept separately since binding->channel is cleared
+     * when the channel goes away */
+    gboolean registered;
+    EsconfChannel *registry_channel;
+    GList channel_link;
+    GList object_link;
 } EsconfGBinding;
 
+/* a single "property-changed" handler per channel that forwards
+ * changes to the bindings registered for the changed property */
+struct _EsconfGBindingDispatcher
+{
+    EsconfChannel *channel;
+    gulong handler;
+
+    /* esconf property -> GSList of EsconfGBinding */
+    GHashTable *bindings;
+};
+
 /* same structure as in gdk, but we don't link to gdk */
 typedef struct
 {
@@ -92,101 +133,300 @@ static void esconf_g_property_channel_notify(EsconfChannel *channel,
                                              gpointer user_data);
 static void esconf_g_property_channel_disconnect(gpointer user_data,
                                                  GClosure *closure);
+static void esconf_g_property_dispatcher_remove(EsconfGBindingDispatcher *dispatcher,
+                                                EsconfGBinding *binding);
 
 
 
+/* the binding registry: all bindings by id, plus per-(channel,
+ * property) and per-object lists so nothing has to scan every
+ * binding in the process */
 G_LOCK_DEFINE_STATIC(__bindings);
-static GSList *__bindings = NULL;
+static GHashTable *__bindings = NULL;            /* id -> binding */
+static GHashTable *__bindings_by_channel = NULL; /* channel -> property -> GList */
+static GHashTable *__bindings_by_object = NULL;  /* object -> GList */
+G_LOCK_DEFINE_STATIC(__dispatchers);
 static GType   __gdkcolor_gtype = 0;
 static GType   __gdkrgba_gtype = 0;
+static GQuark  __dispatcher_quark = 0;
+
 
 
+/* the object lists are keyed by the object, the property lists by the
+ * head binding's own copy of the property name, so the key has to
+ * change along with the head */
+static gpointer
+esconf_g_binding_list_key(GHashTable *table,
+                          GList *link)
+{
+    EsconfGBinding *binding = link->data;
+
+    if(table == __bindings_by_object)
+        return binding->object;
+
+    return binding->esconf_property;
+}
+
+/* the lists are threaded through links embedded in the bindings, so
+ * both inserting and removing a binding is O(1) */
+static void
+esconf_g_binding_list_prepend(GHashTable *table,
+                              GList *link)
+{
+    GList *head = g_hash_table_lookup(table,
+                                      esconf_g_binding_list_key(table, link));
+
+    link->prev = NULL;
+    link->next = head;
+    if(head)
+        head->prev = link;
+    g_hash_table_replace(table, esconf_g_binding_list_key(table, link), link);
+}
+
+static void
+esconf_g_binding_list_remove(GHashTable *table,
+                             GList *link)
+{
+    if(link->next)
+        link->next->prev = link->prev;
+
+    if(link->prev)
+        link->prev->next = link->next;
+    else if(link->next) {
+        g_hash_table_replace(table, esconf_g_binding_list_key(table, link->next),
+                             link->next);
+    } else
+        g_hash_table_remove(table, esconf_g_binding_list_key(table, link));
+
+    link->prev = link->next = NULL;
+}
 
+/* must be called with the __bindings lock held */
 static void
-esconf_g_property_object_notify_gdkcolor(EsconfGBinding *binding)
+esconf_g_binding_register(EsconfGBinding *binding)
 {
-    FakeGdkColor *color = NULL;
+    GHashTable *properties;
+
+    if(G_UNLIKELY(!__bindings)) {
+        __bindings = g_hash_table_new(g_direct_hash, g_direct_equal);
+        __bindings_by_channel = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                                      NULL,
+                                                      (GDestroyNotify)g_hash_table_destroy);
+        __bindings_by_object = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+
+    g_hash_table_insert(__bindings, GSIZE_TO_POINTER(binding->id), binding);
+
+    properties = g_hash_table_lookup(__bindings_by_channel, binding->channel);
+    if(!properties) {
+        properties = g_hash_table_new(g_str_hash, g_str_equal);
+        g_hash_table_insert(__bindings_by_channel, binding->channel, properties);
+    }
+    binding->channel_link.data = binding;
+    esconf_g_binding_list_prepend(properties, &binding->channel_link);
+
+    binding->object_link.data = binding;
+    esconf_g_binding_list_prepend(__bindings_by_object, &binding->object_link);
+
+    binding->registry_channel = binding->channel;
+    binding->registered = TRUE;
+}
+
+/* must be called with the __bindings lock held */
+static void
+esconf_g_binding_unregister(EsconfGBinding *binding)
+{
+    GHashTable *properties;
+
+    if(!binding->registered || !__bindings)
+        return;
+
+    g_hash_table_remove(__bindings, GSIZE_TO_POINTER(binding->id));
+
+    properties = g_hash_table_lookup(__bindings_by_channel,
+                                     binding->registry_channel);
+    esconf_g_binding_list_remove(properties, &binding->channel_link);
+    if(g_hash_table_size(properties) == 0)
+        g_hash_table_remove(__bindings_by_channel, binding->registry_channel);
+
+    esconf_g_binding_list_remove(__bindings_by_object, &binding->object_link);
+
+    binding->registered = FALSE;
+}
+
+static EsconfGBinding *
+esconf_g_binding_lookup(gulong id)
+{
+    EsconfGBinding *binding = NULL;
+
+    G_LOCK(__bindings);
+    if(G_LIKELY(__bindings))
+        binding = g_hash_table_lookup(__bindings, GSIZE_TO_POINTER(id));
+    G_UNLOCK(__bindings);
+
+    return binding;
+}
+
+static void
+esconf_g_property_object_write_gdkcolor(EsconfGBinding *binding,
+                                        const GValue *value)
+{
+    FakeGdkColor *color;
     guint16 alpha = 0xffff;
 
-    g_object_get(G_OBJECT(binding->object), binding->object_property, &color, NULL);
+    color = g_value_get_boxed(value);
     if(G_UNLIKELY(!color)) {
         g_warning("Weird, returned GdkColor is NULL");
         return;
     }
 
-    g_signal_handler_block(G_OBJECT(binding->channel), binding->channel_handler);
+    binding->writing = TRUE;
     esconf_channel_set_array(binding->channel, binding->esconf_property,
                              ESCONF_TYPE_UINT16, &color->red,
                              ESCONF_TYPE_UINT16, &color->green,
                              ESCONF_TYPE_UINT16, &color->blue,
                              ESCONF_TYPE_UINT16, &alpha,
                              G_TYPE_INVALID);
-    g_signal_handler_unblock(G_OBJECT(binding->channel), binding->channel_handler);
+    binding->writing = FALSE;
 }
 
 static void
-esconf_g_property_object_notify_gdkrgba(EsconfGBinding *binding)
+esconf_g_property_object_write_gdkrgba(EsconfGBinding *binding,
+                                       const GValue *value)
 {
-    FakeGdkRGBA *color = NULL;
+    FakeGdkRGBA *color;
 
-    g_object_get(G_OBJECT(binding->object), binding->object_property, &color, NULL);
+    color = g_value_get_boxed(value);
     if(G_UNLIKELY(!color)) {
         g_warning("Weird, returned GdkRGBA is NULL");
         return;
     }
 
-    g_signal_handler_block(G_OBJECT(binding->channel), binding->channel_handler);
+    binding->writing = TRUE;
     esconf_channel_set_array(binding->channel, binding->esconf_property,
                              G_TYPE_DOUBLE, &color->red,
                              G_TYPE_DOUBLE, &color->green,
                              G_TYPE_DOUBLE, &color->blue,
                              G_TYPE_DOUBLE, &color->alpha,
                              G_TYPE_INVALID);
-    g_signal_handler_unblock(G_OBJECT(binding->channel), binding->channel_handler);
+    binding->writing = FALSE;
 }
 
+/* writes |src_val|, a value of the object property, to the channel */
 static void
-esconf_g_property_object_notify(GObject *object,
-                                GParamSpec *pspec,
-                                gpointer user_data)
+esconf_g_property_object_write(EsconfGBinding *binding,
+                               const GValue *src_val)
 {
-    EsconfGBinding *binding = user_data;
-    GValue src_val = { 0, };
     GValue dst_val = { 0, };
 
-    g_return_if_fail(G_IS_OBJECT(object));
-    g_return_if_fail(binding->object == object);
-    g_return_if_fail(ESCONF_IS_CHANNEL(binding->channel));
-
-    if(G_PARAM_SPEC_VALUE_TYPE(pspec) == __gdkcolor_gtype) {
+    if(G_VALUE_TYPE(src_val) == __gdkcolor_gtype) {
         /* we need to handle this in a different way */
-        esconf_g_property_object_notify_gdkcolor(binding);
+        esconf_g_property_object_write_gdkcolor(binding, src_val);
         return;
     }
 
-    if(G_PARAM_SPEC_VALUE_TYPE(pspec) == __gdkrgba_gtype) {
+    if(G_VALUE_TYPE(src_val) == __gdkrgba_gtype) {
         /* we need to handle this in a different way */
-        esconf_g_property_object_notify_gdkrgba(binding);
+        esconf_g_property_object_write_gdkrgba(binding, src_val);
         return;
     }
 
     /* this can do auto-conversion for us, but we can't easily tell if
      * the conversion worked */
-    g_value_init(&src_val, G_PARAM_SPEC_VALUE_TYPE(pspec));
-    g_object_get_property(object, g_param_spec_get_name(pspec), &src_val);
-
     g_value_init(&dst_val, binding->esconf_property_type);
-    if(g_value_transform(&src_val, &dst_val)) {
-        g_signal_handler_block(G_OBJECT(binding->channel),
-                               binding->channel_handler);
+    if(g_value_transform(src_val, &dst_val)) {
+        binding->writing = TRUE;
         esconf_channel_set_property(binding->channel,
                                     binding->esconf_property,
                                     &dst_val);
-        g_signal_handler_unblock(G_OBJECT(binding->channel),
-                                 binding->channel_handler);
+        binding->writing = FALSE;
     }
 
     g_value_unset(&dst_val);
+}
+
+static EsconfGBinding *
+esconf_g_binding_ref(EsconfGBinding *binding)
+{
+    g_atomic_int_inc(&binding->ref_count);
+    return binding;
+}
+
+static void
+esconf_g_binding_unref(EsconfGBinding *binding)
+{
+    if(g_atomic_int_dec_and_test(&binding->ref_count)) {
+        g_free(binding->esconf_property);
+        g_free(binding->object_property);
+        g_slice_free(EsconfGBinding, binding);
+    }
+}
+
+static gboolean
+esconf_g_property_throttle_timeout(gpointer user_data)
+{
+    EsconfGBinding *binding = user_data;
+
+    if(G_IS_VALUE(&binding->throttle_value) && binding->channel) {
+        /* write the last value we've seen and wait another interval */
+        esconf_g_property_object_write(binding, &binding->throttle_value);
+        g_value_unset(&binding->throttle_value);
+        return TRUE;
+    }
+
+    /* nothing happened during the last interval */
+    binding->throttle_id = 0;
+
+    return FALSE;
+}
+
+static void
+esconf_g_property_throttle_flush(EsconfGBinding *binding)
+{
+    if(binding->throttle_id != 0) {
+        g_source_remove(binding->throttle_id);
+        binding->throttle_id = 0;
+    }
+
+    if(G_IS_VALUE(&binding->throttle_value)) {
+        if(binding->channel)
+            esconf_g_property_object_write(binding, &binding->throttle_value);
+        g_value_unset(&binding->throttle_value);
+    }
+}
+
+static void
+esconf_g_property_object_notify(GObject *object,
+                                GParamSpec *pspec,
+                                gpointer user_data)
+{
+    EsconfGBinding *binding = user_data;
+    GValue src_val = { 0, };
+
+    g_return_if_fail(G_IS_OBJECT(object));
+    g_return_if_fail(binding->object == object);
+    g_return_if_fail(ESCONF_IS_CHANNEL(binding->channel));
+
+    g_value_init(&src_val, G_PARAM_SPEC_VALUE_TYPE(pspec));
+    g_object_get_property(object, g_param_spec_get_name(pspec), &src_val);
+
+    if(binding->throttle_interval > 0) {
+        if(binding->throttle_id != 0) {
+            /* a write happened recently, remember the value for when
+             * the interval expires */
+            if(G_IS_VALUE(&binding->throttle_value))
+                g_value_unset(&binding->throttle_value);
+            binding->throttle_value = src_val;
+            return;
+        }
+
+        binding->throttle_id = g_timeout_add(binding->throttle_interval,
+                                             esconf_g_property_throttle_timeout,
+                                             binding);
+    }
+
+    esconf_g_property_object_write(binding, &src_val);
+
     g_value_unset(&src_val);
 }
 
@@ -199,24 +439,25 @@ esconf_g_property_object_disconnect(gpointer user_data,
     g_return_if_fail(G_IS_OBJECT(binding->object));
     g_return_if_fail(!binding->channel || ESCONF_IS_CHANNEL(binding->channel));
 
-    /* remove the binding from the internal list */
-    if(G_LIKELY(__bindings)) {
-        G_LOCK(__bindings);
-        __bindings = g_slist_remove(__bindings, binding);
-        G_UNLOCK(__bindings);
-    }
+    /* don't lose the final value of a throttled binding */
+    esconf_g_property_throttle_flush(binding);
+
+    /* remove the binding from the registry */
+    G_LOCK(__bindings);
+    esconf_g_binding_unregister(binding);
+    G_UNLOCK(__bindings);
 
     /* unset the prevent recursing in channel_disconnect */
     binding->object = NULL;
 
-    if(binding->channel) {
+    if(binding->dispatcher)
+        esconf_g_property_dispatcher_remove(binding->dispatcher, binding);
+    else if(binding->channel) {
         g_signal_handler_disconnect(G_OBJECT(binding->channel),
                                     binding->channel_handler);
     }
 
-    g_free(binding->esconf_property);
-    g_free(binding->object_property);
-    g_slice_free(EsconfGBinding, binding);
+    esconf_g_binding_unref(binding);
 }
 
 static void
@@ -286,6 +527,9 @@ esconf_g_property_channel_notify(EsconfChannel *channel,
     g_return_if_fail(binding->channel == channel);
     g_return_if_fail(G_IS_OBJECT(binding->object));
 
+    if(binding->writing)
+        return;
+
    if(__gdkcolor_gtype == binding->esconf_property_type) {
        /* we need to handle this in a different way */
         esconf_g_property_channel_notify_gdkcolor(binding, value);
@@ -358,19 +602,159 @@ esconf_g_property_channel_disconnect(gpointer user_data,
     }
 }
 
-static gulong
-esconf_g_property_init(EsconfChannel *channel,
-                       const gchar *esconf_property,
-                       GType esconf_property_type,
-                       GObject *object,
-                       const gchar *object_property,
-                       GType object_property_type)
+static void
+esconf_g_property_dispatch(EsconfChannel *channel,
+                           const gchar *property,
+                           const GValue *value,
+                           gpointer user_data)
+{
+    EsconfGBindingDispatcher *dispatcher = user_data;
+    GSList *bindings, *l;
+    EsconfGBinding *binding;
+
+    /* copy, a handler could unbind (and free) any of the bindings
+     * while we walk the list */
+    G_LOCK(__dispatchers);
+    bindings = g_slist_copy(g_hash_table_lookup(dispatcher->bindings, property));
+    for(l = bindings; l; l = l->next)
+        esconf_g_binding_ref(l->data);
+    G_UNLOCK(__dispatchers);
+
+    for(l = bindings; l; l = l->next) {
+        binding = l->data;
+
+        /* skip the ones that were unbound in the meantime */
+        if(binding->dispatcher == dispatcher && binding->object)
+            esconf_g_property_channel_notify(channel, property, value, binding);
+
+        esconf_g_binding_unref(binding);
+    }
+
+    g_slist_free(bindings);
+}
+
+static void
+esconf_g_property_dispatcher_disconnect(gpointer user_data,
+                                        GClosure *closure)
+{
+    EsconfGBindingDispatcher *dispatcher = user_data;
+    GHashTableIter iter;
+    gpointer value;
+    GSList *bindings = NULL, *l;
+
+    G_LOCK(__dispatchers);
+    g_object_set_qdata(G_OBJECT(dispatcher->channel), __dispatcher_quark, NULL);
+    g_hash_table_iter_init(&iter, dispatcher->bindings);
+    while(g_hash_table_iter_next(&iter, NULL, &value)) {
+        bindings = g_slist_concat(bindings, value);
+        g_hash_table_iter_steal(&iter);
+    }
+    G_UNLOCK(__dispatchers);
+
+    /* the channel is going away (or we just dropped the last binding):
+     * disconnecting from the objects frees the remaining bindings */
+    for(l = bindings; l; l = l->next) {
+        EsconfGBinding *binding = l->data;
+
+        binding->channel = NULL;
+        binding->dispatcher = NULL;
+        if(binding->object) {
+            g_signal_handler_disconnect(G_OBJECT(binding->object),
+                                        binding->object_handler);
+        }
+    }
+    g_slist_free(bindings);
+
+    g_hash_table_destroy(dispatcher->bindings);
+    g_slice_free(EsconfGBindingDispatcher, dispatcher);
+}
+
+static EsconfGBindingDispatcher *
+esconf_g_property_dispatcher_get(EsconfChannel *channel)
+{
+    EsconfGBindingDispatcher *dispatcher;
+
+    if(G_UNLIKELY(!__dispatcher_quark))
+        __dispatcher_quark = g_quark_from_static_string("esconf-g-binding-dispatcher");
+
+    dispatcher = g_object_get_qdata(G_OBJECT(channel), __dispatcher_quark);
+    if(dispatcher)
+        return dispatcher;
+
+    dispatcher = g_slice_new(EsconfGBindingDispatcher);
+    dispatcher->channel = channel;
+    dispatcher->bindings = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                 NULL, NULL);
+    dispatcher->handler = g_signal_connect_data(G_OBJECT(channel),
+                                                "property-changed",
+                                                G_CALLBACK(esconf_g_property_dispatch),
+                                                dispatcher,
+                                                esconf_g_property_dispatcher_disconnect, 0);
+    g_object_set_qdata(G_OBJECT(channel), __dispatcher_quark, dispatcher);
+
+    return dispatcher;
+}
+
+static void
+esconf_g_property_dispatcher_add(EsconfGBindingDispatcher *dispatcher,
+                                 EsconfGBinding *binding)
+{
+    GSList *bindings;
+
+    binding->dispatcher = dispatcher;
+    binding->channel_handler = dispatcher->handler;
+
+    /* the list is keyed by the binding's own copy of the property
+     * name; when the head changes, so does the key */
+    G_LOCK(__dispatchers);
+    bindings = g_hash_table_lookup(dispatcher->bindings, binding->esconf_property);
+    bindings = g_slist_prepend(bindings, binding);
+    g_hash_table_steal(dispatcher->bindings, binding->esconf_property);
+    g_hash_table_insert(dispatcher->bindings, binding->esconf_property, bindings);
+    G_UNLOCK(__dispatchers);
+}
+
+static void
+esconf_g_property_dispatcher_remove(EsconfGBindingDispatcher *dispatcher,
+                                    EsconfGBinding *binding)
+{
+    GSList *bindings;
+    gboolean empty;
+
+    G_LOCK(__dispatchers);
+    bindings = g_hash_table_lookup(dispatcher->bindings, binding->esconf_property);
+    bindings = g_slist_remove(bindings, binding);
+    g_hash_table_steal(dispatcher->bindings, binding->esconf_property);
+    if(bindings) {
+        g_hash_table_insert(dispatcher->bindings,
+                            ((EsconfGBinding *)bindings->data)->esconf_property,
+                            bindings);
+    }
+    empty = g_hash_table_size(dispatcher->bindings) == 0;
+    G_UNLOCK(__dispatchers);
+
+    binding->dispatcher = NULL;
+
+    /* the last binding is gone, drop the channel handler */
+    if(empty && binding->channel) {
+        g_signal_handler_disconnect(G_OBJECT(binding->channel),
+                                    dispatcher->handler);
+    }
+}
+
+static EsconfGBinding *
+esconf_g_property_binding_new(EsconfChannel *channel,
+                              const gchar *esconf_property,
+                              GType esconf_property_type,
+                              GObject *object,
+                              const gchar *object_property,
+                              GType object_property_type)
 {
     EsconfGBinding *binding;
     gchar *detailed_signal;
-    GValue value = { 0, };
 
-    binding = g_slice_new(EsconfGBinding);
+    binding = g_slice_new0(EsconfGBinding);
+    binding->ref_count = 1;
     binding->channel = channel;
     binding->esconf_property_type = esconf_property_type;
     binding->esconf_property = g_strdup(esconf_property);
@@ -387,6 +771,26 @@ esconf_g_property_init(EsconfChannel *channel,
                                                     esconf_g_property_object_disconnect, 0);
     g_free(detailed_signal);
 
+    return binding;
+}
+
+static gulong
+esconf_g_property_init(EsconfChannel *channel,
+                       const gchar *esconf_property,
+                       GType esconf_property_type,
+                       GObject *object,
+                       const gchar *object_property,
+                       GType object_property_type)
+{
+    EsconfGBinding *binding;
+    gchar *detailed_signal;
+    GValue value = { 0, };
+
+    binding = esconf_g_property_binding_new(channel, esconf_property,
+                                            esconf_property_type, object,
+                                            object_property,
+                                            object_property_type);
+
     /* transfer channel property to the object */
     if(esconf_channel_get_property(channel, esconf_property, &value)) {
         esconf_g_property_channel_notify(channel, esconf_property,
@@ -403,45 +807,99 @@ esconf_g_property_init(EsconfChannel *channel,
                                                      esconf_g_property_channel_disconnect, 0);
     g_free(detailed_signal);
 
-    /* add binding to internal list */
+    /* we use the channel signal id as binding id  */
+    binding->id = binding->channel_handler;
+
+    /* add binding to the registry */
     G_LOCK(__bindings);
-    __bindings = g_slist_prepend(__bindings, binding);
+    esconf_g_binding_register(binding);
     G_UNLOCK(__bindings);
 
-    /* we use the channel signal id as binding id  */
-    return binding->channel_handler;
+    return binding->id;
 }
 
 void
 _esconf_g_bindings_shutdown(void)
 {
-    GSList *bindings, *l;
+    GHashTable *bindings;
+    GHashTableIter iter;
+    gpointer value;
+    GList *list = NULL, *l;
     guint n;
     EsconfGBinding *binding;
 
-    if(G_UNLIKELY(__bindings)) {
-        G_LOCK(__bindings);
-        bindings = __bindings;
-
-        /* don't remove bindings in object disconnect */
-        __bindings = NULL;
+    G_LOCK(__bindings);
+    bindings = __bindings;
+    __bindings = NULL;
+    if(bindings) {
+        g_hash_table_destroy(__bindings_by_channel);
+        __bindings_by_channel = NULL;
+        g_hash_table_destroy(__bindings_by_object);
+        __bindings_by_object = NULL;
+
+        g_hash_table_iter_init(&iter, bindings);
+        while(g_hash_table_iter_next(&iter, NULL, &value)) {
+            binding = value;
+            binding->registered = FALSE;
+            list = g_list_prepend(list, binding);
+        }
+        g_hash_table_destroy(bindings);
+    }
+    G_UNLOCK(__bindings);
 
+    if(G_UNLIKELY(list)) {
         /* remove all the remaining bindings */
-        for(l = bindings, n = 0; l; l = g_slist_next(l), n++) {
+        for(l = list, n = 0; l; l = l->next, n++) {
             binding = l->data;
             g_signal_handler_disconnect(G_OBJECT(binding->object),
                                         binding->object_handler);
         }
-        g_slist_free(bindings);
+        g_list_free(list);
 
 #ifndef NDEBUG
         /* scare the developer a bit */
         g_debug("%d esconf binding(s) are still connected. Are you sure all esconf "
                 "channels are released before calling esconf_shutdown()?", n);
 #endif
+    }
+}
 
-        G_UNLOCK(__bindings);
+/* returns the type of |object_property|, or G_TYPE_INVALID if it
+ * can't be bound to an esconf property of |esconf_property_type| */
+static GType
+esconf_g_property_check(GType esconf_property_type,
+                        GObject *object,
+                        const gchar *object_property)
+{
+    GParamSpec *pspec;
+
+    pspec = g_object_class_find_property(G_OBJECT_GET_CLASS(object),
+                                         object_property);
+    if(G_UNLIKELY(!pspec)) {
+        g_warning("Property \"%s\" is not valid for GObject type \"%s\"",
+                  object_property, G_OBJECT_TYPE_NAME(object));
+        return G_TYPE_INVALID;
     }
+
+    if(G_UNLIKELY(!g_value_type_transformable(esconf_property_type,
+                                              G_PARAM_SPEC_VALUE_TYPE(pspec))))
+    {
+        g_warning("Converting from type \"%s\" to type \"%s\" is not supported",
+                  g_type_name(esconf_property_type),
+                  g_type_name(G_PARAM_SPEC_VALUE_TYPE(pspec)));
+        return G_TYPE_INVALID;
+    }
+
+    if(G_UNLIKELY(!g_value_type_transformable(G_PARAM_SPEC_VALUE_TYPE(pspec),
+                                              esconf_property_type)))
+    {
+        g_warning("Converting from type \"%s\" to type \"%s\" is not supported",
+                  g_type_name(G_PARAM_SPEC_VALUE_TYPE(pspec)),
+                  g_type_name(esconf_property_type));
+        return G_TYPE_INVALID;
+    }
+
+    return G_PARAM_SPEC_VALUE_TYPE(pspec);
 }
 
 /**
@@ -471,7 +929,7 @@ esconf_g_property_bind(EsconfChannel *channel,
                        gpointer object,
                        const gchar *object_property)
 {
-    GParamSpec *pspec;
+    GType object_property_type;
 
     g_return_val_if_fail(ESCONF_IS_CHANNEL(channel), 0UL);
     g_return_val_if_fail(esconf_property && *esconf_property == '/', 0UL);
@@ -480,36 +938,194 @@ esconf_g_property_bind(EsconfChannel *channel,
     g_return_val_if_fail(G_IS_OBJECT(object), 0UL);
     g_return_val_if_fail(object_property && *object_property != '\0', 0UL);
 
-    pspec = g_object_class_find_property(G_OBJECT_GET_CLASS(object),
-                                         object_property);
-    if(G_UNLIKELY(!pspec)) {
-        g_warning("Property \"%s\" is not valid for GObject type \"%s\"",
-                  object_property, G_OBJECT_TYPE_NAME(object));
+    object_property_type = esconf_g_property_check(esconf_property_type,
+                                                   G_OBJECT(object),
+                                                   object_property);
+    if(G_UNLIKELY(object_property_type == G_TYPE_INVALID))
         return 0UL;
-    }
 
-    if(G_UNLIKELY(!g_value_type_transformable(esconf_property_type,
-                                              G_PARAM_SPEC_VALUE_TYPE(pspec))))
-    {
-        g_warning("Converting from type \"%s\" to type \"%s\" is not supported",
-                  g_type_name(esconf_property_type),
-                  g_type_name(G_PARAM_SPEC_VALUE_TYPE(pspec)));
-        return 0UL;
+    return esconf_g_property_init(channel, esconf_property,
+                                  esconf_property_type, G_OBJECT(object),
+                                  object_property, object_property_type);
+}
+
+/* returns the deepest property path that is a parent of (or equal
+ * to) all the esconf properties in |entries|, so that one
+ * GetAllProperties call covers them all; invalid properties are
+ * skipped, esconf_g_property_bind_many() warns about those */
+static gchar *
+esconf_g_property_common_base(const EsconfGPropertyBindEntry *entries,
+                              guint n_entries)
+{
+    const gchar *first = NULL;
+    gsize len = 0;
+    guint i;
+
+    for(i = 0; i < n_entries; ++i) {
+        const gchar *prop = entries[i].esconf_property;
+        gsize j;
+
+        if(!prop || *prop != '/')
+            continue;
+
+        if(!first) {
+            first = prop;
+            len = strlen(first);
+            continue;
+        }
+
+        for(j = 0; j < len && prop[j] == first[j]; ++j);
+        len = j;
     }
 
-    if(G_UNLIKELY(!g_value_type_transformable(G_PARAM_SPEC_VALUE_TYPE(pspec),
-                                              esconf_property_type)))
-    {
-        g_warning("Converting from type \"%s\" to type \"%s\" is not supported",
-                  g_type_name(G_PARAM_SPEC_VALUE_TYPE(pspec)),
-                  g_type_name(esconf_property_type));
-        return 0UL;
+    /* cut back to a complete parent path */
+    while(len > 0 && first[len] != '/')
+        --len;
+
+    if(len <= 1)
+        return NULL;
+
+    return g_strndup(first, len);
+}
+
+/**
+ * EsconfGPropertyBindEntry:
+ * @esconf_property: A property on the channel.
+ * @esconf_property_type: The type of @esconf_property.
+ * @object: A #GObject.
+ * @object_property: A valid property on @object.
+ *
+ * Describes one binding for esconf_g_property_bind_many().  The
+ * fields have the same meaning as the arguments of
+ * esconf_g_property_bind().
+ *
+ * Since: 1.0.0
+ **/
+
+/**
+ * esconf_g_property_bind_many:
+ * @channel: An #EsconfChannel.
+ * @entries: (array length=n_entries): The bindings to create.
+ * @n_entries: The number of elements in @entries.
+ * @ids: (out caller-allocates) (array length=n_entries) (allow-none):
+ *       Return location for the binding IDs, or %NULL.
+ *
+ * Creates several bindings on @channel at once, as if
+ * esconf_g_property_bind() was called for each element of @entries.
+ *
+ * This is considerably cheaper than binding the properties one by
+ * one: the initial values of all properties are fetched from the
+ * Esconf daemon with a single call, and changes on @channel are
+ * routed to the bindings by a single signal handler instead of one
+ * handler per binding.  Use it for settings dialogs with many bound
+ * widgets.
+ *
+ * If @ids is not %NULL, the ID of each binding is stored at the
+ * corresponding index, or 0 if that binding could not be created.
+ * The IDs can be passed to esconf_g_property_unbind().
+ *
+ * Returns: The number of bindings that were created.
+ *
+ * Since: 1.0.0
+ **/
+guint
+esconf_g_property_bind_many(EsconfChannel *channel,
+                            const EsconfGPropertyBindEntry *entries,
+                            guint n_entries,
+                            gulong *ids)
+{
+    EsconfGBindingDispatcher *dispatcher;
+    GHashTable *values;
+    const gchar *property_base;
+    gchar *base;
+    guint i, n_bound = 0;
+
+    g_return_val_if_fail(ESCONF_IS_CHANNEL(channel), 0);
+    g_return_val_if_fail(entries != NULL || n_entries == 0, 0);
+
+    if(ids)
+        memset(ids, 0, sizeof(gulong) * n_entries);
+
+    if(!n_entries)
+        return 0;
+
+    /* prime all bindings with one fetch; a property missing from the
+     * result is simply unset, no need to ask for it again */
+    base = esconf_g_property_common_base(entries, n_entries);
+    values = esconf_channel_get_properties(channel, base);
+    g_free(base);
+
+    property_base = _esconf_channel_get_property_base(channel);
+    dispatcher = esconf_g_property_dispatcher_get(channel);
+
+    for(i = 0; i < n_entries; ++i) {
+        const EsconfGPropertyBindEntry *entry = &entries[i];
+        EsconfGBinding *binding;
+        GType object_property_type;
+        const GValue *value = NULL;
+
+        if(G_UNLIKELY(!entry->esconf_property || *entry->esconf_property != '/'
+                      || entry->esconf_property_type == G_TYPE_NONE
+                      || entry->esconf_property_type == G_TYPE_INVALID
+                      || !G_IS_OBJECT(entry->object)
+                      || !entry->object_property || !*entry->object_property))
+        {
+            g_warning("Invalid binding at index %u", i);
+            continue;
+        }
+
+        object_property_type = esconf_g_property_check(entry->esconf_property_type,
+                                                       G_OBJECT(entry->object),
+                                                       entry->object_property);
+        if(G_UNLIKELY(object_property_type == G_TYPE_INVALID))
+            continue;
+
+        binding = esconf_g_property_binding_new(channel,
+                                                entry->esconf_property,
+                                                entry->esconf_property_type,
+                                                G_OBJECT(entry->object),
+                                                entry->object_property,
+                                                object_property_type);
+
+        if(values) {
+            if(property_base) {
+                gchar *real_property = g_strconcat(property_base,
+                                                   entry->esconf_property,
+                                                   NULL);
+                value = g_hash_table_lookup(values, real_property);
+                g_free(real_property);
+            } else
+                value = g_hash_table_lookup(values, entry->esconf_property);
+        }
+
+        if(value) {
+            esconf_g_property_channel_notify(channel, entry->esconf_property,
+                                             value, binding);
+        }
+
+        esconf_g_property_dispatcher_add(dispatcher, binding);
+
+        /* all these bindings share the channel handler, so use the
+         * (globally unique) object handler id instead */
+        binding->id = binding->object_handler;
+
+        G_LOCK(__bindings);
+        esconf_g_binding_register(binding);
+        G_UNLOCK(__bindings);
+
+        if(ids)
+            ids[i] = binding->id;
+        ++n_bound;
     }
 
-    return esconf_g_property_init(channel, esconf_property,
-                                  esconf_property_type, G_OBJECT(object),
-                                  object_property,
-                                  G_PARAM_SPEC_VALUE_TYPE(pspec));
+    if(values)
+        g_hash_table_destroy(values);
+
+    /* don't keep an idle handler around if nothing could be bound */
+    if(!n_bound && g_hash_table_size(dispatcher->bindings) == 0)
+        g_signal_handler_disconnect(G_OBJECT(channel), dispatcher->handler);
+
+    return n_bound;
 }
 
 /**
@@ -639,6 +1255,45 @@ esconf_g_property_bind_gdkrgba(EsconfChannel *channel,
                                   object_property, __gdkrgba_gtype);
 }
 
+/**
+ * esconf_g_property_set_throttle:
+ * @id: A binding ID number.
+ * @interval: The minimum time between two writes in milliseconds,
+ *            or 0 to write every change.
+ *
+ * Limits how often changes of the bound #GObject property are written
+ * to the channel.  The first change is written immediately; changes
+ * that follow within @interval milliseconds are collapsed and only the
+ * most recent value is written when the interval expires.  The last
+ * value is also written when the binding is removed, so the channel
+ * always ends up with the final value of the object property.
+ *
+ * This is useful for properties of interactive controls, like the
+ * value of a scale, that change at a very high rate while the user
+ * is dragging.  Changes from the channel to the object are not
+ * affected.
+ *
+ * Since: 1.0.0
+ **/
+void
+esconf_g_property_set_throttle(gulong id,
+                               guint interval)
+{
+    EsconfGBinding *binding;
+
+    binding = esconf_g_binding_lookup(id);
+    if(G_UNLIKELY(!binding)) {
+        g_warning("No binding with id %ld was found", id);
+        return;
+    }
+
+    binding->throttle_interval = interval;
+
+    /* write what we're holding back if throttling gets disabled */
+    if(interval == 0)
+        esconf_g_property_throttle_flush(binding);
+}
+
 /**
  * esconf_g_property_unbind:
  * @id: A binding ID number.
@@ -649,19 +1304,10 @@ esconf_g_property_bind_gdkrgba(EsconfChannel *channel,
 void
 esconf_g_property_unbind(gulong id)
 {
-    GSList *l;
     EsconfGBinding *binding;
 
-    G_LOCK(__bindings);
-    for(l = __bindings; l; l = g_slist_next(l)) {
-        binding = l->data;
-        if(G_UNLIKELY(binding->channel_handler == id))
-            break;
-    }
-    G_UNLOCK(__bindings);
-
-    if(G_LIKELY(l)) {
-        binding = l->data;
+    binding = esconf_g_binding_lookup(id);
+    if(G_LIKELY(binding)) {
         g_signal_handler_disconnect(G_OBJECT(binding->object),
                                     binding->object_handler);
     } else {
@@ -685,27 +1331,34 @@ esconf_g_property_unbind_by_property(EsconfChannel *channel,
                                      gpointer object,
                                      const gchar *object_property)
 {
-    GSList *l;
-    EsconfGBinding *binding;
+    GHashTable *properties;
+    GList *l = NULL;
+    EsconfGBinding *binding = NULL;
 
     g_return_if_fail(ESCONF_IS_CHANNEL(channel));
     g_return_if_fail(esconf_property && *esconf_property == '/');
     g_return_if_fail(G_IS_OBJECT(object));
     g_return_if_fail(object_property && *object_property != '\0');
 
+    /* only look at the bindings of this channel property, usually
+     * there is just one */
     G_LOCK(__bindings);
-    for(l = __bindings; l; l = g_slist_next(l)) {
-        binding = l->data;
-        if(binding->object == object
-           && binding->channel == channel
-           && !strcmp(esconf_property, binding->esconf_property)
-           && !strcmp(object_property, binding->object_property))
+    if(G_LIKELY(__bindings_by_channel)) {
+        properties = g_hash_table_lookup(__bindings_by_channel, channel);
+        if(properties)
+            l = g_hash_table_lookup(properties, esconf_property);
+    }
+    for(; l; l = l->next) {
+        if(((EsconfGBinding *)l->data)->object == object
+           && !strcmp(object_property, ((EsconfGBinding *)l->data)->object_property))
+        {
+            binding = l->data;
             break;
+        }
     }
     G_UNLOCK(__bindings);
 
-    if(G_LIKELY(l)) {
-        binding = l->data;
+    if(G_LIKELY(binding)) {
         g_signal_handler_disconnect(G_OBJECT(binding->object),
                                     binding->object_handler);
     } else {
@@ -726,21 +1379,48 @@ esconf_g_property_unbind_by_property(EsconfChannel *channel,
 void
 esconf_g_property_unbind_all(gpointer channel_or_object)
 {
-    guint n;
+    GList *bindings = NULL, *l;
+    guint n = 0;
 
     g_return_if_fail(G_IS_OBJECT(channel_or_object));
 
+    /* copy, disconnecting unregisters the bindings */
+    G_LOCK(__bindings);
     if(ESCONF_IS_CHANNEL(channel_or_object)) {
-        n = g_signal_handlers_disconnect_matched(channel_or_object, G_SIGNAL_MATCH_FUNC,
-                                                 0, 0, NULL,
-                                                 esconf_g_property_channel_notify,
-                                                 NULL);
+        GHashTable *properties = NULL;
+        GHashTableIter iter;
+        gpointer value;
+
+        if(G_LIKELY(__bindings_by_channel))
+            properties = g_hash_table_lookup(__bindings_by_channel, channel_or_object);
+        if(properties) {
+            g_hash_table_iter_init(&iter, properties);
+            while(g_hash_table_iter_next(&iter, NULL, &value)) {
+                for(l = value; l; l = l->next)
+                    bindings = g_list_prepend(bindings, esconf_g_binding_ref(l->data));
+            }
+        }
     } else {
-        n = g_signal_handlers_disconnect_matched(channel_or_object, G_SIGNAL_MATCH_FUNC,
-                                                 0, 0, NULL,
-                                                 esconf_g_property_object_notify,
-                                                 NULL);
+        l = NULL;
+        if(G_LIKELY(__bindings_by_object))
+            l = g_hash_table_lookup(__bindings_by_object, channel_or_object);
+        for(; l; l = l->next)
+            bindings = g_list_prepend(bindings, esconf_g_binding_ref(l->data));
+    }
+    G_UNLOCK(__bindings);
+
+    for(l = bindings; l; l = l->next) {
+        EsconfGBinding *binding = l->data;
+
+        /* the object disconnect closure frees the binding data */
+        if(binding->object) {
+            g_signal_handler_disconnect(G_OBJECT(binding->object),
+                                        binding->object_handler);
+            ++n;
+        }
+        esconf_g_binding_unref(binding);
     }
+    g_list_free(bindings);
 
     if(G_UNLIKELY(!n)) {
         g_warning("No bindings were found on the %s",
@@ -30,6 +30,16 @@
 
 G_BEGIN_DECLS
 
+typedef struct _EsconfGPropertyBindEntry EsconfGPropertyBindEntry;
+
+struct _EsconfGPropertyBindEntry
+{
+    const gchar *esconf_property;
+    GType esconf_property_type;
+    gpointer object;
+    const gchar *object_property;
+};
+
 gulong esconf_g_property_bind(EsconfChannel *channel,
                               const gchar *esconf_property,
                               GType esconf_property_type,
@@ -46,6 +56,14 @@ gulong esconf_g_property_bind_gdkrgba(EsconfChannel *channel,
                                       gpointer object,
                                       const gchar *object_property);
 
+guint esconf_g_property_bind_many(EsconfChannel *channel,
+                                  const EsconfGPropertyBindEntry *entries,
+                                  guint n_entries,
+                                  gulong *ids);
+
+void esconf_g_property_set_throttle(gulong id,
+                                    guint interval);
+
 void esconf_g_property_unbind(gulong id);
 
 void esconf_g_property_unbind_by_property(EsconfChannel *channel,
@@ -51,20 +51,46 @@
 
 
 
+/* lock order: cache_lock before properties_lock.  readers only ever
+ * take properties_lock, and only long enough to look up and ref an
+ * item; neither lock is held while waiting on the daemon. */
 #define esconf_cache_mutex_lock(cache)   g_mutex_lock (&(cache)->cache_lock)
 #define esconf_cache_mutex_unlock(cache) g_mutex_unlock (&(cache)->cache_lock)
 
+#define esconf_cache_read_lock(cache)    g_rw_lock_reader_lock (&(cache)->properties_lock)
+#define esconf_cache_read_unlock(cache)  g_rw_lock_reader_unlock (&(cache)->properties_lock)
+#define esconf_cache_write_lock(cache)   g_rw_lock_writer_lock (&(cache)->properties_lock)
+#define esconf_cache_write_unlock(cache) g_rw_lock_writer_unlock (&(cache)->properties_lock)
+
 
 
 /**************** EsconfCacheItem ****************/
 
 
+/* items are immutable once they are in the cache: a change to a
+ * property publishes a new item and retires the old one.  retired
+ * items are only released once the next change notification has been
+ * dispatched on the cache's main context (see esconf_cache_retire()),
+ * which lets esconf_cache_peek() hand out pointers into the cached
+ * value without copying it, to any thread.
+ *
+ * the same goes for array values: the GPtrArray owns its values
+ * (it has a free func) and is never modified after the item has been
+ * created, so readers inside libesconf share it by taking a reference
+ * (see esconf_cache_lookup_shared()); it's only copied when it is
+ * handed out to an application as a mutable array. */
 typedef struct
 {
 #if 0
     GTimeVal last_used;
 #endif
+    gint ref_count;
     GValue *value;
+    /* lazily built NULL-terminated view of a string array; the
+     * strings themselves are owned by |value| */
+    gchar **strv;
+    /* lazily computed _esconf_gvalue_hash() of |value|, 0 if unknown */
+    gint hash;
 } EsconfCacheItem;
 
 static EsconfCacheItem *
@@ -76,6 +102,7 @@ esconf_cache_item_new(const GValue *value,
     g_return_val_if_fail(value, NULL);
 
     item = g_slice_new0(EsconfCacheItem);
+    item->ref_count = 1;
 #if 0
     g_get_current_time(&item->last_used);
 #endif
@@ -98,42 +125,127 @@ esconf_cache_item_new(const GValue *value,
     return item;
 }
 
+static EsconfCacheItem *
+esconf_cache_item_ref(EsconfCacheItem *item)
+{
+    g_atomic_int_inc(&item->ref_count);
+    return item;
+}
+
+static void
+esconf_cache_item_unref(EsconfCacheItem *item)
+{
+    g_return_if_fail(item);
+
+    if(!g_atomic_int_dec_and_test(&item->ref_count))
+        return;
+
+    g_free(item->strv);
+    g_value_unset(item->value);
+    g_free(item->value);
+    g_slice_free(EsconfCacheItem, item);
+}
+
 static gboolean
-esconf_cache_item_update(EsconfCacheItem *item,
-                         const GValue *value)
+esconf_cache_item_value_equal(EsconfCacheItem *item,
+                              const GValue *value)
 {
-    if(value && _esconf_gvalue_is_equal(item->value, value))
-        return FALSE;
+    /* for arrays, compare content hashes first: the item's hash is
+     * computed once and kept, so a differing array usually gets
+     * rejected without walking both arrays element by element */
+    if(G_VALUE_TYPE(item->value) == G_TYPE_PTR_ARRAY
+       && G_VALUE_TYPE(value) == G_TYPE_PTR_ARRAY)
+    {
+        guint hash = (guint)g_atomic_int_get(&item->hash);
 
-#if 0
-    g_get_current_time(&item->last_used);
-#endif
+        if(!hash) {
+            hash = _esconf_gvalue_hash(item->value);
+            g_atomic_int_set(&item->hash, (gint)hash);
+        }
 
-    if(value) {
-        g_value_unset(item->value);
-        g_value_init(item->value, G_VALUE_TYPE(value));
+        if(hash != _esconf_gvalue_hash(value))
+            return FALSE;
+    }
 
-        /* We need to dup the array */
-        if (G_VALUE_TYPE(value) == G_TYPE_PTR_ARRAY) {
-            GPtrArray *arr = esconf_dup_value_array(g_value_get_boxed(value), TRUE);
-            g_value_take_boxed(item->value, arr);
-        } else {
-            g_value_copy(value, item->value);
+    return _esconf_gvalue_is_equal(item->value, value);
+}
+
+static const gchar * const *
+esconf_cache_item_get_strv(EsconfCacheItem *item)
+{
+    GPtrArray *arr;
+    gchar **strv;
+    guint i;
+
+    strv = g_atomic_pointer_get(&item->strv);
+    if(strv)
+        return (const gchar * const *)strv;
+
+    if(G_VALUE_TYPE(item->value) != G_TYPE_PTR_ARRAY)
+        return NULL;
+
+    arr = g_value_get_boxed(item->value);
+    strv = g_new(gchar *, arr->len + 1);
+    for(i = 0; i < arr->len; ++i) {
+        GValue *val = g_ptr_array_index(arr, i);
+
+        if(G_VALUE_TYPE(val) != G_TYPE_STRING) {
+            g_free(strv);
+            return NULL;
         }
-        return TRUE;
+
+        strv[i] = (gchar *)g_value_get_string(val);
     }
+    strv[i] = NULL;
 
-    return FALSE;
+    /* readers may race to build the view; the first one wins */
+    if(!g_atomic_pointer_compare_and_exchange(&item->strv, NULL, strv))
+        g_free(strv);
+
+    return (const gchar * const *)g_atomic_pointer_get(&item->strv);
+}
+
+
+
+/**************** EsconfCacheFetch ****************/
+
+
+/* a GetProperty call in flight for a cache miss.  other threads
+ * missing on the same property wait on |cond| for the result instead
+ * of issuing their own call.  all fields are protected by the cache's
+ * cache_lock. */
+typedef struct
+{
+    gint ref_count;
+    gboolean done;
+    GCond cond;
+    EsconfCacheItem *item;
+    GError *error;
+} EsconfCacheFetch;
+
+static EsconfCacheFetch *
+esconf_cache_fetch_new(void)
+{
+    EsconfCacheFetch *fetch = g_slice_new0(EsconfCacheFetch);
+
+    fetch->ref_count = 1;
+    g_cond_init(&fetch->cond);
+
+    return fetch;
 }
 
 static void
-esconf_cache_item_free(EsconfCacheItem *item)
+esconf_cache_fetch_unref(EsconfCacheFetch *fetch)
 {
-    g_return_if_fail(item);
+    if(--fetch->ref_count > 0)
+        return;
 
-    g_value_unset(item->value);
-    g_free(item->value);
-    g_slice_free(EsconfCacheItem, item);
+    if(fetch->item)
+        esconf_cache_item_unref(fetch->item);
+    if(fetch->error)
+        g_error_free(fetch->error);
+    g_cond_clear(&fetch->cond);
+    g_slice_free(EsconfCacheFetch, fetch);
 }
 
 
@@ -199,7 +311,7 @@ esconf_cache_old_item_free(EsconfCacheOldItem *old_item)
         g_variant_unref (old_item->variant);
 
     if(old_item->item)
-        esconf_cache_item_free(old_item->item);
+        esconf_cache_item_unref(old_item->item);
 
     g_slice_free(EsconfCacheOldItem, old_item);
 }
@@ -238,6 +350,36 @@ esconf_cache_old_item_end_call(gpointer key,
 }
 
 
+/**************** EsconfCacheArrayOp ****************/
+
+
+/* an element-level array change we made ourselves.  the daemon
+ * announces it with ArrayChanged before our call returns, so by the
+ * time we've applied it locally, its echo is already queued behind
+ * any change that happened before it. */
+typedef struct
+{
+    EsconfArrayChange change;
+    guint index;
+    GValue *value;
+} EsconfCacheArrayOp;
+
+static void
+esconf_cache_array_op_free(EsconfCacheArrayOp *op)
+{
+    if(op->value)
+        _esconf_gvalue_free(op->value);
+    g_slice_free(EsconfCacheArrayOp, op);
+}
+
+static void
+esconf_cache_array_ops_free(gpointer data)
+{
+    g_queue_free_full(data, (GDestroyNotify)esconf_cache_array_op_free);
+}
+
+
+
 /************************* EsconfCache ********************/
 
 
@@ -258,9 +400,18 @@ struct _EsconfCache
 #endif
 
     GTree *properties;
+    GRWLock properties_lock;
 
     GHashTable *pending_calls;
     GHashTable *old_properties;
+    GHashTable *fetches;
+    /* property -> GQueue of EsconfCacheArrayOp we applied locally and
+     * expect to see again in ArrayChanged */
+    GHashTable *array_ops;
+
+    /* items that were replaced or evicted since the last change
+     * notification was dispatched; protected by properties_lock */
+    GPtrArray *retired;
 
     gint g_signal_id;
 
@@ -308,6 +459,9 @@ static void esconf_cache_proxy_signal_received_cb(GDBusProxy *proxy,
                                                   gchar      *signal_name,
                                                   GVariant   *parameters,
                                                   gpointer    user_data);
+static EsconfCacheItem *esconf_cache_lookup_item(EsconfCache *cache,
+                                                 const gchar *property,
+                                                 GError **error);
 
 
 static guint signals[N_SIGS] = { 0, };
@@ -386,13 +540,20 @@ esconf_cache_init(EsconfCache *cache)
 
     cache->properties = g_tree_new_full((GCompareDataFunc) (void (*)(void)) strcmp, NULL,
                                         (GDestroyNotify)g_free,
-                                        (GDestroyNotify)esconf_cache_item_free);
+                                        (GDestroyNotify)esconf_cache_item_unref);
 
     cache->pending_calls = g_hash_table_new_full(g_direct_hash, g_direct_equal,
                                                  NULL, NULL);
     cache->old_properties = g_hash_table_new_full(g_str_hash, g_str_equal,
                                                   NULL, NULL);
-
+    cache->fetches = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                           (GDestroyNotify)g_free, NULL);
+    cache->array_ops = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                             (GDestroyNotify)g_free,
+                                             esconf_cache_array_ops_free);
+    cache->retired = g_ptr_array_new_with_free_func((GDestroyNotify)esconf_cache_item_unref);
+
+    g_rw_lock_init (&cache->properties_lock);
     g_mutex_init (&cache->cache_lock);
 }
 
@@ -479,16 +640,101 @@ esconf_cache_finalize(GObject *obj)
 
     g_tree_destroy(cache->properties);
     g_hash_table_destroy(cache->old_properties);
+    g_hash_table_destroy(cache->fetches);
+    g_hash_table_destroy(cache->array_ops);
+    g_ptr_array_free(cache->retired, TRUE);
+
+    g_rw_lock_clear(&cache->properties_lock);
+    g_mutex_clear(&cache->cache_lock);
 
     G_OBJECT_CLASS(esconf_cache_parent_class)->finalize(obj);
 }
 
 
+/* returns a new reference to the current version of |property|, or
+ * NULL if it is not cached */
+static EsconfCacheItem *
+esconf_cache_get_item(EsconfCache *cache,
+                      const gchar *property)
+{
+    EsconfCacheItem *item;
+
+    esconf_cache_read_lock(cache);
+    item = g_tree_lookup(cache->properties, property);
+    if(item)
+        esconf_cache_item_ref(item);
+    esconf_cache_read_unlock(cache);
+
+    return item;
+}
+
+/* takes over a reference to |item|, an item that is no longer in the
+ * tree.  pointers peeked from it stay valid until the next change
+ * notification has been dispatched on the main context of the cache,
+ * when esconf_cache_proxy_signal_received_cb() releases it.  called
+ * with the write lock held. */
+static void
+esconf_cache_retire_locked(EsconfCache *cache,
+                           EsconfCacheItem *item)
+{
+    g_ptr_array_add(cache->retired, item);
+}
+
+static void
+esconf_cache_retire(EsconfCache *cache,
+                    EsconfCacheItem *item)
+{
+    esconf_cache_write_lock(cache);
+    esconf_cache_retire_locked(cache, item);
+    esconf_cache_write_unlock(cache);
+}
+
+/* evicts |property| and retires its item; called with the write lock
+ * held */
+static void
+esconf_cache_evict_locked(EsconfCache *cache,
+                          const gchar *property)
+{
+    EsconfCacheItem *item = g_tree_lookup(cache->properties, property);
+
+    if(item) {
+        esconf_cache_retire_locked(cache, esconf_cache_item_ref(item));
+        g_tree_remove(cache->properties, property);
+    }
+}
+
+/* publishes |item| as the current version of |property|, or evicts
+ * the property if |item| is NULL.  the previous version (if any) is
+ * returned with a reference held; the caller hands it to
+ * esconf_cache_retire() once it has emitted the change notification. */
+static EsconfCacheItem *
+esconf_cache_replace_item(EsconfCache *cache,
+                          const gchar *property,
+                          EsconfCacheItem *item)
+{
+    EsconfCacheItem *old;
+
+    esconf_cache_write_lock(cache);
+
+    old = g_tree_lookup(cache->properties, property);
+    if(old)
+        esconf_cache_item_ref(old);
+
+    if(item)
+        g_tree_insert(cache->properties, g_strdup(property), item);
+    else if(old)
+        g_tree_remove(cache->properties, property);
+
+    esconf_cache_write_unlock(cache);
+
+    return old;
+}
+
 static void
 esconf_cache_handle_property_changed (EsconfCache *cache, GVariant *parameters)
 {
 
-    EsconfCacheItem *item;
+    EsconfCacheItem *item, *old = NULL;
     const gchar *channel_name, *property;
     GVariant *prop_variant;
     GValue *prop_value;
@@ -505,22 +751,37 @@ esconf_cache_handle_property_changed (EsconfCache *cache, GVariant *parameters)
          * that value, in that case, abort the emission of the signal. we can
          * detect this because the new reply is not processed yet and thus
          * there is still an old_prop in the hash table */
-        if(g_hash_table_lookup(cache->old_properties, property))
-            return;
+        esconf_cache_mutex_lock(cache);
 
-        item = g_tree_lookup(cache->properties, property);
-        if(item) {
-            changed = esconf_cache_item_update(item, prop_value);
+        if(g_hash_table_lookup(cache->old_properties, property)) {
+            esconf_cache_mutex_unlock(cache);
+            _esconf_gvalue_free(prop_value);
+            g_variant_unref(prop_variant);
+            return;
         }
-        else {
+
+        item = esconf_cache_get_item(cache, property);
+        if(item && esconf_cache_item_value_equal(item, prop_value)) {
+            _esconf_gvalue_free(prop_value);
+            changed = FALSE;
+        } else {
+            if(item)
+                esconf_cache_item_unref(item);
             item = esconf_cache_item_new(prop_value, TRUE);
-            g_tree_insert(cache->properties, g_strdup(property), item);
+            old = esconf_cache_replace_item(cache, property,
+                                            esconf_cache_item_ref(item));
         }
 
+        esconf_cache_mutex_unlock(cache);
+
         if(changed) {
             g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED], 0,
-                          cache->channel_name, property, prop_value);
+                          cache->channel_name, property, item->value);
         }
+        if(item)
+            esconf_cache_item_unref(item);
+        if(old)
+            esconf_cache_retire(cache, old);
         g_variant_unref(prop_variant);
     }
     else {
@@ -537,17 +798,24 @@ esconf_cache_handle_property_removed (EsconfCache *cache, GVariant *parameters)
 
     const gchar *channel_name, *property;
     GValue value = G_VALUE_INIT;
+    EsconfCacheItem *old;
     if (g_variant_is_of_type(parameters, G_VARIANT_TYPE ("(ss)"))) {
         g_variant_get(parameters, "(&s&s)", &channel_name, &property);
 
         if(strcmp(channel_name, cache->channel_name))
             return;
 
-        g_tree_remove(cache->properties, property);
+        /* keep the removed item alive until handlers have run */
+        esconf_cache_mutex_lock(cache);
+        old = esconf_cache_replace_item(cache, property, NULL);
+        esconf_cache_mutex_unlock(cache);
 
         g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED], 0,
                       cache->channel_name, property, &value);
 
+        if(old)
+            esconf_cache_retire(cache, old);
+
     }
     else {
         g_warning("property removed handler expects (ss) type, but %s received",
@@ -557,6 +825,134 @@ esconf_cache_handle_property_removed (EsconfCache *cache, GVariant *parameters)
 }
 
 
+/* applies an element-level change to the cached array and returns the
+ * new item, or NULL if the property isn't cached or the change doesn't
+ * apply.  the replaced item is returned in |old_item|, the caller
+ * retires it once property-changed has been emitted; called with the
+ * mutex held */
+static EsconfCacheItem *
+esconf_cache_apply_array_change(EsconfCache *cache,
+                                const gchar *property,
+                                EsconfArrayChange change,
+                                guint index,
+                                const GValue *value,
+                                EsconfCacheItem **old_item)
+{
+    EsconfCacheItem *item, *new_item = NULL;
+    GPtrArray *arr;
+
+    *old_item = NULL;
+
+    item = esconf_cache_get_item(cache, property);
+    if(!item)
+        return NULL;
+
+    /* the cached array is shared, so this makes a new one */
+    if(G_VALUE_TYPE(item->value) == G_TYPE_PTR_ARRAY
+       && (arr = esconf_value_array_apply_change(g_value_get_boxed(item->value),
+                                                 change, index, value)))
+    {
+        GValue *new_value = g_new0(GValue, 1);
+
+        g_value_init(new_value, G_TYPE_PTR_ARRAY);
+        g_value_take_boxed(new_value, arr);
+        new_item = esconf_cache_item_new(new_value, TRUE);
+    }
+
+    /* on a mismatch, drop the entry, the next read gets it again */
+    *old_item = esconf_cache_replace_item(cache, property,
+                                          new_item ? esconf_cache_item_ref(new_item) : NULL);
+    esconf_cache_item_unref(item);
+
+    return new_item;
+}
+
+static void
+esconf_cache_handle_array_changed (EsconfCache *cache, GVariant *parameters)
+{
+    const gchar *channel_name, *property;
+    GVariant *variant;
+    guint change, index;
+    GValue *value = NULL;
+    GQueue *ops;
+    EsconfCacheItem *item = NULL, *old = NULL;
+
+    if (!g_variant_is_of_type(parameters, G_VARIANT_TYPE ("(ssuuv)"))) {
+        g_warning("array changed handler expects (ssuuv) type, but %s received",
+                  g_variant_get_type_string(parameters));
+        return;
+    }
+
+    g_variant_get(parameters, "(&s&suuv)", &channel_name, &property,
+                  &change, &index, &variant);
+
+    if(strcmp(channel_name, cache->channel_name)) {
+        g_variant_unref(variant);
+        return;
+    }
+
+    if(change != ESCONF_ARRAY_CHANGE_REMOVE)
+        value = esconf_gvariant_to_gvalue(variant);
+    g_variant_unref(variant);
+
+    esconf_cache_mutex_lock(cache);
+
+    /* a SetProperty of ours is in flight, it'll overwrite this */
+    if(g_hash_table_lookup(cache->old_properties, property)) {
+        esconf_cache_mutex_unlock(cache);
+        if(value)
+            _esconf_gvalue_free(value);
+        return;
+    }
+
+    ops = g_hash_table_lookup(cache->array_ops, property);
+    if(ops) {
+        EsconfCacheArrayOp *op = g_queue_pop_head(ops);
+        gboolean ours;
+
+        ours = op->change == change && op->index == index
+               && (change == ESCONF_ARRAY_CHANGE_REMOVE
+                   || (value && _esconf_gvalue_is_equal(op->value, value)));
+        esconf_cache_array_op_free(op);
+
+        if(!ours) {
+            /* someone else changed the array before our change got
+             * in, so what we applied locally is off; start over */
+            g_hash_table_remove(cache->array_ops, property);
+            old = esconf_cache_replace_item(cache, property, NULL);
+        } else {
+            if(g_queue_is_empty(ops))
+                g_hash_table_remove(cache->array_ops, property);
+            esconf_cache_mutex_unlock(cache);
+            if(value)
+                _esconf_gvalue_free(value);
+            return;
+        }
+    } else {
+        item = esconf_cache_apply_array_change(cache, property, change, index,
+                                               value, &old);
+    }
+
+    esconf_cache_mutex_unlock(cache);
+
+    if(value)
+        _esconf_gvalue_free(value);
+
+    /* we don't have the array (anymore), listeners need it in full */
+    if(!item)
+        item = esconf_cache_lookup_item(cache, property, NULL);
+
+    if(item) {
+        g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED], 0,
+                      cache->channel_name, property, item->value);
+        esconf_cache_item_unref(item);
+    }
+
+    if(old)
+        esconf_cache_retire(cache, old);
+}
+
+
 static void
 esconf_cache_proxy_signal_received_cb(GDBusProxy *proxy,
                                       gchar      *sender_name,
@@ -565,15 +961,31 @@ esconf_cache_proxy_signal_received_cb(GDBusProxy *proxy,
                                       gpointer    user_data)
 {
     EsconfCache *cache=(EsconfCache*)user_data;
+    GPtrArray *retired = NULL;
 
     g_return_if_fail(ESCONF_IS_CACHE(cache));
 
+    /* whatever was retired before this notification has had its own
+     * notification dispatched by now; items retired while handling
+     * this one are kept until the next */
+    esconf_cache_write_lock(cache);
+    if(cache->retired->len > 0) {
+        retired = cache->retired;
+        cache->retired = g_ptr_array_new_with_free_func((GDestroyNotify)esconf_cache_item_unref);
+    }
+    esconf_cache_write_unlock(cache);
+
     if (g_strcmp0(signal_name, "PropertyChanged") == 0)
         esconf_cache_handle_property_changed (cache, parameters);
     else if (g_strcmp0(signal_name, "PropertyRemoved") == 0)
         esconf_cache_handle_property_removed(cache, parameters);
+    else if (g_strcmp0(signal_name, "ArrayChanged") == 0)
+        esconf_cache_handle_array_changed(cache, parameters);
     else
         g_warning ("Unhandled signal name :%s\n", signal_name);
+
+    if(retired)
+        g_ptr_array_free(retired, TRUE);
 }
 
 
@@ -615,7 +1027,7 @@ esconf_cache_set_property_reply_handler(GDBusProxy *proxy,
 */
     g_hash_table_remove(cache->old_properties, old_item->property);
     g_hash_table_remove(cache->pending_calls, old_item->cancellable);
-    item = g_tree_lookup(cache->properties, old_item->property);
+    item = esconf_cache_get_item(cache, old_item->property);
     if(G_UNLIKELY(!item)) {
 #ifndef NDEBUG
         g_debug("Couldn't find current cache item based on pending call (libesconf bug?)");
@@ -626,25 +1038,31 @@ esconf_cache_set_property_reply_handler(GDBusProxy *proxy,
     result = esconf_exported_call_set_property_finish ((EsconfExported*)proxy, res, &error);
     if (!result) {
         GValue empty_val = { 0, };
+        EsconfCacheItem *rejected;
+
         g_warning("Failed to set property \"%s::%s\": %s",
                   cache->channel_name, old_item->property, error->message);
         g_error_free(error);
-        if(old_item->item)
-            esconf_cache_item_update(item, old_item->item->value);
-        else {
-            g_tree_remove(cache->properties, old_item->property);
-            item = NULL;
-        }
+
+        /* the rejected value stays alive until handlers have run */
+        rejected = esconf_cache_replace_item(cache, old_item->property,
+                                             old_item->item
+                                             ? esconf_cache_item_ref(old_item->item)
+                                             : NULL);
 
         /* we need to drop the lock when running the signal handlers */
         esconf_cache_mutex_unlock(cache);
         g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED],
                       g_quark_from_string(old_item->property),
                       cache->channel_name, old_item->property,
-                      item ? item->value : &empty_val);
+                      old_item->item ? old_item->item->value : &empty_val);
+        if(rejected)
+            esconf_cache_retire(cache, rejected);
         esconf_cache_mutex_lock(cache);
     }
 
+    esconf_cache_item_unref(item);
+
     /* we handled the call */
     g_cancellable_cancel(old_item->cancellable);
     esconf_cache_old_item_free(old_item);
@@ -710,93 +1128,185 @@ esconf_cache_prefetch(EsconfCache *cache,
 
     g_return_val_if_fail(g_tree_nnodes(cache->properties) == 0, FALSE);
 
-    esconf_cache_mutex_lock(cache);
-
     if(esconf_exported_call_get_all_properties_sync((EsconfExported *)proxy, cache->channel_name,
                                                   property_base ? property_base : "/",
                                                   &props_variant, NULL, &tmp_error))
     {
+        esconf_cache_mutex_lock(cache);
+        esconf_cache_write_lock(cache);
+
         g_variant_get (props_variant, "a{sv}", &iter);
 
         while (g_variant_iter_next (iter, "{sv}", &key, &value))
         {
-            EsconfCacheItem *item;
-
-            GValue *gvalue = esconf_gvariant_to_gvalue (value);
-            item = esconf_cache_item_new(gvalue, TRUE);
-            g_tree_insert(cache->properties, key, item);
+            /* anything that was published while the call was in
+             * flight is newer than what we got here */
+            if(!g_tree_lookup(cache->properties, key)) {
+                GValue *gvalue = esconf_gvariant_to_gvalue (value);
+                g_tree_insert(cache->properties, key,
+                              esconf_cache_item_new(gvalue, TRUE));
+            } else
+                g_free(key);
+            g_variant_unref(value);
         }
         /* TODO: honor max entries */
         ret = TRUE;
         g_variant_iter_free (iter);
         g_variant_unref(props_variant);
+
+        esconf_cache_write_unlock(cache);
+        esconf_cache_mutex_unlock(cache);
     } else
         g_propagate_error(error, tmp_error);
 
-    esconf_cache_mutex_unlock(cache);
-
     return ret;
 }
 
-static gboolean
-esconf_cache_lookup_locked(EsconfCache *cache,
-                           const gchar *property,
-                           GValue *value,
-                           GError **error)
+/* returns a new reference to the current item for |property|,
+ * fetching it from the daemon on a miss.  concurrent misses on the
+ * same property wait for the first one instead of each making their
+ * own call, and no lock is held while that call is in flight. */
+static EsconfCacheItem *
+esconf_cache_lookup_item(EsconfCache *cache,
+                         const gchar *property,
+                         GError **error)
 {
-    EsconfCacheItem *item = NULL;
-    item = g_tree_lookup(cache->properties, property);
+    EsconfCacheItem *item;
+    EsconfCacheFetch *fetch;
+    GVariant *variant;
+    GDBusProxy *proxy;
+    GError *tmp_error = NULL;
 
-    if(!item) {
-        GVariant *variant;
-        GDBusProxy *proxy = _esconf_get_gdbus_proxy();
-        GError *tmp_error = NULL;
-        /* blocking, ugh */
-        if(esconf_exported_call_get_property_sync ((EsconfExported *)proxy, cache->channel_name,
-                                                 property, &variant, NULL, &tmp_error))
-        {
-            GValue *tmpval;
-            tmpval = esconf_gvariant_to_gvalue(variant);
-            item = esconf_cache_item_new(tmpval, TRUE);
-            g_tree_insert(cache->properties, g_strdup(property), item);
-            g_variant_unref (variant);
-            /* TODO: check tree for evictions */
-        } else
-            g_propagate_error(error, tmp_error);
+    item = esconf_cache_get_item(cache, property);
+    if(G_LIKELY(item))
+        return item;
+
+    esconf_cache_mutex_lock(cache);
+
+    fetch = g_hash_table_lookup(cache->fetches, property);
+    if(fetch) {
+        fetch->ref_count++;
+        while(!fetch->done)
+            g_cond_wait(&fetch->cond, &cache->cache_lock);
+
+        if(fetch->item)
+            item = esconf_cache_item_ref(fetch->item);
+        else
+            g_propagate_error(error, g_error_copy(fetch->error));
+
+        esconf_cache_fetch_unref(fetch);
+        esconf_cache_mutex_unlock(cache);
+
+        return item;
     }
 
+    /* the value may have been published while we waited for the lock */
+    item = esconf_cache_get_item(cache, property);
     if(item) {
-        if(value) {
-            if(!G_VALUE_TYPE(value))
-                g_value_init(value, G_VALUE_TYPE(item->value));
-
-            if (G_VALUE_TYPE(item->value) == G_TYPE_PTR_ARRAY) {
-                if (G_VALUE_TYPE(value) != G_TYPE_PTR_ARRAY) {
-                    g_warning("Given value is not of type G_TYPE_PTR_ARRAY");
-                    item = NULL;
-                }
-                else {
-                    GPtrArray *arr;
-                    arr = esconf_dup_value_array (g_value_get_boxed(item->value), FALSE);
-                    g_value_take_boxed(value, arr);
-                }
+        esconf_cache_mutex_unlock(cache);
+        return item;
+    }
+
+    fetch = esconf_cache_fetch_new();
+    g_hash_table_insert(cache->fetches, g_strdup(property), fetch);
+    esconf_cache_mutex_unlock(cache);
+
+    /* blocking, ugh */
+    proxy = _esconf_get_gdbus_proxy();
+    if(esconf_exported_call_get_property_sync ((EsconfExported *)proxy, cache->channel_name,
+                                             property, &variant, NULL, &tmp_error))
+    {
+        GValue *tmpval;
+        tmpval = esconf_gvariant_to_gvalue(variant);
+        item = esconf_cache_item_new(tmpval, TRUE);
+        g_variant_unref (variant);
+    }
+
+    esconf_cache_mutex_lock(cache);
+
+    if(item) {
+        /* a set or a change notification that came in while the call
+         * was in flight is newer than what we just fetched */
+        EsconfCacheItem *cur = esconf_cache_get_item(cache, property);
+
+        if(cur) {
+            esconf_cache_item_unref(item);
+            item = cur;
+        } else {
+            esconf_cache_write_lock(cache);
+            g_tree_insert(cache->properties, g_strdup(property),
+                          esconf_cache_item_ref(item));
+            esconf_cache_write_unlock(cache);
+            /* TODO: check tree for evictions */
+        }
+
+        fetch->item = esconf_cache_item_ref(item);
+    } else {
+        fetch->error = g_error_copy(tmp_error);
+        g_propagate_error(error, tmp_error);
+    }
+
+    fetch->done = TRUE;
+    g_cond_broadcast(&fetch->cond);
+    g_hash_table_remove(cache->fetches, property);
+    esconf_cache_fetch_unref(fetch);
+
+    esconf_cache_mutex_unlock(cache);
+
+    return item;
+}
+
+static gboolean
+esconf_cache_lookup_internal(EsconfCache *cache,
+                             const gchar *property,
+                             GValue *value,
+                             gboolean shared,
+                             GError **error)
+{
+    EsconfCacheItem *item;
+    gboolean ret;
+
+    g_return_val_if_fail(ESCONF_IS_CACHE(cache) && property
+                         && (!error || !*error), FALSE);
+
+    item = esconf_cache_lookup_item(cache, property, error);
+    if(!item)
+        return FALSE;
+
+    ret = TRUE;
+
+    if(value) {
+        if(!G_VALUE_TYPE(value))
+            g_value_init(value, G_VALUE_TYPE(item->value));
+
+        if (G_VALUE_TYPE(item->value) == G_TYPE_PTR_ARRAY) {
+            if (G_VALUE_TYPE(value) != G_TYPE_PTR_ARRAY) {
+                g_warning("Given value is not of type G_TYPE_PTR_ARRAY");
+                ret = FALSE;
+            }
+            else if(shared) {
+                /* copying a G_TYPE_PTR_ARRAY value only adds a ref */
+                g_value_copy(item->value, value);
             }
             else {
-                if(G_VALUE_TYPE(value) == G_VALUE_TYPE(item->value))
-                    g_value_copy(item->value, value);
-                else {
-                    if(!g_value_transform(item->value, value))
-                        item = NULL;
-                }
+                GPtrArray *arr;
+                arr = esconf_dup_value_array (g_value_get_boxed(item->value), FALSE);
+                g_value_take_boxed(value, arr);
+            }
+        }
+        else {
+            if(G_VALUE_TYPE(value) == G_VALUE_TYPE(item->value))
+                g_value_copy(item->value, value);
+            else {
+                if(!g_value_transform(item->value, value))
+                    ret = FALSE;
             }
         }
-#if 0
-        if(item)
-            esconf_cache_item_update(item, NULL);
-#endif
     }
 
-    return !!item;
+    esconf_cache_item_unref(item);
+
+    return ret;
 }
 
 gboolean
@@ -805,16 +1315,70 @@ esconf_cache_lookup(EsconfCache *cache,
                     GValue *value,
                     GError **error)
 {
-    gboolean ret;
+    return esconf_cache_lookup_internal(cache, property, value, FALSE, error);
+}
+
+/* like esconf_cache_lookup(), but an array value shares the cached,
+ * immutable GPtrArray instead of getting a private copy.  the caller
+ * must not modify the array or its values; g_value_unset() drops the
+ * reference. */
+gboolean
+esconf_cache_lookup_shared(EsconfCache *cache,
+                           const gchar *property,
+                           GValue *value,
+                           GError **error)
+{
+    return esconf_cache_lookup_internal(cache, property, value, TRUE, error);
+}
+
+/* returns the cache-owned value of |property| without copying it.
+ * the pointer stays valid until the property changes or is reset and
+ * that change notification has been dispatched on the main context
+ * of the cache: replaced items are retired, not freed, see
+ * esconf_cache_retire().  this holds for any thread. */
+const GValue *
+esconf_cache_peek(EsconfCache *cache,
+                  const gchar *property,
+                  GError **error)
+{
+    EsconfCacheItem *item;
+    const GValue *value;
 
     g_return_val_if_fail(ESCONF_IS_CACHE(cache) && property
-                         && (!error || !*error), FALSE);
+                         && (!error || !*error), NULL);
 
-    esconf_cache_mutex_lock(cache);
-    ret = esconf_cache_lookup_locked(cache, property, value, error);
-    esconf_cache_mutex_unlock(cache);
+    item = esconf_cache_lookup_item(cache, property, error);
+    if(!item)
+        return NULL;
 
-    return ret;
+    value = item->value;
+    esconf_cache_item_unref(item);
+
+    return value;
+}
+
+/* like esconf_cache_peek(), but returns a NULL-terminated view of a
+ * string array value.  the view is built once per item and shares
+ * the strings with the cached value. */
+const gchar * const *
+esconf_cache_peek_strv(EsconfCache *cache,
+                       const gchar *property,
+                       GError **error)
+{
+    EsconfCacheItem *item;
+    const gchar * const *strv;
+
+    g_return_val_if_fail(ESCONF_IS_CACHE(cache) && property
+                         && (!error || !*error), NULL);
+
+    item = esconf_cache_lookup_item(cache, property, error);
+    if(!item)
+        return NULL;
+
+    strv = esconf_cache_item_get_strv(item);
+    esconf_cache_item_unref(item);
+
+    return strv;
 }
 
 gboolean
@@ -825,47 +1389,43 @@ esconf_cache_set(EsconfCache *cache,
 {
     GVariant *variant = NULL, *val = NULL;
     GDBusProxy *proxy = _esconf_get_gdbus_proxy();
-    EsconfCacheItem *item = NULL;
+    EsconfCacheItem *item = NULL, *retired;
     EsconfCacheOldItem *old_item = NULL;
-    esconf_cache_mutex_lock(cache);
+    GError *tmp_error = NULL;
 
-    item = g_tree_lookup(cache->properties, property);
+    /* this is really quite the opposite of what we want here,
+     * but i can't think of a better way yet.  this may have to
+     * ask the daemon, so do it before taking any locks. */
+    item = esconf_cache_lookup_item(cache, property, &tmp_error);
     if(!item) {
-        /* this is really quite the opposite of what we want here,
-         * but i can't think of a better way yet. */
-        GValue tmp_val = { 0, };
-        GError *tmp_error = NULL;
-        if(!esconf_cache_lookup_locked(cache, property, &tmp_val, &tmp_error)) {
-            gchar *dbus_error_name = NULL;
-
-            if(G_LIKELY(g_dbus_error_is_remote_error (tmp_error)))
-                dbus_error_name = g_dbus_error_get_remote_error (tmp_error);
-
-            if(g_strcmp0(dbus_error_name, "com.expidus.Esconf.Error.PropertyNotFound") != 0
-               && g_strcmp0(dbus_error_name, "com.expidus.Esconf.Error.ChannelNotFound") != 0)
-            {
-                /* this is bad... */
-                g_propagate_error(error, tmp_error);
-                esconf_cache_mutex_unlock(cache);
-                g_free (dbus_error_name);
-                return FALSE;
-            }
-            /* prop just doesn't exist; continue */
-            g_error_free(tmp_error);
+        gchar *dbus_error_name = NULL;
+
+        if(G_LIKELY(g_dbus_error_is_remote_error (tmp_error)))
+            dbus_error_name = g_dbus_error_get_remote_error (tmp_error);
+
+        if(g_strcmp0(dbus_error_name, "com.expidus.Esconf.Error.PropertyNotFound") != 0
+           && g_strcmp0(dbus_error_name, "com.expidus.Esconf.Error.ChannelNotFound") != 0)
+        {
+            /* this is bad... */
+            g_propagate_error(error, tmp_error);
             g_free (dbus_error_name);
-        } else {
-            g_value_unset(&tmp_val);
-            item = g_tree_lookup(cache->properties, property);
+            return FALSE;
         }
+        /* prop just doesn't exist; continue */
+        g_error_free(tmp_error);
+        g_free (dbus_error_name);
     }
 
     if(item) {
         /* if the value isn't changing, there's no reason to continue */
-        if(_esconf_gvalue_is_equal(item->value, value)) {
-            esconf_cache_mutex_unlock(cache);
+        if(esconf_cache_item_value_equal(item, value)) {
+            esconf_cache_item_unref(item);
             return TRUE;
         }
     }
+
+    esconf_cache_mutex_lock(cache);
+
     old_item = g_hash_table_lookup(cache->old_properties, property);
     if(old_item) {
         /* if we have an old item, it means that a previous set
@@ -888,14 +1448,19 @@ esconf_cache_set(EsconfCache *cache,
     } else {
         old_item = esconf_cache_old_item_new(cache, property);
         if(item)
-            old_item->item = esconf_cache_item_new(item->value, FALSE);
+            old_item->item = esconf_cache_item_ref(item);
         g_hash_table_insert(cache->old_properties, old_item->property, old_item);
     }
 
+    if(item)
+        esconf_cache_item_unref(item);
+
     val = esconf_gvalue_to_gvariant (value);
     if (val) {
         variant = g_variant_new_variant (val);
 
+        /* this only queues the message; the reply is handled in
+         * esconf_cache_set_property_reply_handler() */
         esconf_exported_call_set_property ((EsconfExported *)proxy,
                                            cache->channel_name,
                                            property,
@@ -909,17 +1474,16 @@ esconf_cache_set(EsconfCache *cache,
 
         g_hash_table_insert(cache->pending_calls, old_item->cancellable, old_item);
 
-        if(item)
-            esconf_cache_item_update(item, value);
-        else {
-            item = esconf_cache_item_new(value, FALSE);
-            g_tree_insert(cache->properties, g_strdup(property), item);
-        }
+        retired = esconf_cache_replace_item(cache, property,
+                                            esconf_cache_item_new(value, FALSE));
 
         esconf_cache_mutex_unlock(cache);
         g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED], 0,
                       cache->channel_name, property, value);
 
+        if(retired)
+            esconf_cache_retire(cache, retired);
+
         return TRUE;
     }
     esconf_cache_mutex_unlock(cache);
@@ -947,6 +1511,106 @@ esconf_cache_collect_properties_recursive(gpointer key,
     return FALSE;
 }
 
+gboolean
+esconf_cache_array_change(EsconfCache *cache,
+                          const gchar *property,
+                          EsconfArrayChange change,
+                          guint index,
+                          const GValue *value,
+                          GError **error)
+{
+    GDBusProxy *proxy = _esconf_get_gdbus_proxy();
+    EsconfCacheItem *item, *old;
+    GVariant *variant = NULL;
+    gboolean ret = FALSE;
+
+    g_return_val_if_fail(ESCONF_IS_CACHE(cache) && property
+                         && (!error || !*error), FALSE);
+    g_return_val_if_fail(change == ESCONF_ARRAY_CHANGE_REMOVE || value, FALSE);
+
+    if(value) {
+        variant = esconf_gvalue_to_gvariant(value);
+        if(!variant) {
+            g_set_error(error, ESCONF_ERROR, ESCONF_ERROR_INTERNAL_ERROR,
+                        "Unable to convert value of type \"%s\"",
+                        G_VALUE_TYPE_NAME(value));
+            return FALSE;
+        }
+    }
+
+    /* like resets, these are sync: the daemon checks the index, and
+     * we only know the new array once it accepted the change */
+    switch(change) {
+        case ESCONF_ARRAY_CHANGE_SET:
+            ret = esconf_exported_call_array_set_index_sync((EsconfExported *)proxy,
+                                                            cache->channel_name,
+                                                            property, index,
+                                                            g_variant_new_variant(variant),
+                                                            NULL, error);
+            break;
+
+        case ESCONF_ARRAY_CHANGE_INSERT:
+            ret = esconf_exported_call_array_insert_sync((EsconfExported *)proxy,
+                                                         cache->channel_name,
+                                                         property, index,
+                                                         g_variant_new_variant(variant),
+                                                         NULL, error);
+            break;
+
+        case ESCONF_ARRAY_CHANGE_REMOVE:
+            ret = esconf_exported_call_array_remove_sync((EsconfExported *)proxy,
+                                                         cache->channel_name,
+                                                         property, index,
+                                                         NULL, error);
+            break;
+    }
+
+    if(variant)
+        g_variant_unref(variant);
+
+    if(!ret)
+        return FALSE;
+
+    esconf_cache_mutex_lock(cache);
+
+    item = esconf_cache_apply_array_change(cache, property, change, index,
+                                           value, &old);
+    if(item) {
+        EsconfCacheArrayOp *op;
+        GQueue *ops;
+
+        /* remember the change so we recognize its ArrayChanged */
+        op = g_slice_new0(EsconfCacheArrayOp);
+        op->change = change;
+        op->index = index;
+        if(value) {
+            op->value = g_new0(GValue, 1);
+            g_value_init(op->value, G_VALUE_TYPE(value));
+            g_value_copy(value, op->value);
+        }
+
+        ops = g_hash_table_lookup(cache->array_ops, property);
+        if(!ops) {
+            ops = g_queue_new();
+            g_hash_table_insert(cache->array_ops, g_strdup(property), ops);
+        }
+        g_queue_push_tail(ops, op);
+    }
+
+    esconf_cache_mutex_unlock(cache);
+
+    if(item) {
+        g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED], 0,
+                      cache->channel_name, property, item->value);
+        esconf_cache_item_unref(item);
+    }
+
+    if(old)
+        esconf_cache_retire(cache, old);
+
+    return TRUE;
+}
+
 gboolean
 esconf_cache_reset(EsconfCache *cache,
                    const gchar *property_base,
@@ -959,8 +1623,6 @@ esconf_cache_reset(EsconfCache *cache,
     EsconfCacheOldItem *old_item = NULL;
 #endif
 
-    esconf_cache_mutex_lock(cache);
-
 #if 0
     /* it's not really feasible here to look up all the old/new values
      * here, so we're just gonna rely on the normal signals from the
@@ -1000,7 +1662,10 @@ esconf_cache_reset(EsconfCache *cache,
          * pretty slow because we have to traverse the entire tree if
          * recursive==TRUE. */
 
-        g_tree_remove(cache->properties, property_base);
+        esconf_cache_mutex_lock(cache);
+        esconf_cache_write_lock(cache);
+
+        esconf_cache_evict_locked(cache, property_base);
 
         if(recursive) {
             EsconfCacheRecurseData rdata;
@@ -1015,16 +1680,17 @@ esconf_cache_reset(EsconfCache *cache,
                            &rdata);
 
             for(l = rdata.matches; l; l = l->next)
-                g_tree_remove(cache->properties, l->data);
+                esconf_cache_evict_locked(cache, l->data);
 
             g_free(rdata.property_base);
             g_slist_free(rdata.matches);
         }
+
+        esconf_cache_write_unlock(cache);
+        esconf_cache_mutex_unlock(cache);
     }
 #endif
 
-    esconf_cache_mutex_unlock(cache);
-
     return ret;
 }
 
@@ -23,6 +23,8 @@
 
 #include <glib-object.h>
 
+#include "common/esconf-gvaluefuncs.h"
+
 #define ESCONF_TYPE_CACHE             (esconf_cache_get_type())
 #define ESCONF_CACHE(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj), ESCONF_TYPE_CACHE, EsconfCache))
 #define ESCONF_IS_CACHE(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj), ESCONF_TYPE_CACHE))
@@ -51,12 +53,36 @@ gboolean esconf_cache_lookup(EsconfCache *cache,
                              GValue *value,
                              GError **error);
 
+G_GNUC_INTERNAL
+gboolean esconf_cache_lookup_shared(EsconfCache *cache,
+                                    const gchar *property,
+                                    GValue *value,
+                                    GError **error);
+
+G_GNUC_INTERNAL
+const GValue *esconf_cache_peek(EsconfCache *cache,
+                                const gchar *property,
+                                GError **error);
+
+G_GNUC_INTERNAL
+const gchar * const *esconf_cache_peek_strv(EsconfCache *cache,
+                                            const gchar *property,
+                                            GError **error);
+
 G_GNUC_INTERNAL
 gboolean esconf_cache_set(EsconfCache *cache,
                           const gchar *property,
                           const GValue *value,
                           GError **error);
 
+G_GNUC_INTERNAL
+gboolean esconf_cache_array_change(EsconfCache *cache,
+                                   const gchar *property,
+                                   EsconfArrayChange change,
+                                   guint index,
+                                   const GValue *value,
+                                   GError **error);
+
 G_GNUC_INTERNAL
 gboolean esconf_cache_reset(EsconfCache *cache,
                             const gchar *property_base,
@@ -379,6 +379,12 @@ _esconf_channel_shutdown(void)
     G_UNLOCK(__singletons);
 }
 
+const gchar *
+_esconf_channel_get_property_base(EsconfChannel *channel)
+{
+    return channel->property_base;
+}
+
 
 static void
 esconf_channel_property_changed(EsconfCache *cache,
@@ -407,6 +413,24 @@ esconf_channel_property_changed(EsconfCache *cache,
 }
 
 
+static const GValue *
+esconf_channel_peek_internal(EsconfChannel *channel,
+                             const gchar *property)
+{
+    const GValue *val;
+    gchar *real_property = REAL_PROP(channel, property);
+    ERROR_DEFINE;
+
+    val = esconf_cache_peek(channel->cache, real_property, ERROR);
+    if(!val)
+        ERROR_CHECK;
+
+    if(real_property != property)
+        g_free(real_property);
+
+    return val;
+}
+
 static gboolean
 esconf_channel_set_internal(EsconfChannel *channel,
                             const gchar *property,
@@ -470,6 +494,54 @@ esconf_channel_get_internal(EsconfChannel *channel,
     return ret;
 }
 
+/* like esconf_channel_get_internal() with an unset |value|, but
+ * arrays are shared with the cache rather than copied */
+static gboolean
+esconf_channel_get_shared(EsconfChannel *channel,
+                          const gchar *property,
+                          GValue *value)
+{
+    gboolean ret;
+    gchar *real_property = REAL_PROP(channel, property);
+    ERROR_DEFINE;
+
+    ret = esconf_cache_lookup_shared(channel->cache, real_property, value, ERROR);
+    if(!ret)
+        ERROR_CHECK;
+
+    if(real_property != property)
+        g_free(real_property);
+
+    return ret;
+}
+
+/* returns a reference to the cached array; it's shared with the
+ * cache and other readers, so it must not be modified.  release it
+ * with g_ptr_array_unref(). */
+static GPtrArray *
+esconf_channel_get_shared_array(EsconfChannel *channel,
+                                const gchar *property)
+{
+    GValue val = { 0, };
+    GPtrArray *arr = NULL;
+
+    if(!esconf_channel_get_shared(channel, property, &val))
+        return NULL;
+
+    if(G_VALUE_TYPE(&val) == G_TYPE_PTR_ARRAY) {
+        arr = g_value_dup_boxed(&val);
+        if(!arr->len) {
+            g_ptr_array_unref(arr);
+            arr = NULL;
+        }
+    } else
+        g_warning("Unexpected value type %s\n", G_VALUE_TYPE_NAME(&val));
+
+    g_value_unset(&val);
+
+    return arr;
+}
+
 
 static GPtrArray *
 esconf_transform_array(GPtrArray *arr_src,
@@ -806,7 +878,7 @@ esconf_channel_get_string_list(EsconfChannel *channel,
 
     g_return_val_if_fail(ESCONF_IS_CHANNEL(channel) && property, NULL);
 
-    arr = esconf_channel_get_arrayv(channel, property);
+    arr = esconf_channel_get_shared_array(channel, property);
     if(!arr)
         return NULL;
 
@@ -815,15 +887,92 @@ esconf_channel_get_string_list(EsconfChannel *channel,
         GValue *val = g_ptr_array_index(arr, i);
 
         if(G_VALUE_TYPE(val) != G_TYPE_STRING) {
-            esconf_array_free(arr);
+            g_ptr_array_unref(arr);
             g_strfreev(values);
             return NULL;
         }
 
-        values[i] = g_value_dup_string(val);  /* FIXME: avoid copy */
+        values[i] = g_value_dup_string(val);
     }
 
-    esconf_array_free(arr);
+    g_ptr_array_unref(arr);
+
+    return values;
+}
+
+/**
+ * esconf_channel_peek_string:
+ * @channel: An #EsconfChannel.
+ * @property: A property name.
+ * @default_value: A fallback value.
+ *
+ * Retrieves the string value associated with @property on @channel
+ * without copying it.  This is cheaper than esconf_channel_get_string()
+ * for consumers that read the same properties frequently.
+ *
+ * The returned string is owned by @channel's cache.  It stays valid
+ * until @property changes or is reset, and the notification of that
+ * change has been dispatched in the main context of @channel.  This
+ * holds for every thread, also if another thread changed @property.
+ * Use g_strdup() to keep it longer.
+ *
+ * Returns: (transfer none): The cached string, or @default_value if
+ *          @property is not in @channel or is not a string.
+ *
+ * Since: 1.0.0
+ **/
+const gchar *
+esconf_channel_peek_string(EsconfChannel *channel,
+                           const gchar *property,
+                           const gchar *default_value)
+{
+    const GValue *val;
+
+    g_return_val_if_fail(ESCONF_IS_CHANNEL(channel) && property, NULL);
+
+    val = esconf_channel_peek_internal(channel, property);
+    if(val && G_VALUE_TYPE(val) == G_TYPE_STRING)
+        return g_value_get_string(val);
+
+    return default_value;
+}
+
+/**
+ * esconf_channel_peek_string_list:
+ * @channel: An #EsconfChannel.
+ * @property: A property name.
+ *
+ * Retrieves the string list value associated with @property on
+ * @channel without copying it.  The same lifetime rules as for
+ * esconf_channel_peek_string() apply.
+ *
+ * Returns: (transfer none) (array zero-terminated=1): The cached string
+ *          list, or %NULL if @property is not in @channel or is not an
+ *          array of strings.
+ *
+ * Since: 1.0.0
+ **/
+const gchar * const *
+esconf_channel_peek_string_list(EsconfChannel *channel,
+                                const gchar *property)
+{
+    const gchar * const *values;
+    gchar *real_property = REAL_PROP(channel, property);
+    ERROR_DEFINE;
+
+    g_return_val_if_fail(ESCONF_IS_CHANNEL(channel) && property, NULL);
+
+    values = esconf_cache_peek_strv(channel->cache, real_property, ERROR);
+    if(!values)
+        ERROR_CHECK;
+
+    if(real_property != property)
+        g_free(real_property);
+
+    /* match esconf_channel_get_string_list(), which treats an empty
+     * array as unset */
+    if(values && !values[0])
+        return NULL;
 
     return values;
 }
@@ -1233,7 +1382,9 @@ esconf_channel_get_property(EsconfChannel *channel,
     g_return_val_if_fail(ESCONF_IS_CHANNEL(channel) && property && value,
                          FALSE);
 
-    ret = esconf_channel_get_internal(channel, property, &val1);
+    /* arrays in |val1| are shared with the cache, only the final
+     * result is copied for the caller */
+    ret = esconf_channel_get_shared(channel, property, &val1);
 
     if(ret) {
         if(G_VALUE_TYPE(value) != G_TYPE_INVALID
@@ -1266,7 +1417,13 @@ esconf_channel_get_property(EsconfChannel *channel,
              * native type to convert to */
             if(G_VALUE_TYPE(value) == G_VALUE_TYPE(&val1))
                 g_value_unset(value);
-            g_value_copy(&val1, g_value_init(value, G_VALUE_TYPE(&val1)));
+            g_value_init(value, G_VALUE_TYPE(&val1));
+            if(G_VALUE_TYPE(&val1) == G_TYPE_PTR_ARRAY) {
+                g_value_take_boxed(value,
+                                   esconf_dup_value_array(g_value_get_boxed(&val1),
+                                                          FALSE));
+            } else
+                g_value_copy(&val1, value);
             ret = TRUE;
         }
     }
@@ -1376,7 +1533,7 @@ esconf_channel_get_array_valist(EsconfChannel *channel,
     GValue *val;
     guint i;
 
-    arr = esconf_channel_get_arrayv(channel, property);
+    arr = esconf_channel_get_shared_array(channel, property);
     if(!arr)
         return FALSE;
 
@@ -1465,7 +1622,7 @@ esconf_channel_get_array_valist(EsconfChannel *channel,
     ret = TRUE;
 
 out:
-    esconf_array_free(arr);
+    g_ptr_array_unref(arr);
 
     return ret;
 }
@@ -1512,6 +1669,41 @@ esconf_channel_get_arrayv(EsconfChannel *channel,
     return arr;
 }
 
+/**
+ * esconf_channel_peek_arrayv:
+ * @channel: An #EsconfChannel.
+ * @property: A property name.
+ *
+ * Retrieves an array property from @channel without copying it.
+ * The same lifetime rules as for esconf_channel_peek_string() apply;
+ * neither the array nor its values may be modified.
+ *
+ * Returns: (transfer none) (element-type GValue): The cached array,
+ *          or %NULL if @property is not in @channel, is not an array,
+ *          or is empty.
+ *
+ * Since: 1.0.0
+ **/
+const GPtrArray *
+esconf_channel_peek_arrayv(EsconfChannel *channel,
+                           const gchar *property)
+{
+    const GValue *val;
+    const GPtrArray *arr;
+
+    g_return_val_if_fail(ESCONF_IS_CHANNEL(channel) && property, NULL);
+
+    val = esconf_channel_peek_internal(channel, property);
+    if(!val || G_VALUE_TYPE(val) != G_TYPE_PTR_ARRAY)
+        return NULL;
+
+    arr = g_value_get_boxed(val);
+    if(!arr || !arr->len)
+        return NULL;
+
+    return arr;
+}
+
 /**
  * esconf_channel_set_array:
  * @channel: An #EsconfChannel.
@@ -1681,6 +1873,122 @@ esconf_channel_set_arrayv(EsconfChannel *channel,
     return ret;
 }
 
+static gboolean
+esconf_channel_array_change(EsconfChannel *channel,
+                            const gchar *property,
+                            EsconfArrayChange change,
+                            guint index,
+                            const GValue *value)
+{
+    gboolean ret;
+    gchar *real_property = REAL_PROP(channel, property);
+    ERROR_DEFINE;
+
+    ret = esconf_cache_array_change(channel->cache, real_property, change,
+                                    index, value, ERROR);
+    if(!ret)
+        ERROR_CHECK;
+
+    if(real_property != property)
+        g_free(real_property);
+
+    return ret;
+}
+
+/**
+ * esconf_channel_array_set_index:
+ * @channel: An #EsconfChannel.
+ * @property: The name of an array property.
+ * @index: The index of the element to replace.
+ * @value: The new value of the element.
+ *
+ * Replaces the element at @index of the array property @property
+ * with @value.  Unlike changing the array with
+ * esconf_channel_set_arrayv(), only the changed element is sent to
+ * the Esconf daemon and to the other applications watching
+ * @property, which makes this much cheaper for large arrays.
+ *
+ * @value must be a simple value (not an array), and @index must be
+ * smaller than the length of the array.
+ *
+ * Returns: %TRUE if the element was set successfully,
+ *          %FALSE otherwise.
+ *
+ * Since: 1.0.0
+ **/
+gboolean
+esconf_channel_array_set_index(EsconfChannel *channel,
+                               const gchar *property,
+                               guint index,
+                               const GValue *value)
+{
+    g_return_val_if_fail(ESCONF_IS_CHANNEL(channel) && property
+                         && G_IS_VALUE(value), FALSE);
+
+    return esconf_channel_array_change(channel, property,
+                                       ESCONF_ARRAY_CHANGE_SET, index, value);
+}
+
+/**
+ * esconf_channel_array_insert:
+ * @channel: An #EsconfChannel.
+ * @property: The name of an array property.
+ * @index: The index to insert @value at.
+ * @value: The value to insert.
+ *
+ * Inserts @value into the array property @property before the
+ * element at @index.  Passing the length of the array as @index
+ * appends @value.  If @property doesn't exist, it is created as an
+ * array holding only @value, provided @index is 0.
+ *
+ * See esconf_channel_array_set_index() for why you would use this
+ * rather than setting the whole array.
+ *
+ * Returns: %TRUE if the element was inserted successfully,
+ *          %FALSE otherwise.
+ *
+ * Since: 1.0.0
+ **/
+gboolean
+esconf_channel_array_insert(EsconfChannel *channel,
+                            const gchar *property,
+                            guint index,
+                            const GValue *value)
+{
+    g_return_val_if_fail(ESCONF_IS_CHANNEL(channel) && property
+                         && G_IS_VALUE(value), FALSE);
+
+    return esconf_channel_array_change(channel, property,
+                                       ESCONF_ARRAY_CHANGE_INSERT, index, value);
+}
+
+/**
+ * esconf_channel_array_remove:
+ * @channel: An #EsconfChannel.
+ * @property: The name of an array property.
+ * @index: The index of the element to remove.
+ *
+ * Removes the element at @index from the array property @property.
+ *
+ * See esconf_channel_array_set_index() for why you would use this
+ * rather than setting the whole array.
+ *
+ * Returns: %TRUE if the element was removed successfully,
+ *          %FALSE otherwise.
+ *
+ * Since: 1.0.0
+ **/
+gboolean
+esconf_channel_array_remove(EsconfChannel *channel,
+                            const gchar *property,
+                            guint index)
+{
+    g_return_val_if_fail(ESCONF_IS_CHANNEL(channel) && property, FALSE);
+
+    return esconf_channel_array_change(channel, property,
+                                       ESCONF_ARRAY_CHANGE_REMOVE, index, NULL);
+}
+
 /**
  * esconf_channel_get_named_struct:
  * @channel: An #EsconfChannel.
@@ -1875,7 +2183,7 @@ esconf_channel_get_structv(EsconfChannel *channel,
     g_return_val_if_fail(ESCONF_IS_CHANNEL(channel) && property && value_struct
                          && n_members && member_types, FALSE);
 
-    arr = esconf_channel_get_arrayv(channel, property);
+    arr = esconf_channel_get_shared_array(channel, property);
     if(!arr)
         return FALSE;
 
@@ -1988,7 +2296,7 @@ esconf_channel_get_structv(EsconfChannel *channel,
     ret = TRUE;
 
 out:
-    esconf_array_free(arr);
+    g_ptr_array_unref(arr);
 
     return ret;
 }
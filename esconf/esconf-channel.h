@@ -112,6 +112,16 @@ gboolean esconf_channel_set_string_list(EsconfChannel *channel,
                                         const gchar *property,
                                         const gchar * const *values);
 
+/* borrowed-value API - the returned data is owned by the channel's
+ * cache and must not be modified or freed */
+const gchar *esconf_channel_peek_string(EsconfChannel *channel,
+                                        const gchar *property,
+                                        const gchar *default_value);
+const gchar * const *esconf_channel_peek_string_list(EsconfChannel *channel,
+                                                     const gchar *property);
+const GPtrArray *esconf_channel_peek_arrayv(EsconfChannel *channel,
+                                            const gchar *property);
+
 /* really generic API - can set some value types that aren't
  * supported by the basic type API, e.g., char, signed short,
  * unsigned int, etc.  no, you can't set arbitrary GTypes. */
@@ -149,6 +159,19 @@ gboolean esconf_channel_set_arrayv(EsconfChannel *channel,
                                    const gchar *property,
                                    GPtrArray *values);
 
+/* element-level array changes */
+gboolean esconf_channel_array_set_index(EsconfChannel *channel,
+                                        const gchar *property,
+                                        guint index,
+                                        const GValue *value);
+gboolean esconf_channel_array_insert(EsconfChannel *channel,
+                                     const gchar *property,
+                                     guint index,
+                                     const GValue *value);
+gboolean esconf_channel_array_remove(EsconfChannel *channel,
+                                     const gchar *property,
+                                     guint index);
+
 /* struct types */
 
 gboolean esconf_channel_get_named_struct(EsconfChannel *channel,
@@ -41,33 +41,109 @@ static GDBusConnection *gdbus = NULL;
 static GDBusProxy *gproxy = NULL;
 static GHashTable *named_structs = NULL;
 
+/* guards lazy creation of |gdbus| and |gproxy| */
+G_LOCK_DEFINE_STATIC(__proxy);
+
 #define ESCONF_DBUS_NAME "com.expidus.Esconf"
 #define ESCONF_DBUS_NAME_TEST "com.expidus.EsconfTest"
 
+/* we never use D-Bus properties, and esconfd is only activated by the
+ * first real call; the bus holds that call until the daemon owns the
+ * name, so nothing has to wait for activation up front. */
+#define ESCONF_PROXY_FLAGS  (G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES \
+                             | G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START_AT_CONSTRUCTION)
+
+
+static const gchar *
+esconf_get_dbus_name(void)
+{
+    return g_getenv("ESCONF_RUN_IN_TEST_MODE") == NULL
+           ? ESCONF_DBUS_NAME : ESCONF_DBUS_NAME_TEST;
+}
+
+/* publishes a connection or proxy created by the async init path,
+ * unless the lazy path beat it to it */
+static void
+esconf_publish_object(gpointer *location,
+                      gpointer object)
+{
+    G_LOCK(__proxy);
+    if(*location == NULL)
+        g_atomic_pointer_set(location, object);
+    else
+        g_object_unref(object);
+    G_UNLOCK(__proxy);
+}
+
 
 /* private api */
 
 GDBusConnection *
 _esconf_get_gdbus_connection(void)
 {
+    GDBusConnection *conn;
+
     if(!esconf_refcnt) {
         g_critical("esconf_init() must be called before attempting to use libesconf!");
         return NULL;
     }
 
-    return gdbus;
+    conn = g_atomic_pointer_get(&gdbus);
+    if(G_UNLIKELY(!conn)) {
+        /* esconf_init_async() hasn't finished yet */
+        G_LOCK(__proxy);
+        if(!gdbus)
+            g_atomic_pointer_set(&gdbus, g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL));
+        conn = gdbus;
+        G_UNLOCK(__proxy);
+    }
+
+    return conn;
 }
 
 
 GDBusProxy *
 _esconf_get_gdbus_proxy(void)
 {
+    GDBusProxy *proxy;
+    GDBusConnection *conn;
+    GError *error = NULL;
+
     if(!esconf_refcnt) {
         g_critical("esconf_init() must be called before attempting to use libesconf!");
         return NULL;
     }
 
-    return gproxy;
+    proxy = g_atomic_pointer_get(&gproxy);
+    if(G_LIKELY(proxy))
+        return proxy;
+
+    conn = _esconf_get_gdbus_connection();
+    if(G_UNLIKELY(!conn))
+        return NULL;
+
+    /* first use: create the proxy now.  this only talks to the bus
+     * daemon, not to esconfd. */
+    G_LOCK(__proxy);
+    if(!gproxy) {
+        proxy = g_dbus_proxy_new_sync(conn,
+                                      ESCONF_PROXY_FLAGS,
+                                      NULL,
+                                      esconf_get_dbus_name(),
+                                      "/com/expidus/Esconf",
+                                      "com.expidus.Esconf",
+                                      NULL,
+                                      &error);
+        if(G_UNLIKELY(!proxy)) {
+            g_critical("Unable to create the esconf D-Bus proxy: %s", error->message);
+            g_error_free(error);
+        }
+        g_atomic_pointer_set(&gproxy, proxy);
+    }
+    proxy = gproxy;
+    G_UNLOCK(__proxy);
+
+    return proxy;
 }
 
 EsconfNamedStruct *
@@ -105,38 +181,157 @@ _esconf_named_struct_free(EsconfNamedStruct *ns)
  * Initializes the Esconf library.  Can be called multiple times with no
  * adverse effects.
  *
+ * This only connects to the session bus.  The connection to the
+ * Esconf daemon is set up on first use, so starting the daemon does
+ * not delay the caller.  See esconf_init_async() for a variant that
+ * does not block at all.
+ *
  * Returns: %TRUE if the library was initialized succesfully, %FALSE on
  *          error.  If there is an error @error will be set.
  **/
 gboolean
 esconf_init(GError **error)
 {
-    const gchar *is_test_mode;
+    GDBusConnection *conn;
 
     if(esconf_refcnt) {
         ++esconf_refcnt;
         return TRUE;
     }
 
-    gdbus = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, error);
+    conn = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, error);
 
-    if (!gdbus)
+    if (!conn)
         return FALSE;
 
-    is_test_mode = g_getenv ("ESCONF_RUN_IN_TEST_MODE");
-    gproxy = g_dbus_proxy_new_sync(gdbus,
-                                   G_DBUS_PROXY_FLAGS_NONE,
-                                   NULL,
-                                   is_test_mode == NULL ? ESCONF_DBUS_NAME : ESCONF_DBUS_NAME_TEST,
-                                   "/com/expidus/Esconf",
-                                   "com.expidus.Esconf",
-                                   NULL,
-                                   NULL);
+    esconf_publish_object((gpointer *)&gdbus, conn);
 
     ++esconf_refcnt;
     return TRUE;
 }
 
+static void
+esconf_init_proxy_ready(GObject *source,
+                        GAsyncResult *res,
+                        gpointer user_data)
+{
+    GTask *task = user_data;
+    GDBusProxy *proxy;
+    GError *error = NULL;
+
+    proxy = g_dbus_proxy_new_finish(res, &error);
+    if(proxy) {
+        esconf_publish_object((gpointer *)&gproxy, proxy);
+        g_task_return_boolean(task, TRUE);
+    } else if(g_atomic_pointer_get(&gproxy)) {
+        /* the lazy path already set one up for us */
+        g_error_free(error);
+        g_task_return_boolean(task, TRUE);
+    } else {
+        --esconf_refcnt;
+        g_task_return_error(task, error);
+    }
+
+    g_object_unref(task);
+}
+
+static void
+esconf_init_bus_ready(GObject *source,
+                      GAsyncResult *res,
+                      gpointer user_data)
+{
+    GTask *task = user_data;
+    GDBusConnection *conn;
+    GError *error = NULL;
+
+    conn = g_bus_get_finish(res, &error);
+    if(!conn) {
+        --esconf_refcnt;
+        g_task_return_error(task, error);
+        g_object_unref(task);
+        return;
+    }
+
+    esconf_publish_object((gpointer *)&gdbus, conn);
+
+    if(g_atomic_pointer_get(&gproxy)) {
+        g_task_return_boolean(task, TRUE);
+        g_object_unref(task);
+        return;
+    }
+
+    g_dbus_proxy_new(gdbus,
+                     ESCONF_PROXY_FLAGS,
+                     NULL,
+                     esconf_get_dbus_name(),
+                     "/com/expidus/Esconf",
+                     "com.expidus.Esconf",
+                     g_task_get_cancellable(task),
+                     esconf_init_proxy_ready,
+                     task);
+}
+
+/**
+ * esconf_init_async:
+ * @cancellable: (nullable): A #GCancellable, or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when initialization is done.
+ * @user_data: Data to pass to @callback.
+ *
+ * Asynchronously initializes the Esconf library.  Unlike esconf_init(),
+ * this never blocks the calling thread.  When it is done, @callback is
+ * called in the thread-default main context of the caller; call
+ * esconf_init_finish() from it to get the result.
+ *
+ * The library counts as initialized as soon as this function returns,
+ * so channels may be used right away: anything that needs the daemon
+ * before initialization has finished will simply set up the
+ * connection itself.  If initialization fails, the reference taken
+ * here is dropped again, and esconf_shutdown() must not be called for
+ * it.
+ *
+ * Since: 1.0.0
+ **/
+void
+esconf_init_async(GCancellable *cancellable,
+                  GAsyncReadyCallback callback,
+                  gpointer user_data)
+{
+    GTask *task;
+
+    task = g_task_new(NULL, cancellable, callback, user_data);
+    g_task_set_source_tag(task, esconf_init_async);
+
+    if(esconf_refcnt++ && g_atomic_pointer_get(&gproxy)) {
+        g_task_return_boolean(task, TRUE);
+        g_object_unref(task);
+        return;
+    }
+
+    g_bus_get(G_BUS_TYPE_SESSION, cancellable, esconf_init_bus_ready, task);
+}
+
+/**
+ * esconf_init_finish:
+ * @result: The #GAsyncResult passed to the esconf_init_async() callback.
+ * @error: An error return.
+ *
+ * Finishes an initialization started with esconf_init_async().
+ *
+ * Returns: %TRUE if the library was initialized succesfully, %FALSE on
+ *          error.  If there is an error @error will be set.
+ *
+ * Since: 1.0.0
+ **/
+gboolean
+esconf_init_finish(GAsyncResult *result,
+                   GError **error)
+{
+    g_return_val_if_fail(g_task_is_valid(result, NULL), FALSE);
+    g_return_val_if_fail(g_task_get_source_tag(G_TASK(result)) == esconf_init_async, FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
 /**
  * esconf_shutdown:
  *
@@ -157,7 +352,8 @@ esconf_shutdown(void)
     }
 
     /* Flush pending dbus calls */
-    g_dbus_connection_flush_sync (gdbus, NULL, NULL);
+    if(gdbus)
+        g_dbus_connection_flush_sync (gdbus, NULL, NULL);
 
     _esconf_channel_shutdown();
     _esconf_g_bindings_shutdown();
@@ -22,6 +22,7 @@
 #define __ESCONF_H__
 
 #include <glib.h>
+#include <gio/gio.h>
 
 #define ESCONF_IN_ESCONF_H
 
@@ -35,6 +36,11 @@
 G_BEGIN_DECLS
 
 gboolean esconf_init(GError **error);
+void esconf_init_async(GCancellable *cancellable,
+                       GAsyncReadyCallback callback,
+                       gpointer user_data);
+gboolean esconf_init_finish(GAsyncResult *result,
+                            GError **error);
 void esconf_shutdown(void);
 
 void esconf_named_struct_register(const gchar *struct_name,
@@ -37,8 +37,12 @@
 #ifdef BUILD_ESCONF_BACKEND_PERCHANNEL_XML
 #include "esconf-backend-perchannel-xml.h"
 #endif
+#include "esconf-backend-volatile.h"
 
 static GHashTable *backends = NULL;
+static EsconfBackendDurability backend_durability = ESCONF_BACKEND_DURABILITY_STRICT;
+static gchar **backend_preload_channels = NULL;
+static gchar *backend_snapshot = NULL;
 
 static void
 esconf_backend_factory_ensure_backends(void)
@@ -58,6 +62,14 @@ esconf_backend_factory_ensure_backends(void)
                             gtype);
     }
 #endif
+
+    {
+        GType *gtype = g_new(GType, 1);
+        *gtype = ESCONF_TYPE_BACKEND_VOLATILE;
+        g_hash_table_insert(backends,
+                            (gpointer)ESCONF_BACKEND_VOLATILE_TYPE_ID,
+                            gtype);
+    }
 }
 
 
@@ -67,6 +79,7 @@ esconf_backend_factory_get_backend(const gchar *type,
 {
     EsconfBackend *backend = NULL;
     GType *backend_gtype;
+    GObjectClass *backend_class;
     
     esconf_backend_factory_ensure_backends();
     
@@ -80,7 +93,23 @@ esconf_backend_factory_get_backend(const gchar *type,
         return NULL;
     }
     
-    backend = g_object_new(*backend_gtype, NULL);
+    backend_class = g_type_class_ref(*backend_gtype);
+    if(g_object_class_find_property(backend_class, "durability"))
+        backend = g_object_new(*backend_gtype, "durability", backend_durability, NULL);
+    else
+        backend = g_object_new(*backend_gtype, NULL);
+    if(backend_preload_channels
+       && g_object_class_find_property(backend_class, "preload-channels"))
+    {
+        g_object_set(backend, "preload-channels", backend_preload_channels, NULL);
+    }
+    if(backend_snapshot
+       && g_object_class_find_property(backend_class, "snapshot"))
+    {
+        g_object_set(backend, "snapshot", backend_snapshot, NULL);
+    }
+    g_type_class_unref(backend_class);
+
     if(!esconf_backend_initialize(backend, error)) {
         g_object_unref(G_OBJECT(backend));
         return NULL;
@@ -90,6 +119,42 @@ esconf_backend_factory_get_backend(const gchar *type,
 }
 
 
+/* applies to backends created after the call */
+void
+esconf_backend_factory_set_durability(EsconfBackendDurability durability)
+{
+    backend_durability = durability;
+}
+
+
+/* adds to the channels that backends created after the call should
+ * load in the background right away */
+void
+esconf_backend_factory_add_preload_channels(gchar **channels)
+{
+    guint n_old, n_new, i;
+
+    n_old = backend_preload_channels ? g_strv_length(backend_preload_channels) : 0;
+    n_new = g_strv_length(channels);
+
+    backend_preload_channels = g_renew(gchar *, backend_preload_channels,
+                                       n_old + n_new + 1);
+    for(i = 0; i < n_new; ++i)
+        backend_preload_channels[n_old + i] = g_strdup(channels[i]);
+    backend_preload_channels[n_old + n_new] = NULL;
+}
+
+
+/* file that backends created after the call, if they support it, read
+ * their initial contents from */
+void
+esconf_backend_factory_set_snapshot(const gchar *filename)
+{
+    g_free(backend_snapshot);
+    backend_snapshot = g_strdup(filename);
+}
+
+
 void
 esconf_backend_factory_cleanup (void)
 {
@@ -97,4 +162,9 @@ esconf_backend_factory_cleanup (void)
       g_hash_table_destroy(backends);
       backends = NULL;
   }
+
+  g_strfreev(backend_preload_channels);
+  backend_preload_channels = NULL;
+  g_free(backend_snapshot);
+  backend_snapshot = NULL;
 }
@@ -29,6 +29,12 @@ G_BEGIN_DECLS
 EsconfBackend *esconf_backend_factory_get_backend(const gchar *type,
                                                   GError **error);
 
+void esconf_backend_factory_set_durability(EsconfBackendDurability durability);
+
+void esconf_backend_factory_add_preload_channels(gchar **channels);
+
+void esconf_backend_factory_set_snapshot(const gchar *filename);
+
 void esconf_backend_factory_cleanup (void);
 
 G_END_DECLS
@@ -51,6 +51,8 @@
 #include <fcntl.h>
 #endif
 
+#include <gio/gio.h>
+
 #include <libexpidus1util/libexpidus1util.h>
 
 #include "esconf-backend-perchannel-xml.h"
@@ -69,7 +71,12 @@
 #define CONFIG_FILE_FMT  CONFIG_DIR_STEM "%s.xml"
 #define CACHE_TIMEOUT    (20*60*1000)  /* 20 minutes */
 #define WRITE_TIMEOUT    (5)  /* 5 seconds */
+#define RELOAD_TIMEOUT   (500)  /* milliseconds */
 #define MAX_PROP_PATH    (4096)
+#define WRITE_BUF_KEEP_SIZE  (1024*1024)
+#define ARENA_BLOCK_NODES    (256)
+#define ARENA_STRINGS_SIZE   (4096)
+#define PRELOAD_MAX_THREADS  (4)
 
 struct _EsconfBackendPerchannelXml
 {
@@ -78,11 +85,36 @@ struct _EsconfBackendPerchannelXml
     gchar *config_save_path;
 
     GHashTable *channels;
+    /* channel name -> EsconfSystemLayer */
+    GHashTable *system_layers;
 
     guint save_id;
+    /* scratch buffer channels are rendered into before writing */
+    GString *write_buf;
+
+    /* monitors on the config dirs, and the channels whose files
+     * changed since the last reload */
+    GList *monitors;
+    GHashTable *pending_reloads;
+    guint reload_id;
+
+    EsconfBackendDurability durability;
+
+    /* channels read ahead of time on a thread pool.  the hash table
+     * is only used from the main thread; the lock guards the done and
+     * channel members of the EsconfPreloads, and preload_idle_id */
+    gchar **preload_channels;
+    GThreadPool *preload_pool;
+    GHashTable *preloads;
+    GMutex preload_lock;
+    GCond preload_cond;
+    guint preload_idle_id;
 
     EsconfPropertyChangedFunc prop_changed_func;
     gpointer prop_changed_data;
+
+    EsconfChannelReloadedFunc channel_reloaded_func;
+    gpointer channel_reloaded_data;
 };
 
 typedef struct _EsconfBackendPerchannelXmlClass
@@ -90,21 +122,164 @@ typedef struct _EsconfBackendPerchannelXmlClass
     GObjectClass parent;
 } EsconfBackendPerchannelXmlClass;
 
+typedef struct _EsconfPropertyNode EsconfPropertyNode;
+
+/* the storage of one property tree: nodes are carved out of big blocks
+ * and recycled through a free list, and property names, as well as the
+ * string values read from files, are interned in a string chunk.  so a
+ * tree is built with a few large allocations and goes away in one go,
+ * with the values that live outside the arena as the only exception. */
+typedef struct
+{
+    GSList *blocks;
+    EsconfPropertyNode *block_pos;
+    guint block_left;
+    EsconfPropertyNode *free_nodes;
+    GStringChunk *strings;
+    /* some value in the tree was allocated on its own */
+    gboolean owns_values;
+} EsconfArena;
+
+/* the merged contents of the system-wide files of a channel.  it is
+ * parsed once and then shared, read-only, by every load of the channel
+ * until one of the files changes: the property trees of loaded channels
+ * refer to its strings and arrays for their system values instead of
+ * holding copies (see esconf_system_layer_instantiate()). */
+typedef struct
+{
+    gint ref_count;
+    /* EsconfFileStamp of each file, in the order they were merged */
+    GArray *files;
+    EsconfArena *arena;
+    EsconfPropertyNode *properties;
+    gboolean locked;
+} EsconfSystemLayer;
+
+/* identifies a version of a file on disk */
+typedef struct
+{
+    gchar *path;
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    /* 0 where the system only has whole seconds */
+    glong mtime_nsec;
+    off_t size;
+} EsconfFileStamp;
+
 typedef struct
 {
-    GNode *properties;
+    EsconfArena *arena;
+    EsconfPropertyNode *properties;
+    EsconfSystemLayer *system_layer;
+    /* the user file as it was last read or written */
+    EsconfFileStamp user_file;
     gboolean locked;
     gboolean dirty;
 } EsconfChannel;
 
+/* a channel file that has been written under a temporary name, but not
+ * put in place yet */
+typedef struct
+{
+    const gchar *channel_name;
+    EsconfChannel *channel;
+    gchar *filename;
+    gchar *filename_tmp;
+    gint fd;
+} EsconfChannelWrite;
+
+/* a channel being read by the preload thread pool.  the files are
+ * looked up beforehand on the main thread. */
+typedef struct
+{
+    gchar *channel_name;
+    gchar **filenames;
+    gchar *user_file;
+    EsconfChannel *channel;
+    gboolean done;
+    /* the files changed while they were being read; main thread only */
+    gboolean stale;
+} EsconfPreload;
+
+/* what an EsconfValueData holds */
+typedef enum
+{
+    ESCONF_VALUE_UNSET = 0,
+    ESCONF_VALUE_STRING,
+    ESCONF_VALUE_BOOLEAN,
+    ESCONF_VALUE_UCHAR,
+    ESCONF_VALUE_CHAR,
+    ESCONF_VALUE_UINT16,
+    ESCONF_VALUE_INT16,
+    ESCONF_VALUE_UINT,
+    ESCONF_VALUE_INT,
+    ESCONF_VALUE_UINT64,
+    ESCONF_VALUE_INT64,
+    ESCONF_VALUE_FLOAT,
+    ESCONF_VALUE_DOUBLE,
+    ESCONF_VALUE_ARRAY,
+    /* any other type, in a GValue of its own */
+    ESCONF_VALUE_OTHER,
+} EsconfValueType;
+
+typedef union
+{
+    gboolean b;
+    guchar uc;
+    gchar c;
+    guint16 u16;
+    gint16 i16;
+    guint u;
+    gint i;
+    guint64 u64;
+    gint64 i64;
+    gfloat f;
+    gdouble d;
+    gchar *str;
+    GPtrArray *arr;
+    GValue *other;
+} EsconfValueData;
+
+/* there is one of these for every node of every loaded channel, so it
+ * is kept small: instead of two GValues, the values are untyped unions
+ * whose EsconfValueType is packed together with the flags.  use
+ * esconf_value_data_peek() to look at a value as a GValue. */
 typedef struct
 {
     gchar *name;
-    GValue value;
-    GValue system_value;
-    gboolean locked;
+    guint value_type : 4;
+    guint system_value_type : 4;
+    guint locked : 1;
+    /* value lives in the arena, system_value in the arena or the
+     * channel's system layer */
+    guint value_borrowed : 1;
+    guint system_borrowed : 1;
+    EsconfValueData value;
+    EsconfValueData system_value;
 } EsconfProperty;
 
+/* a node of a property tree.  it does what a GNode would, with the
+ * property stored in it instead of behind a data pointer, and without
+ * a link to the previous sibling, which nothing needs often enough to
+ * pay for it in every node: 24 bytes of links instead of 40. */
+struct _EsconfPropertyNode
+{
+    EsconfPropertyNode *parent;
+    /* the first child */
+    EsconfPropertyNode *children;
+    EsconfPropertyNode *next;
+    EsconfProperty prop;
+};
+
+/* return TRUE to stop the traversal */
+typedef gboolean (*EsconfProptreeFunc)(EsconfPropertyNode *node,
+                                       gpointer data);
+
+#define ESCONF_VALUE_TYPE_IS_ALLOCATED(type)  ((type) == ESCONF_VALUE_STRING \
+                                               || (type) == ESCONF_VALUE_ARRAY \
+                                               || (type) == ESCONF_VALUE_OTHER)
+
 typedef enum
 {
     ELEM_NONE = 0,
@@ -114,7 +289,7 @@ typedef enum
 } XmlParserElem;
 
 /* FIXME: due to the hierarchical nature of the file, i need to use a
- * stack for list_property and list_value because  more than one array
+ * stack for list_node and list_value because  more than one array
  * property can be open at once.  the current xml file writer always
  * puts the <value> elements right after the opening <property>, but it's
  * possible someone could edit the file so that's not the case anymore. */
@@ -124,11 +299,28 @@ typedef struct
     EsconfChannel *channel;
     gboolean is_system_file;
     XmlParserElem cur_elem;
-    gchar cur_path[MAX_PROP_PATH];
-    gchar *list_property;
-    GValue *list_value;
+    /* node of the innermost open <property>, or the root node; new
+     * properties are looked up among and added to its children */
+    EsconfPropertyNode *cur_node;
+    EsconfPropertyNode *list_node;
+    GPtrArray *list_array;
 } XmlParserState;
 
+enum
+{
+    PROP0 = 0,
+    PROP_DURABILITY,
+    PROP_PRELOAD_CHANNELS,
+};
+
+static void esconf_backend_perchannel_xml_set_property(GObject *object,
+                                                       guint property_id,
+                                                       const GValue *value,
+                                                       GParamSpec *pspec);
+static void esconf_backend_perchannel_xml_get_property(GObject *object,
+                                                       guint property_id,
+                                                       GValue *value,
+                                                       GParamSpec *pspec);
 static void esconf_backend_perchannel_xml_finalize(GObject *obj);
 
 static void esconf_backend_perchannel_xml_backend_init(EsconfBackendInterface *iface);
@@ -168,42 +360,93 @@ static gboolean esconf_backend_perchannel_xml_is_property_locked(EsconfBackend *
                                                                  const gchar *property,
                                                                  gboolean *locked,
                                                                  GError **error);
+static gboolean esconf_backend_perchannel_xml_get_locks(EsconfBackend *backend,
+                                                        const gchar *channel_name,
+                                                        gboolean *channel_locked,
+                                                        GSList **locked_properties,
+                                                        GError **error);
 static gboolean esconf_backend_perchannel_xml_flush(EsconfBackend *backend,
                                                     GError **error);
 static void esconf_backend_perchannel_xml_register_property_changed_func(EsconfBackend *backend,
                                                                          EsconfPropertyChangedFunc func,
                                                                          gpointer user_data);
+static void esconf_backend_perchannel_xml_register_channel_reloaded_func(EsconfBackend *backend,
+                                                                         EsconfChannelReloadedFunc func,
+                                                                         gpointer user_data);
 
 static void esconf_backend_perchannel_xml_schedule_save(EsconfBackendPerchannelXml *xbpx,
                                                         EsconfChannel *channel);
 
 static EsconfChannel *esconf_backend_perchannel_xml_create_channel(EsconfBackendPerchannelXml *xbpx,
                                                                    const gchar *channel_name);
+static EsconfChannel *esconf_backend_perchannel_xml_read_channel(EsconfBackendPerchannelXml *xbpx,
+                                                                 const gchar *channel_name,
+                                                                 GError **error);
 static EsconfChannel *esconf_backend_perchannel_xml_load_channel(EsconfBackendPerchannelXml *xbpx,
                                                                  const gchar *channel_name,
                                                                  GError **error);
+static gboolean esconf_backend_perchannel_xml_flush_channels_grouped(EsconfBackendPerchannelXml *xbpx,
+                                                                     GSList *channel_names,
+                                                                     GError **error);
 static gboolean esconf_backend_perchannel_xml_flush_channel(EsconfBackendPerchannelXml *xbpx,
                                                             const gchar *channel_name,
                                                             GError **error);
 
-static GNode *esconf_proptree_add_property(GNode *proptree,
-                                           const gchar *name,
-                                           const GValue *value,
-                                           const GValue *system_value,
-                                           gboolean locked);
-static EsconfProperty *esconf_proptree_lookup(GNode *proptree,
+static EsconfPropertyNode *esconf_proptree_add_property(EsconfChannel *channel,
+                                                        const gchar *name,
+                                                        const GValue *value,
+                                                        const GValue *system_value,
+                                                        gboolean locked);
+static EsconfProperty *esconf_proptree_lookup(EsconfPropertyNode *proptree,
                                               const gchar *name);
-static GNode *esconf_proptree_lookup_node(GNode *proptree,
-                                          const gchar *name);
-static gboolean esconf_proptree_reset(GNode *proptree,
+static EsconfPropertyNode *esconf_proptree_lookup_node(EsconfPropertyNode *proptree,
+                                                       const gchar *name);
+static gboolean esconf_proptree_reset(EsconfChannel *channel,
                                       const gchar *name);
-static void esconf_proptree_destroy(GNode *proptree);
-static gchar *esconf_proptree_build_propname(GNode *prop_node,
+static gboolean esconf_proptree_reset_node(EsconfArena *arena,
+                                           EsconfPropertyNode *node);
+static void esconf_proptree_destroy(EsconfArena *arena,
+                                    EsconfPropertyNode *proptree);
+static void esconf_proptree_clear_values(EsconfPropertyNode *proptree);
+static gchar *esconf_proptree_build_propname(EsconfPropertyNode *prop_node,
                                              gchar *buf,
                                              gsize buflen);
 
+static EsconfChannel *esconf_channel_new(void);
 static void esconf_channel_destroy(EsconfChannel *channel);
-static void esconf_property_free(EsconfProperty *property);
+static void esconf_system_layer_unref(EsconfSystemLayer *layer);
+static EsconfArena *esconf_arena_new(void);
+static void esconf_arena_free(EsconfArena *arena);
+static inline gchar *esconf_arena_intern(EsconfArena *arena,
+                                         const gchar *str);
+static EsconfPropertyNode *esconf_arena_new_node(EsconfArena *arena,
+                                                 gchar *name);
+static inline void esconf_arena_free_node(EsconfArena *arena,
+                                          EsconfPropertyNode *node);
+static EsconfPropertyNode *esconf_proptree_append(EsconfPropertyNode *parent,
+                                                  EsconfPropertyNode *node);
+static void esconf_proptree_unlink(EsconfPropertyNode *node);
+static guint esconf_proptree_n_children(EsconfPropertyNode *node);
+static gboolean esconf_proptree_traverse(EsconfPropertyNode *node,
+                                         gboolean children_first,
+                                         EsconfProptreeFunc func,
+                                         gpointer data);
+static guint esconf_value_data_set(EsconfValueData *data,
+                                   const GValue *value);
+static const GValue *esconf_value_data_peek(const EsconfValueData *data,
+                                            guint type,
+                                            GValue *view);
+static void esconf_property_set_value(EsconfArena *arena,
+                                      EsconfProperty *prop,
+                                      const GValue *value);
+static void esconf_property_unset_value(EsconfProperty *prop);
+static void esconf_property_unset_system_value(EsconfProperty *prop);
+static const GValue *esconf_property_peek_effective_value(const EsconfProperty *prop,
+                                                          GValue *view);
+
+static void esconf_backend_perchannel_xml_watch_dirs(EsconfBackendPerchannelXml *xbpx);
+static void esconf_backend_perchannel_xml_start_preload(EsconfBackendPerchannelXml *xbpx);
+static void esconf_preload_free(EsconfPreload *preload);
 
 
 G_DEFINE_TYPE_WITH_CODE(EsconfBackendPerchannelXml, esconf_backend_perchannel_xml, G_TYPE_OBJECT,
@@ -216,7 +459,32 @@ esconf_backend_perchannel_xml_class_init(EsconfBackendPerchannelXmlClass *klass)
 {
     GObjectClass *object_class = (GObjectClass *)klass;
 
+    object_class->set_property = esconf_backend_perchannel_xml_set_property;
+    object_class->get_property = esconf_backend_perchannel_xml_get_property;
     object_class->finalize = esconf_backend_perchannel_xml_finalize;
+
+    /* how hard flushes try to make sure channels hit the disk, one of
+     * #EsconfBackendDurability */
+    g_object_class_install_property(object_class, PROP_DURABILITY,
+                                    g_param_spec_int("durability",
+                                                     "Durability",
+                                                     "How channels are synced to disk",
+                                                     ESCONF_BACKEND_DURABILITY_STRICT,
+                                                     ESCONF_BACKEND_DURABILITY_RELAXED,
+                                                     ESCONF_BACKEND_DURABILITY_STRICT,
+                                                     G_PARAM_READWRITE
+                                                     | G_PARAM_CONSTRUCT
+                                                     | G_PARAM_STATIC_STRINGS));
+
+    /* channels to read in the background as soon as the backend is
+     * initialized, so the first access to them doesn't have to */
+    g_object_class_install_property(object_class, PROP_PRELOAD_CHANNELS,
+                                    g_param_spec_boxed("preload-channels",
+                                                       "Preload channels",
+                                                       "Channels to load at startup",
+                                                       G_TYPE_STRV,
+                                                       G_PARAM_READWRITE
+                                                       | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -225,6 +493,58 @@ esconf_backend_perchannel_xml_init(EsconfBackendPerchannelXml *instance)
     instance->channels = g_hash_table_new_full(g_str_hash, g_str_equal,
                                                (GDestroyNotify)g_free,
                                                 (GDestroyNotify)esconf_channel_destroy);
+    instance->system_layers = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                    (GDestroyNotify)g_free,
+                                                    (GDestroyNotify)esconf_system_layer_unref);
+    g_mutex_init(&instance->preload_lock);
+    g_cond_init(&instance->preload_cond);
+}
+
+static void
+esconf_backend_perchannel_xml_set_property(GObject *object,
+                                           guint property_id,
+                                           const GValue *value,
+                                           GParamSpec *pspec)
+{
+    EsconfBackendPerchannelXml *xbpx = ESCONF_BACKEND_PERCHANNEL_XML(object);
+
+    switch(property_id) {
+        case PROP_DURABILITY:
+            xbpx->durability = g_value_get_int(value);
+            break;
+
+        case PROP_PRELOAD_CHANNELS:
+            g_strfreev(xbpx->preload_channels);
+            xbpx->preload_channels = g_value_dup_boxed(value);
+            break;
+
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+esconf_backend_perchannel_xml_get_property(GObject *object,
+                                           guint property_id,
+                                           GValue *value,
+                                           GParamSpec *pspec)
+{
+    EsconfBackendPerchannelXml *xbpx = ESCONF_BACKEND_PERCHANNEL_XML(object);
+
+    switch(property_id) {
+        case PROP_DURABILITY:
+            g_value_set_int(value, xbpx->durability);
+            break;
+
+        case PROP_PRELOAD_CHANNELS:
+            g_value_set_boxed(value, xbpx->preload_channels);
+            break;
+
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+            break;
+    }
 }
 
 static void
@@ -238,7 +558,28 @@ esconf_backend_perchannel_xml_finalize(GObject *obj)
         esconf_backend_perchannel_xml_flush(ESCONF_BACKEND(xbpx), NULL);
     }
 
+    if(xbpx->reload_id)
+        g_source_remove(xbpx->reload_id);
+    if(xbpx->pending_reloads)
+        g_hash_table_destroy(xbpx->pending_reloads);
+    g_list_free_full(xbpx->monitors, g_object_unref);
+
+    /* queued preloads are dropped, running ones waited for */
+    if(xbpx->preload_pool)
+        g_thread_pool_free(xbpx->preload_pool, TRUE, TRUE);
+    if(xbpx->preload_idle_id)
+        g_source_remove(xbpx->preload_idle_id);
+    if(xbpx->preloads)
+        g_hash_table_destroy(xbpx->preloads);
+    g_strfreev(xbpx->preload_channels);
+    g_mutex_clear(&xbpx->preload_lock);
+    g_cond_clear(&xbpx->preload_cond);
+
     g_hash_table_destroy(xbpx->channels);
+    g_hash_table_destroy(xbpx->system_layers);
+
+    if(xbpx->write_buf)
+        g_string_free(xbpx->write_buf, TRUE);
 
     g_free(xbpx->config_save_path);
 
@@ -258,6 +599,8 @@ esconf_backend_perchannel_xml_backend_init(EsconfBackendInterface *iface)
     iface->is_property_locked = esconf_backend_perchannel_xml_is_property_locked;
     iface->flush = esconf_backend_perchannel_xml_flush;
     iface->register_property_changed_func = esconf_backend_perchannel_xml_register_property_changed_func;
+    iface->get_locks = esconf_backend_perchannel_xml_get_locks;
+    iface->register_channel_reloaded_func = esconf_backend_perchannel_xml_register_channel_reloaded_func;
 }
 
 static gboolean
@@ -282,6 +625,11 @@ esconf_backend_perchannel_xml_initialize(EsconfBackend *backend,
 
     backend_px->config_save_path = path;
 
+    esconf_backend_perchannel_xml_watch_dirs(backend_px);
+
+    if(backend_px->preload_channels && backend_px->preload_channels[0])
+        esconf_backend_perchannel_xml_start_preload(backend_px);
+
     return TRUE;
 }
 
@@ -295,6 +643,7 @@ esconf_backend_perchannel_xml_set(EsconfBackend *backend,
     EsconfBackendPerchannelXml *xbpx = ESCONF_BACKEND_PERCHANNEL_XML(backend);
     EsconfChannel *channel = g_hash_table_lookup(xbpx->channels, channel_name);
     EsconfProperty *cur_prop;
+    GValue view = { 0, };
 
     if(!channel) {
         channel = esconf_backend_perchannel_xml_load_channel(xbpx, channel_name,
@@ -324,22 +673,18 @@ esconf_backend_perchannel_xml_set(EsconfBackend *backend,
             return FALSE;
         }
 
-        if(_esconf_gvalue_is_equal(G_VALUE_TYPE(&cur_prop->value)
-                                   ? &cur_prop->value
-                                   : &cur_prop->system_value, value))
+        if(_esconf_gvalue_is_equal(esconf_property_peek_effective_value(cur_prop, &view),
+                                   value))
         {
             return TRUE;
         }
 
-        if(G_VALUE_TYPE(&cur_prop->value))
-            g_value_unset(&cur_prop->value);
-        g_value_copy(value, g_value_init(&cur_prop->value,
-                                         G_VALUE_TYPE(value)));
+        esconf_property_set_value(channel->arena, cur_prop, value);
 
         if(xbpx->prop_changed_func)
             xbpx->prop_changed_func(backend, channel_name, property, xbpx->prop_changed_data);
     } else {
-        esconf_proptree_add_property(channel->properties, property, value,
+        esconf_proptree_add_property(channel, property, value,
                                      NULL, FALSE);
         if(xbpx->prop_changed_func)
             xbpx->prop_changed_func(backend, channel_name, property, xbpx->prop_changed_data);
@@ -360,7 +705,8 @@ esconf_backend_perchannel_xml_get(EsconfBackend *backend,
     EsconfBackendPerchannelXml *xbpx = ESCONF_BACKEND_PERCHANNEL_XML(backend);
     EsconfChannel *channel = g_hash_table_lookup(xbpx->channels, channel_name);
     EsconfProperty *cur_prop;
-    GValue *value_to_get = NULL;
+    const GValue *value_to_get = NULL;
+    GValue view = { 0, };
 
     TRACE("entering");
 
@@ -372,12 +718,8 @@ esconf_backend_perchannel_xml_get(EsconfBackend *backend,
     }
 
     cur_prop = esconf_proptree_lookup(channel->properties, property);
-    if(cur_prop) {
-        if(G_VALUE_TYPE(&cur_prop->value))
-            value_to_get = &cur_prop->value;
-        else if(G_VALUE_TYPE(&cur_prop->system_value))
-            value_to_get = &cur_prop->system_value;
-    }
+    if(cur_prop)
+        value_to_get = esconf_property_peek_effective_value(cur_prop, &view);
 
     if(!value_to_get) {
         if(error) {
@@ -395,18 +737,15 @@ esconf_backend_perchannel_xml_get(EsconfBackend *backend,
 }
 
 static void
-esconf_proptree_node_to_hash_table(GNode *node,
+esconf_proptree_node_to_hash_table(EsconfPropertyNode *node,
                                    GHashTable *props_hash,
                                    gchar cur_path[MAX_PROP_PATH])
 {
-    EsconfProperty *prop = node->data;
-    GValue *value_to_get = NULL;
-
-    if(G_VALUE_TYPE(&prop->value))
-        value_to_get = &prop->value;
-    else if(G_VALUE_TYPE(&prop->system_value))
-        value_to_get = &prop->system_value;
+    EsconfProperty *prop = &node->prop;
+    const GValue *value_to_get;
+    GValue view = { 0, };
 
+    value_to_get = esconf_property_peek_effective_value(prop, &view);
     if(value_to_get) {
         GValue *value = g_new0(GValue, 1);
         gchar *fullprop;
@@ -418,7 +757,7 @@ esconf_proptree_node_to_hash_table(GNode *node,
     }
 
     if(node->children) {
-        GNode *cur;
+        EsconfPropertyNode *cur;
         gchar *p;
 
         if(prop->name[0] != '/') {
@@ -426,10 +765,7 @@ esconf_proptree_node_to_hash_table(GNode *node,
             g_strlcat(cur_path, prop->name, MAX_PROP_PATH);
         }
 
-        for(cur = g_node_first_child(node);
-            cur;
-            cur = g_node_next_sibling(cur))
-        {
+        for(cur = node->children; cur; cur = cur->next) {
             esconf_proptree_node_to_hash_table(cur, props_hash, cur_path);
         }
 
@@ -448,7 +784,7 @@ esconf_backend_perchannel_xml_get_all(EsconfBackend *backend,
 {
     EsconfBackendPerchannelXml *xbpx = ESCONF_BACKEND_PERCHANNEL_XML(backend);
     EsconfChannel *channel = g_hash_table_lookup(xbpx->channels, channel_name);
-    GNode *props_tree;
+    EsconfPropertyNode *props_tree;
     gchar cur_path[MAX_PROP_PATH], *p;
 
     if(!channel) {
@@ -513,8 +849,7 @@ esconf_backend_perchannel_xml_exists(EsconfBackend *backend,
     }
 
     prop = esconf_proptree_lookup(channel->properties, property);
-    *exists = (prop && (G_VALUE_TYPE(&prop->value)
-                        || G_VALUE_TYPE(&prop->system_value))
+    *exists = (prop && (prop->value_type || prop->system_value_type)
                ? TRUE : FALSE);
 
     return TRUE;
@@ -527,18 +862,18 @@ typedef struct
 } PropChangeData;
 
 static gboolean
-nodes_do_prop_reset(GNode *node,
+nodes_do_prop_reset(EsconfPropertyNode *node,
                     gpointer data)
 {
     PropChangeData *pdata = data;
-    EsconfProperty *prop = node->data;
+    EsconfProperty *prop = &node->prop;
     gchar prop_fullname[MAX_PROP_PATH];
 
 
     /* we don't signal if |value| isn't set but |system_value| is,
      * because we're not actually changing anything by definition */
-    if(G_VALUE_TYPE(&prop->value)) {
-        g_value_unset(&prop->value);
+    if(prop->value_type) {
+        esconf_property_unset_value(prop);
         if(pdata->xbpx->prop_changed_func) {
             pdata->xbpx->prop_changed_func(ESCONF_BACKEND(pdata->xbpx),
                                            pdata->channel_name,
@@ -553,18 +888,18 @@ nodes_do_prop_reset(GNode *node,
 }
 
 static gboolean
-nodes_clean_up(GNode *node,
+nodes_clean_up(EsconfPropertyNode *node,
                gpointer data)
 {
-    EsconfProperty *prop = node->data;
+    EsconfProperty *prop = &node->prop;
 
     /* clean up dangling nodes in tree without system defaults */
     if(!node->children
-       && !G_VALUE_TYPE(&prop->value)
-       && !G_VALUE_TYPE(&prop->system_value)
+       && !prop->value_type
+       && !prop->system_value_type
        && !prop->locked) {
-        g_node_unlink(node);
-        esconf_proptree_destroy(node);
+        esconf_proptree_unlink(node);
+        esconf_proptree_destroy(data, node);
     }
 
     return FALSE;
@@ -573,7 +908,7 @@ nodes_clean_up(GNode *node,
 static gboolean
 do_reset_channel(EsconfBackend *backend,
                  const gchar *channel_name,
-                 GNode *properties,
+                 EsconfPropertyNode *properties,
                  GError **error)
 {
     EsconfBackendPerchannelXml *xbpx = ESCONF_BACKEND_PERCHANNEL_XML(backend);
@@ -582,8 +917,8 @@ do_reset_channel(EsconfBackend *backend,
 
     pdata.xbpx = xbpx;
     pdata.channel_name = channel_name;
-    g_node_traverse(properties, G_POST_ORDER, G_TRAVERSE_ALL, -1,
-                    nodes_do_prop_reset, &pdata);
+    esconf_proptree_traverse(properties, TRUE,
+                             nodes_do_prop_reset, &pdata);
 
     /* we could probably prune the existing proptree, or even just leave
      * it as-is, but it's easier to just kill it.  it'll get reloaded later
@@ -626,7 +961,7 @@ esconf_backend_perchannel_xml_reset(EsconfBackend *backend,
     }
 
     if(!recursive) {
-        if(!esconf_proptree_reset(channel->properties, property)) {
+        if(!esconf_proptree_reset(channel, property)) {
             if(error) {
                 g_set_error(error, ESCONF_ERROR,
                             ESCONF_ERROR_PROPERTY_NOT_FOUND,
@@ -639,7 +974,7 @@ esconf_backend_perchannel_xml_reset(EsconfBackend *backend,
         if(xbpx->prop_changed_func)  /* FIXME: this could fire spuriously */
             xbpx->prop_changed_func(backend, channel_name, property, xbpx->prop_changed_data);
     } else {
-        GNode *top;
+        EsconfPropertyNode *top;
         
         if(property[0] && property[1]) {
             PropChangeData pdata;
@@ -658,12 +993,12 @@ esconf_backend_perchannel_xml_reset(EsconfBackend *backend,
 
             pdata.xbpx = xbpx;
             pdata.channel_name = channel_name;
-            g_node_traverse(top, G_POST_ORDER, G_TRAVERSE_ALL, -1,
-                            nodes_do_prop_reset, &pdata);
+            esconf_proptree_traverse(top, TRUE,
+                                     nodes_do_prop_reset, &pdata);
 
             /* clean up dangling nodes in tree without system defaults */
-            g_node_traverse(top, G_POST_ORDER, G_TRAVERSE_ALL, -1,
-                            nodes_clean_up, NULL);
+            esconf_proptree_traverse(top, TRUE,
+                                     nodes_clean_up, channel->arena);
         } else {
             /* remove the entire channel */
             return do_reset_channel(backend, channel_name,
@@ -737,6 +1072,59 @@ esconf_backend_perchannel_xml_is_property_locked(EsconfBackend *backend,
     return TRUE;
 }
 
+static gboolean
+esconf_proptree_collect_locked(EsconfPropertyNode *node,
+                               gpointer data)
+{
+    EsconfProperty *prop = &node->prop;
+    GSList **locked_properties = data;
+    gchar buf[MAX_PROP_PATH];
+
+    if(prop->locked && node->parent) {
+        esconf_proptree_build_propname(node, buf, sizeof(buf));
+        *locked_properties = g_slist_prepend(*locked_properties, g_strdup(buf));
+    }
+
+    return FALSE;
+}
+
+static gboolean
+esconf_backend_perchannel_xml_get_locks(EsconfBackend *backend,
+                                        const gchar *channel_name,
+                                        gboolean *channel_locked,
+                                        GSList **locked_properties,
+                                        GError **error)
+{
+    EsconfBackendPerchannelXml *xbpx = ESCONF_BACKEND_PERCHANNEL_XML(backend);
+    EsconfChannel *channel = g_hash_table_lookup(xbpx->channels, channel_name);
+    GError *error1 = NULL;
+
+    if(!channel) {
+        channel = esconf_backend_perchannel_xml_load_channel(xbpx, channel_name,
+                                                             &error1);
+        if(!channel) {
+            if(g_error_matches(error1, ESCONF_ERROR,
+                               ESCONF_ERROR_CHANNEL_NOT_FOUND))
+            {
+                /* nothing to lock */
+                g_error_free(error1);
+                *channel_locked = FALSE;
+                return TRUE;
+            }
+            g_propagate_error(error, error1);
+            return FALSE;
+        }
+    }
+
+    *channel_locked = channel->locked;
+    if(!channel->locked) {
+        esconf_proptree_traverse(channel->properties, FALSE,
+                                 esconf_proptree_collect_locked, locked_properties);
+    }
+
+    return TRUE;
+}
+
 static void
 esconf_backend_perchannel_xml_flush_get_dirty(gpointer key,
                                               gpointer value,
@@ -757,8 +1145,14 @@ esconf_backend_perchannel_xml_flush(EsconfBackend *backend,
 
     g_hash_table_foreach(xbpx->channels, esconf_backend_perchannel_xml_flush_get_dirty, &dirty);
 
-    for(l = dirty; l; l = l->next)
-        esconf_backend_perchannel_xml_flush_channel(xbpx, l->data, error);
+    if(xbpx->durability == ESCONF_BACKEND_DURABILITY_GROUPED
+       && dirty && dirty->next)
+    {
+        esconf_backend_perchannel_xml_flush_channels_grouped(xbpx, dirty, error);
+    } else {
+        for(l = dirty; l; l = l->next)
+            esconf_backend_perchannel_xml_flush_channel(xbpx, l->data, error);
+    }
     g_slist_free(dirty);
 
     TRACE("exiting, flushed all channels");
@@ -777,15 +1171,26 @@ esconf_backend_perchannel_xml_register_property_changed_func(EsconfBackend *back
     xbpx->prop_changed_data = user_data;
 }
 
+static void
+esconf_backend_perchannel_xml_register_channel_reloaded_func(EsconfBackend *backend,
+                                                             EsconfChannelReloadedFunc func,
+                                                             gpointer user_data)
+{
+    EsconfBackendPerchannelXml *xbpx = ESCONF_BACKEND_PERCHANNEL_XML(backend);
+
+    xbpx->channel_reloaded_func = func;
+    xbpx->channel_reloaded_data = user_data;
+}
+
 
 
-static GNode *
-esconf_proptree_lookup_node(GNode *proptree,
+static EsconfPropertyNode *
+esconf_proptree_lookup_node(EsconfPropertyNode *proptree,
                             const gchar *name)
 {
-    GNode *found_node = NULL;
+    EsconfPropertyNode *found_node = NULL;
     gchar **parts;
-    GNode *parent, *node;
+    EsconfPropertyNode *parent, *node;
     gint i;
 
     g_return_val_if_fail(PROP_NAME_IS_VALID(name), NULL);
@@ -794,11 +1199,8 @@ esconf_proptree_lookup_node(GNode *proptree,
     parent = proptree;
 
     for(i = 0; parts[i]; ++i) {
-        for(node = g_node_first_child(parent);
-            node;
-            node = g_node_next_sibling(node))
-        {
-            if(!strcmp(((EsconfProperty *)node->data)->name, parts[i])) {
+        for(node = parent->children; node; node = node->next) {
+            if(!strcmp(node->prop.name, parts[i])) {
                 if(!parts[i+1])
                     found_node = node;
                 else
@@ -817,28 +1219,28 @@ esconf_proptree_lookup_node(GNode *proptree,
 }
 
 static EsconfProperty *
-esconf_proptree_lookup(GNode *proptree,
+esconf_proptree_lookup(EsconfPropertyNode *proptree,
                        const gchar *name)
 {
-    GNode *node;
+    EsconfPropertyNode *node;
     EsconfProperty *prop = NULL;
 
     node = esconf_proptree_lookup_node(proptree, name);
     if(node)
-        prop = node->data;
+        prop = &node->prop;
 
     return prop;
 }
 
 /* here we assume the entry does not already exist */
-static GNode *
-esconf_proptree_add_property(GNode *proptree,
+static EsconfPropertyNode *
+esconf_proptree_add_property(EsconfChannel *channel,
                              const gchar *name,
                              const GValue *value,
                              const GValue *system_value,
                              gboolean locked)
 {
-    GNode *parent = NULL;
+    EsconfPropertyNode *parent = NULL, *node;
     gchar tmp[MAX_PROP_PATH];
     gchar *p;
     EsconfProperty *prop;
@@ -848,60 +1250,67 @@ esconf_proptree_add_property(GNode *proptree,
     g_strlcpy(tmp, name, MAX_PROP_PATH);
     p = g_strrstr(tmp, "/");
     if(p == tmp)
-        parent = proptree;
+        parent = channel->properties;
     else {
         *p = 0;
-        parent = esconf_proptree_lookup_node(proptree, tmp);
+        parent = esconf_proptree_lookup_node(channel->properties, tmp);
         if(!parent)
-            parent = esconf_proptree_add_property(proptree, tmp, NULL, NULL, FALSE);
+            parent = esconf_proptree_add_property(channel, tmp, NULL, NULL, FALSE);
     }
 
-    prop = g_slice_new0(EsconfProperty);
-    prop->name = g_strdup(strrchr(name, '/')+1);
-    if(value) {
-        g_value_init(&prop->value, G_VALUE_TYPE(value));
-        g_value_copy(value, &prop->value);
-    }
+    node = esconf_arena_new_node(channel->arena,
+                                 esconf_arena_intern(channel->arena,
+                                                     strrchr(name, '/')+1));
+    prop = &node->prop;
+    if(value)
+        esconf_property_set_value(channel->arena, prop, value);
     prop->locked = locked;
 
-    return g_node_append_data(parent, prop);
+    return esconf_proptree_append(parent, node);
 }
 
 static gboolean
-esconf_proptree_reset(GNode *proptree,
+esconf_proptree_reset(EsconfChannel *channel,
                       const gchar *name)
 {
-    GNode *node = esconf_proptree_lookup_node(proptree, name);
+    return esconf_proptree_reset_node(channel->arena,
+                                      esconf_proptree_lookup_node(channel->properties,
+                                                                  name));
+}
 
+static gboolean
+esconf_proptree_reset_node(EsconfArena *arena,
+                           EsconfPropertyNode *node)
+{
     if(node) {
-        EsconfProperty *prop = node->data;
+        EsconfProperty *prop = &node->prop;
 
-        if(G_IS_VALUE(&prop->value)) {
-            if(node->children || G_VALUE_TYPE(&prop->system_value)) {
+        if(prop->value_type) {
+            if(node->children || prop->system_value_type) {
                 /* don't remove the children; just blank out the value */
                 DBG("unsetting value at \"%s\"", prop->name);
-                g_value_unset(&prop->value);
+                esconf_property_unset_value(prop);
             } else {
-                GNode *parent = node->parent;
+                EsconfPropertyNode *parent = node->parent;
 
-                g_node_unlink(node);
-                esconf_proptree_destroy(node);
+                esconf_proptree_unlink(node);
+                esconf_proptree_destroy(arena, node);
 
                 /* remove parents without values until we find the root node or 
                  * a parent with a value or any children */
                 while(parent) {
-                    prop = parent->data;
-                    if(!G_IS_VALUE(&prop->value)
-                       && !G_IS_VALUE(&prop->system_value)
+                    prop = &parent->prop;
+                    if(!prop->value_type
+                       && !prop->system_value_type
                        && !parent->children && strcmp(prop->name, "/"))
                     {
-                        GNode *tmp = parent;
+                        EsconfPropertyNode *tmp = parent;
                         parent = parent->parent;
 
                         DBG("unlinking node at \"%s\"", prop->name);
 
-                        g_node_unlink(tmp);
-                        esconf_proptree_destroy(tmp);
+                        esconf_proptree_unlink(tmp);
+                        esconf_proptree_destroy(arena, tmp);
                     } else
                         parent = NULL;
                 }
@@ -915,33 +1324,59 @@ esconf_proptree_reset(GNode *proptree,
 }
 
 static gboolean
-proptree_free_node_data(GNode *node,
-                        gpointer data)
+proptree_clear_node_values(EsconfPropertyNode *node,
+                           gpointer data)
+{
+    EsconfProperty *prop = &node->prop;
+
+    esconf_property_unset_value(prop);
+    esconf_property_unset_system_value(prop);
+
+    return FALSE;
+}
+
+static gboolean
+proptree_free_node(EsconfPropertyNode *node,
+                   gpointer data)
 {
-    esconf_property_free((EsconfProperty *)node->data);
+    EsconfProperty *prop = &node->prop;
+
+    esconf_property_unset_value(prop);
+    esconf_property_unset_system_value(prop);
+    esconf_arena_free_node(data, node);
+
     return FALSE;
 }
 
+/* frees the values of a whole tree, but not the tree itself */
+static void
+esconf_proptree_clear_values(EsconfPropertyNode *proptree)
+{
+    esconf_proptree_traverse(proptree, TRUE,
+                             proptree_clear_node_values, NULL);
+}
+
+/* hands an unlinked subtree back to the arena it came from */
 static void
-esconf_proptree_destroy(GNode *proptree)
+esconf_proptree_destroy(EsconfArena *arena,
+                        EsconfPropertyNode *proptree)
 {
     if(G_LIKELY(proptree)) {
-        g_node_traverse(proptree, G_IN_ORDER, G_TRAVERSE_ALL, -1,
-                        proptree_free_node_data, NULL);
-        g_node_destroy(proptree);
+        esconf_proptree_traverse(proptree, TRUE,
+                                 proptree_free_node, arena);
     }
 }
 
 static gchar *
-esconf_proptree_build_propname(GNode *prop_node,
+esconf_proptree_build_propname(EsconfPropertyNode *prop_node,
                                gchar *buf,
                                gsize buflen)
 {
     GSList *components = NULL, *lp;
-    GNode *cur;
+    EsconfPropertyNode *cur;
 
     for(cur = prop_node; cur; cur = cur->parent) {
-        EsconfProperty *prop = cur->data;
+        EsconfProperty *prop = &cur->prop;
         if(!prop->name[1])  /* we've hit "/" */
             break;
         components = g_slist_prepend(components, prop->name);
@@ -961,133 +1396,536 @@ esconf_proptree_build_propname(GNode *prop_node,
 
 
 
+static EsconfChannel *
+esconf_channel_new(void)
+{
+    EsconfChannel *channel = g_slice_new0(EsconfChannel);
+
+    channel->arena = esconf_arena_new();
+    channel->properties = esconf_arena_new_node(channel->arena,
+                                                esconf_arena_intern(channel->arena, "/"));
+
+    return channel;
+}
+
 static void
 esconf_channel_destroy(EsconfChannel *channel)
 {
-    esconf_proptree_destroy(channel->properties);
+    /* the tree itself goes away with the arena */
+    if(channel->arena->owns_values)
+        esconf_proptree_clear_values(channel->properties);
+    esconf_arena_free(channel->arena);
+    if(channel->system_layer)
+        esconf_system_layer_unref(channel->system_layer);
     g_slice_free(EsconfChannel, channel);
 }
 
+static EsconfArena *
+esconf_arena_new(void)
+{
+    EsconfArena *arena = g_slice_new0(EsconfArena);
+
+    arena->strings = g_string_chunk_new(ARENA_STRINGS_SIZE);
+
+    return arena;
+}
+
 static void
-esconf_property_free(EsconfProperty *property)
+esconf_arena_free(EsconfArena *arena)
 {
-    g_free(property->name);
-    if(G_VALUE_TYPE(&property->value))
-        g_value_unset(&property->value);
-    if(G_VALUE_TYPE(&property->system_value))
-        g_value_unset(&property->system_value);
-    g_slice_free(EsconfProperty, property);
+    g_slist_free_full(arena->blocks, g_free);
+    g_string_chunk_free(arena->strings);
+    g_slice_free(EsconfArena, arena);
 }
 
-static gboolean
-esconf_backend_perchannel_xml_save_timeout(gpointer data)
+/* |str| stored once per arena; it lives as long as the arena does */
+static inline gchar *
+esconf_arena_intern(EsconfArena *arena,
+                    const gchar *str)
 {
-    ESCONF_BACKEND_PERCHANNEL_XML(data)->save_id = 0;
-    esconf_backend_perchannel_xml_flush(ESCONF_BACKEND(data), NULL);
+    return str ? g_string_chunk_insert_const(arena->strings, str) : NULL;
+}
 
-    return FALSE;
+/* a new, unlinked node for a property named |name|, which has to live
+ * at least as long as the arena */
+static EsconfPropertyNode *
+esconf_arena_new_node(EsconfArena *arena,
+                      gchar *name)
+{
+    EsconfPropertyNode *pnode;
+
+    if(arena->free_nodes) {
+        pnode = arena->free_nodes;
+        arena->free_nodes = pnode->next;
+    } else {
+        if(!arena->block_left) {
+            arena->block_pos = g_new(EsconfPropertyNode, ARENA_BLOCK_NODES);
+            arena->block_left = ARENA_BLOCK_NODES;
+            arena->blocks = g_slist_prepend(arena->blocks, arena->block_pos);
+        }
+        pnode = arena->block_pos++;
+        --arena->block_left;
+    }
+
+    memset(pnode, 0, sizeof(*pnode));
+    pnode->prop.name = name;
+
+    return pnode;
 }
 
-static void
-esconf_backend_perchannel_xml_schedule_save(EsconfBackendPerchannelXml *xbpx,
-                                            EsconfChannel *channel)
+/* takes back an unlinked node whose values have been cleared */
+static inline void
+esconf_arena_free_node(EsconfArena *arena,
+                       EsconfPropertyNode *node)
 {
-    if(xbpx->save_id)
-        g_source_remove(xbpx->save_id);
+    node->next = arena->free_nodes;
+    arena->free_nodes = node;
+}
 
-    channel->dirty = TRUE;
+/* adds the unlinked |node| as the last child of |parent| */
+static EsconfPropertyNode *
+esconf_proptree_append(EsconfPropertyNode *parent,
+                       EsconfPropertyNode *node)
+{
+    EsconfPropertyNode **link = &parent->children;
 
-    xbpx->save_id = g_timeout_add_seconds(WRITE_TIMEOUT,
-                                          esconf_backend_perchannel_xml_save_timeout,
-                                          xbpx);
+    while(*link)
+        link = &(*link)->next;
+    *link = node;
+    node->parent = parent;
+
+    return node;
 }
 
-static EsconfChannel *
-esconf_backend_perchannel_xml_create_channel(EsconfBackendPerchannelXml *xbpx,
-                                             const gchar *channel_name)
+/* takes |node| and its children out of the tree they are in */
+static void
+esconf_proptree_unlink(EsconfPropertyNode *node)
 {
-    EsconfChannel *channel;
-    EsconfProperty *prop;
+    EsconfPropertyNode **link;
 
-    channel = g_hash_table_lookup(xbpx->channels, channel_name);
-    if(channel) {
-        g_warning("Attempt to create channel when one already exists.");
-        return channel;
+    if(node->parent) {
+        for(link = &node->parent->children; *link != node; link = &(*link)->next)
+            ;
+        *link = node->next;
     }
+    node->parent = node->next = NULL;
+}
 
-    channel = g_slice_new0(EsconfChannel);
-    prop = g_slice_new0(EsconfProperty);
-    prop->name = g_strdup("/");
-    channel->properties = g_node_new(prop);
-    g_hash_table_insert(xbpx->channels, g_ascii_strdown(channel_name, -1), channel);
+static guint
+esconf_proptree_n_children(EsconfPropertyNode *node)
+{
+    EsconfPropertyNode *child;
+    guint n = 0;
 
-    return channel;
-}
+    for(child = node->children; child; child = child->next)
+        ++n;
 
+    return n;
+}
 
+/* calls |func| on |node| and everything below it, on the children of a
+ * node before the node itself with |children_first|.  in that order,
+ * |func| may unlink or free the node it is called on, but no other one. */
 static gboolean
-esconf_xml_handle_channel(XmlParserState *state,
-                          const gchar **attribute_names,
-                          const gchar **attribute_values,
-                          GError **error)
+esconf_proptree_traverse(EsconfPropertyNode *node,
+                         gboolean children_first,
+                         EsconfProptreeFunc func,
+                         gpointer data)
 {
-    const gchar *name = NULL, *version = NULL;
-    const gchar *locked = NULL, *unlocked = NULL;
-    gsize maj_ver_len;
-    gint i;
-    gchar *p;
+    EsconfPropertyNode *child, *next;
 
-    for(i = 0; attribute_names[i]; ++i) {
-        if(!strcmp(attribute_names[i], "name"))
-            name = attribute_values[i];
-        else if(!strcmp(attribute_names[i], "version"))
-            version = attribute_values[i];
-        else if(!strcmp(attribute_names[i], "locked"))
-            locked = attribute_values[i];
-        else if(!strcmp(attribute_names[i], "unlocked"))
-            unlocked = attribute_values[i];
-        else {
-            if(error) {
-                g_set_error(error, G_MARKUP_ERROR,
-                            G_MARKUP_ERROR_UNKNOWN_ATTRIBUTE,
-                            "Unknown attribute in <channel>: %s",
-                            attribute_names[i]);
-            }
-            return FALSE;
-        }
-    }
+    if(!children_first && func(node, data))
+        return TRUE;
 
-    if(!name || !*name || !version || !*version) {
-        if(error) {
-            g_set_error(error, G_MARKUP_ERROR,
-                        G_MARKUP_ERROR_EMPTY,
-                        "Element <channel> requires both name and version attributes");
-        }
-        return FALSE;
+    for(child = node->children; child; child = next) {
+        next = child->next;
+        if(esconf_proptree_traverse(child, children_first, func, data))
+            return TRUE;
     }
 
-    /* compare versions */
-    p = strstr(version, ".");
-    maj_ver_len = p ? (gsize)(p - version) : strlen(version);
-    if(maj_ver_len != strlen(FILE_VERSION_MAJOR)
-       || strncmp(version, FILE_VERSION_MAJOR, maj_ver_len))
-    {
-        if(error) {
-            g_set_error(error, G_MARKUP_ERROR,
-                        G_MARKUP_ERROR_INVALID_CONTENT,
-                        "On-disk file version %s is not compatible with our file version %s.%s",
-                        version, FILE_VERSION_MAJOR,
-                        FILE_VERSION_MINOR);
-        }
-        return FALSE;
+    return children_first && func(node, data);
+}
+
+static guint
+esconf_value_type_from_gtype(GType gtype)
+{
+    switch(gtype) {
+        case G_TYPE_STRING:
+            return ESCONF_VALUE_STRING;
+        case G_TYPE_BOOLEAN:
+            return ESCONF_VALUE_BOOLEAN;
+        case G_TYPE_UCHAR:
+            return ESCONF_VALUE_UCHAR;
+        case G_TYPE_CHAR:
+            return ESCONF_VALUE_CHAR;
+        case G_TYPE_UINT:
+            return ESCONF_VALUE_UINT;
+        case G_TYPE_INT:
+            return ESCONF_VALUE_INT;
+        case G_TYPE_UINT64:
+            return ESCONF_VALUE_UINT64;
+        case G_TYPE_INT64:
+            return ESCONF_VALUE_INT64;
+        case G_TYPE_FLOAT:
+            return ESCONF_VALUE_FLOAT;
+        case G_TYPE_DOUBLE:
+            return ESCONF_VALUE_DOUBLE;
+        default:
+            if(gtype == ESCONF_TYPE_UINT16)
+                return ESCONF_VALUE_UINT16;
+            if(gtype == ESCONF_TYPE_INT16)
+                return ESCONF_VALUE_INT16;
+            if(gtype == G_TYPE_PTR_ARRAY)
+                return ESCONF_VALUE_ARRAY;
+            return ESCONF_VALUE_OTHER;
     }
+}
 
-    if((locked && *locked) || (unlocked && *unlocked)) {
-        gboolean locked_state = FALSE;
+/* stores a copy of |value| in |data|; strings are duplicated and arrays
+ * referenced, as g_value_copy() would.  returns the EsconfValueType */
+static guint
+esconf_value_data_set(EsconfValueData *data,
+                      const GValue *value)
+{
+    guint type = esconf_value_type_from_gtype(G_VALUE_TYPE(value));
 
-        if(!state->is_system_file) {
-            if(error) {
-                g_set_error(error, G_MARKUP_ERROR,
+    switch(type) {
+        case ESCONF_VALUE_STRING:
+            data->str = g_value_dup_string(value);
+            break;
+        case ESCONF_VALUE_BOOLEAN:
+            data->b = g_value_get_boolean(value);
+            break;
+        case ESCONF_VALUE_UCHAR:
+            data->uc = g_value_get_uchar(value);
+            break;
+        case ESCONF_VALUE_CHAR:
+            data->c = g_value_get_schar(value);
+            break;
+        case ESCONF_VALUE_UINT16:
+            data->u16 = esconf_g_value_get_uint16(value);
+            break;
+        case ESCONF_VALUE_INT16:
+            data->i16 = esconf_g_value_get_int16(value);
+            break;
+        case ESCONF_VALUE_UINT:
+            data->u = g_value_get_uint(value);
+            break;
+        case ESCONF_VALUE_INT:
+            data->i = g_value_get_int(value);
+            break;
+        case ESCONF_VALUE_UINT64:
+            data->u64 = g_value_get_uint64(value);
+            break;
+        case ESCONF_VALUE_INT64:
+            data->i64 = g_value_get_int64(value);
+            break;
+        case ESCONF_VALUE_FLOAT:
+            data->f = g_value_get_float(value);
+            break;
+        case ESCONF_VALUE_DOUBLE:
+            data->d = g_value_get_double(value);
+            break;
+        case ESCONF_VALUE_ARRAY:
+            data->arr = g_value_dup_boxed(value);
+            break;
+        default:
+            data->other = g_new0(GValue, 1);
+            g_value_copy(value, g_value_init(data->other, G_VALUE_TYPE(value)));
+            break;
+    }
+
+    return type;
+}
+
+static void
+esconf_value_data_clear(EsconfValueData *data,
+                        guint type)
+{
+    switch(type) {
+        case ESCONF_VALUE_STRING:
+            g_free(data->str);
+            break;
+        case ESCONF_VALUE_ARRAY:
+            if(data->arr)
+                g_ptr_array_unref(data->arr);
+            break;
+        case ESCONF_VALUE_OTHER:
+            g_value_unset(data->other);
+            g_free(data->other);
+            break;
+        default:
+            break;
+    }
+}
+
+/* a GValue for what |data| holds, without copying anything: |view| is
+ * filled in and returned, except for ESCONF_VALUE_OTHER.  the result is
+ * only valid as long as |data| is, and must not be unset.  returns NULL
+ * for ESCONF_VALUE_UNSET. */
+static const GValue *
+esconf_value_data_peek(const EsconfValueData *data,
+                       guint type,
+                       GValue *view)
+{
+    switch(type) {
+        case ESCONF_VALUE_UNSET:
+            return NULL;
+        case ESCONF_VALUE_STRING:
+            g_value_init(view, G_TYPE_STRING);
+            g_value_set_static_string(view, data->str);
+            break;
+        case ESCONF_VALUE_BOOLEAN:
+            g_value_set_boolean(g_value_init(view, G_TYPE_BOOLEAN), data->b);
+            break;
+        case ESCONF_VALUE_UCHAR:
+            g_value_set_uchar(g_value_init(view, G_TYPE_UCHAR), data->uc);
+            break;
+        case ESCONF_VALUE_CHAR:
+            g_value_set_schar(g_value_init(view, G_TYPE_CHAR), data->c);
+            break;
+        case ESCONF_VALUE_UINT16:
+            esconf_g_value_set_uint16(g_value_init(view, ESCONF_TYPE_UINT16), data->u16);
+            break;
+        case ESCONF_VALUE_INT16:
+            esconf_g_value_set_int16(g_value_init(view, ESCONF_TYPE_INT16), data->i16);
+            break;
+        case ESCONF_VALUE_UINT:
+            g_value_set_uint(g_value_init(view, G_TYPE_UINT), data->u);
+            break;
+        case ESCONF_VALUE_INT:
+            g_value_set_int(g_value_init(view, G_TYPE_INT), data->i);
+            break;
+        case ESCONF_VALUE_UINT64:
+            g_value_set_uint64(g_value_init(view, G_TYPE_UINT64), data->u64);
+            break;
+        case ESCONF_VALUE_INT64:
+            g_value_set_int64(g_value_init(view, G_TYPE_INT64), data->i64);
+            break;
+        case ESCONF_VALUE_FLOAT:
+            g_value_set_float(g_value_init(view, G_TYPE_FLOAT), data->f);
+            break;
+        case ESCONF_VALUE_DOUBLE:
+            g_value_set_double(g_value_init(view, G_TYPE_DOUBLE), data->d);
+            break;
+        case ESCONF_VALUE_ARRAY:
+            g_value_init(view, G_TYPE_PTR_ARRAY);
+            g_value_set_static_boxed(view, data->arr);
+            break;
+        default:
+            return data->other;
+    }
+
+    return view;
+}
+
+static void
+esconf_property_set_value(EsconfArena *arena,
+                          EsconfProperty *prop,
+                          const GValue *value)
+{
+    esconf_property_unset_value(prop);
+    prop->value_type = esconf_value_data_set(&prop->value, value);
+    if(ESCONF_VALUE_TYPE_IS_ALLOCATED(prop->value_type))
+        arena->owns_values = TRUE;
+}
+
+static void
+esconf_property_unset_value(EsconfProperty *prop)
+{
+    if(!prop->value_borrowed)
+        esconf_value_data_clear(&prop->value, prop->value_type);
+    prop->value_type = ESCONF_VALUE_UNSET;
+    prop->value_borrowed = FALSE;
+}
+
+static void
+esconf_property_unset_system_value(EsconfProperty *prop)
+{
+    if(!prop->system_borrowed)
+        esconf_value_data_clear(&prop->system_value, prop->system_value_type);
+    prop->system_value_type = ESCONF_VALUE_UNSET;
+    prop->system_borrowed = FALSE;
+}
+
+/* the user value of |prop| if it has one, its system value otherwise;
+ * see esconf_value_data_peek() */
+static const GValue *
+esconf_property_peek_effective_value(const EsconfProperty *prop,
+                                     GValue *view)
+{
+    if(prop->value_type != ESCONF_VALUE_UNSET)
+        return esconf_value_data_peek(&prop->value, prop->value_type, view);
+    return esconf_value_data_peek(&prop->system_value, prop->system_value_type, view);
+}
+
+static gboolean
+esconf_backend_perchannel_xml_save_timeout(gpointer data)
+{
+    ESCONF_BACKEND_PERCHANNEL_XML(data)->save_id = 0;
+    esconf_backend_perchannel_xml_flush(ESCONF_BACKEND(data), NULL);
+
+    return FALSE;
+}
+
+static void
+esconf_backend_perchannel_xml_schedule_save(EsconfBackendPerchannelXml *xbpx,
+                                            EsconfChannel *channel)
+{
+    if(xbpx->save_id)
+        g_source_remove(xbpx->save_id);
+
+    channel->dirty = TRUE;
+
+    xbpx->save_id = g_timeout_add_seconds(WRITE_TIMEOUT,
+                                          esconf_backend_perchannel_xml_save_timeout,
+                                          xbpx);
+}
+
+static EsconfChannel *
+esconf_backend_perchannel_xml_create_channel(EsconfBackendPerchannelXml *xbpx,
+                                             const gchar *channel_name)
+{
+    EsconfChannel *channel;
+
+    channel = g_hash_table_lookup(xbpx->channels, channel_name);
+    if(channel) {
+        g_warning("Attempt to create channel when one already exists.");
+        return channel;
+    }
+
+    channel = esconf_channel_new();
+    g_hash_table_insert(xbpx->channels, g_ascii_strdown(channel_name, -1), channel);
+
+    return channel;
+}
+
+
+/* finds the child of the current element for a <property> named |name|,
+ * without walking down from the root again for every element */
+static EsconfPropertyNode *
+esconf_xml_lookup_property_node(XmlParserState *state,
+                                const gchar *name)
+{
+    EsconfPropertyNode *node;
+
+    if(G_UNLIKELY(strchr(name, '/'))) {
+        /* a name with slashes reaches further down the tree */
+        gchar fullpath[MAX_PROP_PATH];
+
+        esconf_proptree_build_propname(state->cur_node, fullpath, sizeof(fullpath));
+        g_strlcat(fullpath, "/", sizeof(fullpath));
+        g_strlcat(fullpath, name, sizeof(fullpath));
+
+        if(!PROP_NAME_IS_VALID(fullpath))
+            return NULL;
+
+        return esconf_proptree_lookup_node(state->channel->properties, fullpath);
+    }
+
+    for(node = state->cur_node->children; node; node = node->next) {
+        if(!strcmp(node->prop.name, name))
+            return node;
+    }
+
+    return NULL;
+}
+
+/* adds the property |name| below the current element; it must not
+ * exist yet */
+static EsconfPropertyNode *
+esconf_xml_add_property_node(XmlParserState *state,
+                             const gchar *name,
+                             gboolean locked)
+{
+    EsconfArena *arena = state->channel->arena;
+    EsconfProperty *prop;
+    EsconfPropertyNode *node;
+
+    if(G_UNLIKELY(strchr(name, '/'))) {
+        gchar fullpath[MAX_PROP_PATH];
+
+        esconf_proptree_build_propname(state->cur_node, fullpath, sizeof(fullpath));
+        g_strlcat(fullpath, "/", sizeof(fullpath));
+        g_strlcat(fullpath, name, sizeof(fullpath));
+
+        if(!PROP_NAME_IS_VALID(fullpath))
+            return NULL;
+
+        return esconf_proptree_add_property(state->channel,
+                                            fullpath, NULL, NULL, locked);
+    }
+
+    node = esconf_arena_new_node(arena, esconf_arena_intern(arena, name));
+    prop = &node->prop;
+    prop->locked = locked;
+
+    return esconf_proptree_append(state->cur_node, node);
+}
+
+static gboolean
+esconf_xml_handle_channel(XmlParserState *state,
+                          const gchar **attribute_names,
+                          const gchar **attribute_values,
+                          GError **error)
+{
+    const gchar *name = NULL, *version = NULL;
+    const gchar *locked = NULL, *unlocked = NULL;
+    gsize maj_ver_len;
+    gint i;
+    gchar *p;
+
+    for(i = 0; attribute_names[i]; ++i) {
+        if(!strcmp(attribute_names[i], "name"))
+            name = attribute_values[i];
+        else if(!strcmp(attribute_names[i], "version"))
+            version = attribute_values[i];
+        else if(!strcmp(attribute_names[i], "locked"))
+            locked = attribute_values[i];
+        else if(!strcmp(attribute_names[i], "unlocked"))
+            unlocked = attribute_values[i];
+        else {
+            if(error) {
+                g_set_error(error, G_MARKUP_ERROR,
+                            G_MARKUP_ERROR_UNKNOWN_ATTRIBUTE,
+                            "Unknown attribute in <channel>: %s",
+                            attribute_names[i]);
+            }
+            return FALSE;
+        }
+    }
+
+    if(!name || !*name || !version || !*version) {
+        if(error) {
+            g_set_error(error, G_MARKUP_ERROR,
+                        G_MARKUP_ERROR_EMPTY,
+                        "Element <channel> requires both name and version attributes");
+        }
+        return FALSE;
+    }
+
+    /* compare versions */
+    p = strstr(version, ".");
+    maj_ver_len = p ? (gsize)(p - version) : strlen(version);
+    if(maj_ver_len != strlen(FILE_VERSION_MAJOR)
+       || strncmp(version, FILE_VERSION_MAJOR, maj_ver_len))
+    {
+        if(error) {
+            g_set_error(error, G_MARKUP_ERROR,
+                        G_MARKUP_ERROR_INVALID_CONTENT,
+                        "On-disk file version %s is not compatible with our file version %s.%s",
+                        version, FILE_VERSION_MAJOR,
+                        FILE_VERSION_MINOR);
+        }
+        return FALSE;
+    }
+
+    if((locked && *locked) || (unlocked && *unlocked)) {
+        gboolean locked_state = FALSE;
+
+        if(!state->is_system_file) {
+            if(error) {
+                g_set_error(error, G_MARKUP_ERROR,
                             G_MARKUP_ERROR_UNKNOWN_ATTRIBUTE,
                             "Attribute \"locked\" not allowed in <channel> for non-system files");
             }
@@ -1095,9 +1933,9 @@ esconf_xml_handle_channel(XmlParserState *state,
         }
 
         if(unlocked && *unlocked)
-            locked_state = !esconf_user_is_in_list(unlocked);
+            locked_state = !esconf_lock_policy_applies(esconf_lock_policy_lookup(unlocked));
         else if(locked && *locked)
-            locked_state = esconf_user_is_in_list(locked);
+            locked_state = esconf_lock_policy_applies(esconf_lock_policy_lookup(locked));
 
         /* Policy:
          *   + If the channel was locked by a previous file, and this file
@@ -1121,19 +1959,18 @@ esconf_xml_handle_channel(XmlParserState *state,
             }
             return FALSE;
         } else if(!state->channel->locked && locked_state) {
-            EsconfProperty *prop;
+            EsconfArena *arena = state->channel->arena;
 
-            esconf_proptree_destroy(state->channel->properties);
-
-            prop = g_slice_new0(EsconfProperty);
-            prop->name = g_strdup("/");
-            state->channel->properties = g_node_new(prop);
+            esconf_proptree_destroy(arena, state->channel->properties);
+            state->channel->properties = esconf_arena_new_node(arena,
+                                                               esconf_arena_intern(arena, "/"));
 
             state->channel->locked = TRUE;
         }
     }
 
     state->cur_elem = ELEM_CHANNEL;
+    state->cur_node = state->channel->properties;
 
     return TRUE;
 }
@@ -1147,10 +1984,9 @@ esconf_xml_handle_property(XmlParserState *state,
     gint i;
     const gchar *name = NULL, *type = NULL, *value = NULL;
     const gchar *locked = NULL, *unlocked = NULL;
-    gchar fullpath[MAX_PROP_PATH];
+    EsconfPropertyNode *node;
     EsconfProperty *prop = NULL;
     GType value_type;
-    GValue *value_to_set = NULL;
 
     for(i = 0; attribute_names[i]; ++i) {
         if(!strcmp(attribute_names[i], "name"))
@@ -1183,9 +2019,6 @@ esconf_xml_handle_property(XmlParserState *state,
     }
 
     /* FIXME: name validation! */
-    g_strlcpy(fullpath, state->cur_path, MAX_PROP_PATH);
-    g_strlcat(fullpath, "/", MAX_PROP_PATH);
-    g_strlcat(fullpath, name, MAX_PROP_PATH);
 
     /* Policy:
      *   + If the channel is already locked and we're here, we can
@@ -1209,47 +2042,45 @@ esconf_xml_handle_property(XmlParserState *state,
         g_assert_not_reached();
     }
 
-    prop = esconf_proptree_lookup(state->channel->properties, fullpath);
+    node = esconf_xml_lookup_property_node(state, name);
+    if(node)
+        prop = &node->prop;
 
     if(state->channel->locked) {
         /* we must still be in a system file, otherwise we'd never get here */
         if(prop) {
             /* when the channel is locked and we're in a system file, a new
              * property will always "win", even if it's "empty" */
-            if(G_VALUE_TYPE(&prop->value))  /* shouldn't be set, but... */
-                g_value_unset(&prop->value);
-            if(G_VALUE_TYPE(&prop->system_value))
-                g_value_unset(&prop->system_value);
+            esconf_property_unset_value(prop);  /* shouldn't be set, but... */
+            esconf_property_unset_system_value(prop);
         } else {
-            GNode *pnode = esconf_proptree_add_property(state->channel->properties,
-                                                        fullpath, NULL, NULL,
-                                                        TRUE);
-            prop = pnode->data;
+            node = esconf_xml_add_property_node(state, name, TRUE);
+            if(!node)
+                goto invalid_name;
+            prop = &node->prop;
         }
     } else {
         if(prop && prop->locked && !state->is_system_file) {
             /* not system file, prop already locked, pass on this one */
             state->cur_elem = ELEM_PROPERTY;
-            g_strlcpy(state->cur_path, fullpath, MAX_PROP_PATH);
+            state->cur_node = node;
             return TRUE;
         }
 
         if(prop) {
             /* new prop wins, regardless of previous state */
-            if(G_VALUE_TYPE(&prop->value))
-                g_value_unset(&prop->value);
+            esconf_property_unset_value(prop);
             if(state->is_system_file) {
                 /* we only clear this if we're in a system file.  if we're
                  * not, we want to remember the system value for reset
                  * purposes. */
-                if(G_VALUE_TYPE(&prop->system_value))
-                    g_value_unset(&prop->system_value);
+                esconf_property_unset_system_value(prop);
             }
         } else {
-            GNode *pnode = esconf_proptree_add_property(state->channel->properties,
-                                                        fullpath, NULL, NULL,
-                                                        FALSE);
-            prop = pnode->data;
+            node = esconf_xml_add_property_node(state, name, FALSE);
+            if(!node)
+                goto invalid_name;
+            prop = &node->prop;
         }
     }
 
@@ -1267,7 +2098,7 @@ esconf_xml_handle_property(XmlParserState *state,
                             "Attribute \"locked\" not allowed in <property> for non-system files");
             }
 
-            esconf_proptree_reset(state->channel->properties, fullpath);
+            esconf_proptree_reset_node(state->channel->arena, node);
             return FALSE;
         }
 
@@ -1277,9 +2108,9 @@ esconf_xml_handle_property(XmlParserState *state,
         } else {
             /* not locked already, but we have a lock/unlock directive */
             if(unlocked && *unlocked)
-                prop->locked = !esconf_user_is_in_list(unlocked);
+                prop->locked = !esconf_lock_policy_applies(esconf_lock_policy_lookup(unlocked));
             else if(locked && *locked)
-                prop->locked = esconf_user_is_in_list(locked);
+                prop->locked = esconf_lock_policy_applies(esconf_lock_policy_lookup(locked));
         }
     }
 
@@ -1299,38 +2130,67 @@ esconf_xml_handle_property(XmlParserState *state,
         return FALSE;
     }
 
-    if(state->is_system_file)
-        value_to_set = &prop->system_value;
-    else
-        value_to_set = &prop->value;
-
     if(G_TYPE_NONE != value_type) {
-        g_value_init(value_to_set, value_type);
-        if(!_esconf_gvalue_from_string(value_to_set, value)) {
-            if(error) {
-                g_set_error(error, G_MARKUP_ERROR,
-                            G_MARKUP_ERROR_INVALID_CONTENT,
-                            _("Unable to parse value of type \"%s\" from \"%s\""),
-                            g_type_name(value_type), value);
+        EsconfValueData *data_to_set;
+        guint type_to_set;
+
+        data_to_set = state->is_system_file ? &prop->system_value : &prop->value;
+
+        if(G_TYPE_STRING == value_type) {
+            /* the common case; kept in the arena, like the names */
+            data_to_set->str = esconf_arena_intern(state->channel->arena, value);
+            type_to_set = ESCONF_VALUE_STRING;
+            if(state->is_system_file)
+                prop->system_borrowed = TRUE;
+            else
+                prop->value_borrowed = TRUE;
+        } else {
+            GValue parsed = { 0, };
+
+            g_value_init(&parsed, value_type);
+            if(!_esconf_gvalue_from_string(&parsed, value)) {
+                if(error) {
+                    g_set_error(error, G_MARKUP_ERROR,
+                                G_MARKUP_ERROR_INVALID_CONTENT,
+                                _("Unable to parse value of type \"%s\" from \"%s\""),
+                                g_type_name(value_type), value);
+                }
+                g_value_unset(&parsed);
+                return FALSE;
             }
-            return FALSE;
+            type_to_set = esconf_value_data_set(data_to_set, &parsed);
+            g_value_unset(&parsed);
+            if(ESCONF_VALUE_TYPE_IS_ALLOCATED(type_to_set))
+                state->channel->arena->owns_values = TRUE;
         }
 
+        if(state->is_system_file)
+            prop->system_value_type = type_to_set;
+        else
+            prop->value_type = type_to_set;
+
         if(G_TYPE_PTR_ARRAY == value_type) {
             /* FIXME: use stacks here */
-            state->list_property = g_strdup(fullpath);
-            state->list_value = value_to_set;
+            state->list_node = node;
+            state->list_array = data_to_set->arr;
         }
 
         if(prop)
-            DBG("property '%s' has value type %s", fullpath, G_VALUE_TYPE_NAME(value_to_set));
+            DBG("property '%s' has value type %s", name, g_type_name(value_type));
     } else
         DBG("empty property (branch)");
 
-    g_strlcpy(state->cur_path, fullpath, MAX_PROP_PATH);
+    state->cur_node = node;
     state->cur_elem = ELEM_PROPERTY;
 
     return TRUE;
+
+invalid_name:
+    if(error) {
+        g_set_error(error, G_MARKUP_ERROR, G_MARKUP_ERROR_INVALID_CONTENT,
+                    "Invalid property name in <property>: \"%s\"", name);
+    }
+    return FALSE;
 }
 
 static gboolean
@@ -1394,7 +2254,7 @@ esconf_xml_handle_value(XmlParserState *state,
         return FALSE;
     }
 
-    arr = g_value_get_boxed(state->list_value);
+    arr = state->list_array;
     g_ptr_array_add(arr, val);
 
     state->cur_elem = ELEM_VALUE;
@@ -1434,8 +2294,8 @@ esconf_backend_perchannel_xml_start_elem(GMarkupParseContext *context,
                 esconf_xml_handle_property(state, attribute_names,
                                            attribute_values, error);
             } else if(ELEM_PROPERTY == state->cur_elem
-                      && state->list_property  /* FIXME: use stack */
-                      && state->list_value  /* FIXME: use stack */
+                      && state->list_node  /* FIXME: use stack */
+                      && state->list_array  /* FIXME: use stack */
                       && !strcmp(element_name, "value"))
             {
                 esconf_xml_handle_value(state, attribute_names,
@@ -1470,32 +2330,24 @@ esconf_backend_perchannel_xml_end_elem(GMarkupParseContext *context,
                                        GError **error)
 {
     XmlParserState *state = user_data;
-    gchar *p;
 
     switch(state->cur_elem) {
         case ELEM_CHANNEL:
             state->cur_elem = ELEM_NONE;
-            state->cur_path[0] = 0;
+            state->cur_node = NULL;
             break;
 
         case ELEM_PROPERTY:
             /* FIXME: use stacks here */
-            g_free(state->list_property);
-            state->list_property = NULL;
-            state->list_value = NULL;
-
-            p = g_strrstr(state->cur_path, "/");
+            state->list_node = NULL;
+            state->list_array = NULL;
 
-            if(p) {
-                *p = 0;
-                if(!*(state->cur_path))
-                    state->cur_elem = ELEM_CHANNEL;
-                else
-                    state->cur_elem = ELEM_PROPERTY;
-            } else {
-                g_warning("Missing '/' char: I don't think this should happen");
+            state->cur_node = state->cur_node->parent;
+            if(!state->cur_node || state->cur_node == state->channel->properties) {
+                state->cur_node = state->channel->properties;
                 state->cur_elem = ELEM_CHANNEL;
-            }
+            } else
+                state->cur_elem = ELEM_PROPERTY;
             break;
 
         case ELEM_VALUE:
@@ -1558,42 +2410,394 @@ esconf_backend_perchannel_xml_text_elem(GMarkupParseContext *context,
 }
 #endif
 
-static gboolean
-esconf_backend_perchannel_xml_merge_file(EsconfBackendPerchannelXml *xbpx,
-                                         const gchar *filename,
-                                         gboolean is_system_file,
-                                         EsconfChannel *channel,
-                                         GError **error)
+/* a parser for exactly what perchannel-xml.dtd allows, used instead of
+ * GMarkup for loading channels.  it makes one pass over the file with
+ * memchr() to tokenize it into start/end events, unescaping attribute
+ * values into a single scratch buffer, and only then feeds the events
+ * to the same start/end handlers GMarkup uses.  anything it doesn't
+ * recognise (unknown elements or attributes, DOCTYPE, CDATA, text
+ * content, unknown entities, invalid UTF-8 or nesting) makes it give
+ * up before the channel has been touched, and the file is parsed with
+ * GMarkup instead, which then also reports the error. */
+
+static const gchar *xml_fast_elements[] = {
+    "channel", "property", "value", NULL
+};
+
+static const gchar *xml_fast_attributes[] = {
+    "name", "type", "value", "locked", "unlocked", "version", NULL
+};
+
+#define XML_FAST_MAX_ATTRIBUTES  (G_N_ELEMENTS(xml_fast_attributes) - 1)
+
+typedef struct
 {
-    gboolean ret = FALSE;
-    GMappedFile *mmap_file;
-    gchar *file_contents;
-    gsize length;
-    GMarkupParseContext *context;
-    XmlParserState *state;
-    GError *error2 = NULL;
-    GMarkupParser parser = {
-        esconf_backend_perchannel_xml_start_elem,
-        esconf_backend_perchannel_xml_end_elem,
-        /* esconf_backend_perchannel_xml_text_elem, */
-        NULL,
-    };
+    const gchar *element_name;
+    gboolean is_end;
+    guint n_attributes;
+    const gchar *names[XML_FAST_MAX_ATTRIBUTES];
+    /* offsets into the scratch buffer */
+    gsize values[XML_FAST_MAX_ATTRIBUTES];
+} XmlFastEvent;
+
+#define XML_IS_SPACE(c)  ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+#define XML_IS_NAME_CHAR(c)  (g_ascii_isalnum(c) || (c) == '_' || (c) == '-' \
+                              || (c) == '.' || (c) == ':')
+
+static inline const gchar *
+xml_fast_skip_space(const gchar *p,
+                    const gchar *end)
+{
+    while(p < end && XML_IS_SPACE(*p))
+        ++p;
+    return p;
+}
 
-    TRACE("entering (%s)", filename);
+/* maps the name at |p| to the matching string in |known| */
+static const gchar *
+xml_fast_read_name(const gchar **p,
+                   const gchar *end,
+                   const gchar **known)
+{
+    const gchar *start = *p;
+    gsize len;
+    gint i;
 
-    /* we first try to load a mapped file, if this fails (no mmap
-     * implementation is a possible cause) we fall back to normal file
-     * loading */
-    mmap_file = g_mapped_file_new(filename, FALSE, NULL);
-    if(G_LIKELY(mmap_file != NULL)) {
-        file_contents = g_mapped_file_get_contents(mmap_file);
-        length = g_mapped_file_get_length(mmap_file);
-        DBG("successfully loaded mapped file");
-    } else if(!g_file_get_contents(filename, &file_contents, &length, error)) {
-        return FALSE;
+    while(*p < end && XML_IS_NAME_CHAR(**p))
+        ++(*p);
+    len = *p - start;
+
+    for(i = 0; len && known[i]; ++i) {
+        if(!strncmp(known[i], start, len) && !known[i][len])
+            return known[i];
     }
 
-    state = g_slice_new0(XmlParserState);
+    return NULL;
+}
+
+/* finds |needle| (of length > 1) in [p, end) */
+static const gchar *
+xml_fast_find(const gchar *p,
+              const gchar *end,
+              const gchar *needle)
+{
+    gsize needle_len = strlen(needle);
+
+    while((p = memchr(p, needle[0], end - p))) {
+        if((gsize)(end - p) < needle_len)
+            return NULL;
+        if(!memcmp(p, needle, needle_len))
+            return p;
+        ++p;
+    }
+
+    return NULL;
+}
+
+/* appends [p, end) to |scratch| with its line breaks and tabs turned
+ * into spaces, CRLF being a single line break, which is how GMarkup
+ * normalizes attribute values */
+static void
+xml_fast_append_normalized(GString *scratch,
+                           const gchar *p,
+                           const gchar *end)
+{
+    while(p < end) {
+        const gchar *run = p;
+
+        while(p < end && *p != '\t' && *p != '\n' && *p != '\r')
+            ++p;
+        g_string_append_len(scratch, run, p - run);
+
+        if(p < end) {
+            g_string_append_c(scratch, ' ');
+            if(*p == '\r' && p + 1 < end && p[1] == '\n')
+                ++p;
+            ++p;
+        }
+    }
+}
+
+/* character references are not normalized, so "&#xA;" stays a line
+ * break */
+static gboolean
+xml_fast_append_unescaped(GString *scratch,
+                          const gchar *p,
+                          const gchar *end)
+{
+    while(p < end) {
+        const gchar *amp = memchr(p, '&', end - p);
+        const gchar *ent, *semi;
+        gsize ent_len;
+
+        if(!amp) {
+            xml_fast_append_normalized(scratch, p, end);
+            break;
+        }
+
+        xml_fast_append_normalized(scratch, p, amp);
+
+        ent = amp + 1;
+        semi = memchr(ent, ';', end - ent);
+        if(!semi)
+            return FALSE;
+        ent_len = semi - ent;
+
+        if(ent_len == 3 && !strncmp(ent, "amp", 3))
+            g_string_append_c(scratch, '&');
+        else if(ent_len == 2 && !strncmp(ent, "lt", 2))
+            g_string_append_c(scratch, '<');
+        else if(ent_len == 2 && !strncmp(ent, "gt", 2))
+            g_string_append_c(scratch, '>');
+        else if(ent_len == 4 && !strncmp(ent, "quot", 4))
+            g_string_append_c(scratch, '"');
+        else if(ent_len == 4 && !strncmp(ent, "apos", 4))
+            g_string_append_c(scratch, '\'');
+        else if(ent_len > 1 && ent_len < 10 && ent[0] == '#') {
+            gboolean hex = (ent[1] == 'x');
+            const gchar *d = ent + (hex ? 2 : 1);
+            gunichar ch = 0;
+
+            if(d == semi)
+                return FALSE;
+            for(; d < semi; ++d) {
+                if(hex && g_ascii_isxdigit(*d))
+                    ch = ch * 16 + g_ascii_xdigit_value(*d);
+                else if(!hex && g_ascii_isdigit(*d))
+                    ch = ch * 10 + g_ascii_digit_value(*d);
+                else
+                    return FALSE;
+            }
+
+            if(ch == 0 || !g_unichar_validate(ch))
+                return FALSE;
+            g_string_append_unichar(scratch, ch);
+        } else
+            return FALSE;
+
+        p = semi + 1;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+xml_fast_tokenize(const gchar *buf,
+                  gsize length,
+                  GArray *events,
+                  GString *scratch)
+{
+    const gchar *p = buf, *end = buf + length;
+    GPtrArray *open_elements = g_ptr_array_new();
+    gboolean seen_root = FALSE;
+    gboolean ret = FALSE;
+
+    while(p < end) {
+        const gchar *lt = memchr(p, '<', end - p);
+        XmlFastEvent event;
+
+        /* anything between tags must be whitespace */
+        if(xml_fast_skip_space(p, lt ? lt : end) != (lt ? lt : end))
+            goto out;
+        if(!lt)
+            break;
+
+        p = lt + 1;
+        if(p >= end)
+            goto out;
+
+        if(*p == '?') {
+            /* the <?xml ...?> declaration */
+            if(seen_root || !(p = xml_fast_find(p, end, "?>")))
+                goto out;
+            p += 2;
+            continue;
+        } else if(*p == '!') {
+            const gchar *comment_end;
+
+            if(end - p < 3 || strncmp(p, "!--", 3))
+                goto out;
+            comment_end = xml_fast_find(p + 3, end, "-->");
+            if(!comment_end)
+                goto out;
+            p = comment_end + 3;
+            continue;
+        }
+
+        memset(&event, 0, sizeof(event));
+
+        if(*p == '/') {
+            ++p;
+            event.is_end = TRUE;
+            event.element_name = xml_fast_read_name(&p, end, xml_fast_elements);
+            p = xml_fast_skip_space(p, end);
+            if(!event.element_name || p >= end || *p != '>'
+               || !open_elements->len
+               || g_ptr_array_index(open_elements, open_elements->len - 1) != event.element_name)
+            {
+                goto out;
+            }
+            ++p;
+            g_ptr_array_remove_index(open_elements, open_elements->len - 1);
+            g_array_append_val(events, event);
+            continue;
+        }
+
+        /* a start tag; only one root element is allowed */
+        if(seen_root && !open_elements->len)
+            goto out;
+        seen_root = TRUE;
+
+        event.element_name = xml_fast_read_name(&p, end, xml_fast_elements);
+        if(!event.element_name)
+            goto out;
+
+        for(;;) {
+            const gchar *attr_name, *value_end;
+            gchar quote;
+            guint i;
+
+            p = xml_fast_skip_space(p, end);
+            if(p >= end)
+                goto out;
+            if(*p == '>' || *p == '/')
+                break;
+
+            attr_name = xml_fast_read_name(&p, end, xml_fast_attributes);
+            if(!attr_name)
+                goto out;
+            for(i = 0; i < event.n_attributes; ++i) {
+                if(event.names[i] == attr_name)
+                    goto out;
+            }
+
+            p = xml_fast_skip_space(p, end);
+            if(p >= end || *p != '=')
+                goto out;
+            p = xml_fast_skip_space(p + 1, end);
+            if(p >= end || (*p != '"' && *p != '\''))
+                goto out;
+            quote = *p++;
+
+            value_end = memchr(p, quote, end - p);
+            if(!value_end || memchr(p, '<', value_end - p))
+                goto out;
+
+            event.names[event.n_attributes] = attr_name;
+            event.values[event.n_attributes] = scratch->len;
+            ++event.n_attributes;
+
+            if(!xml_fast_append_unescaped(scratch, p, value_end)
+               || !g_utf8_validate(scratch->str + event.values[event.n_attributes - 1],
+                                   scratch->len - event.values[event.n_attributes - 1],
+                                   NULL))
+            {
+                goto out;
+            }
+            g_string_append_c(scratch, 0);
+
+            p = value_end + 1;
+        }
+
+        g_array_append_val(events, event);
+
+        if(*p == '/') {
+            /* empty element */
+            if(++p >= end || *p != '>')
+                goto out;
+            event.is_end = TRUE;
+            event.n_attributes = 0;
+            g_array_append_val(events, event);
+        } else
+            g_ptr_array_add(open_elements, (gpointer)event.element_name);
+        ++p;
+    }
+
+    ret = seen_root && !open_elements->len;
+
+out:
+    g_ptr_array_free(open_elements, TRUE);
+
+    return ret;
+}
+
+static gboolean
+xml_fast_apply(XmlParserState *state,
+               GArray *events,
+               GString *scratch,
+               GError **error)
+{
+    const gchar *names[XML_FAST_MAX_ATTRIBUTES + 1];
+    const gchar *values[XML_FAST_MAX_ATTRIBUTES + 1];
+    GError *error2 = NULL;
+    guint i, j;
+
+    for(i = 0; i < events->len && !error2; ++i) {
+        XmlFastEvent *event = &g_array_index(events, XmlFastEvent, i);
+
+        if(event->is_end) {
+            esconf_backend_perchannel_xml_end_elem(NULL, event->element_name,
+                                                   state, &error2);
+            continue;
+        }
+
+        for(j = 0; j < event->n_attributes; ++j) {
+            names[j] = event->names[j];
+            values[j] = scratch->str + event->values[j];
+        }
+        names[j] = values[j] = NULL;
+
+        esconf_backend_perchannel_xml_start_elem(NULL, event->element_name,
+                                                 names, values, state,
+                                                 &error2);
+    }
+
+    if(error2) {
+        g_propagate_error(error, error2);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+esconf_backend_perchannel_xml_merge_file(EsconfBackendPerchannelXml *xbpx,
+                                         const gchar *filename,
+                                         gboolean is_system_file,
+                                         EsconfChannel *channel,
+                                         GError **error)
+{
+    gboolean ret = FALSE;
+    GMappedFile *mmap_file;
+    gchar *file_contents;
+    gsize length;
+    GMarkupParseContext *context = NULL;
+    XmlParserState *state;
+    GArray *events;
+    GString *scratch;
+    GError *error2 = NULL;
+    GMarkupParser parser = {
+        esconf_backend_perchannel_xml_start_elem,
+        esconf_backend_perchannel_xml_end_elem,
+        /* esconf_backend_perchannel_xml_text_elem, */
+        NULL,
+    };
+
+    TRACE("entering (%s)", filename);
+
+    /* we first try to load a mapped file, if this fails (no mmap
+     * implementation is a possible cause) we fall back to normal file
+     * loading */
+    mmap_file = g_mapped_file_new(filename, FALSE, NULL);
+    if(G_LIKELY(mmap_file != NULL)) {
+        file_contents = g_mapped_file_get_contents(mmap_file);
+        length = g_mapped_file_get_length(mmap_file);
+        DBG("successfully loaded mapped file");
+    } else if(!g_file_get_contents(filename, &file_contents, &length, error)) {
+        return FALSE;
+    }
+
+    state = g_slice_new0(XmlParserState);
     state->channel = channel;
     state->xbpx = xbpx;
     state->cur_elem = ELEM_NONE;
@@ -1601,11 +2805,23 @@ esconf_backend_perchannel_xml_merge_file(EsconfBackendPerchannelXml *xbpx,
 
     DBG("got file(size=%"G_GSIZE_FORMAT"): %s", length, file_contents);
 
-    context = g_markup_parse_context_new(&parser, 0, state, NULL);
-    if(g_markup_parse_context_parse(context, file_contents, length, &error2)
-       && g_markup_parse_context_end_parse(context, &error2)) {
-        ret = TRUE;
+    events = g_array_sized_new(FALSE, FALSE, sizeof(XmlFastEvent), length / 64 + 1);
+    scratch = g_string_sized_new(length / 2 + 1);
+
+    if(xml_fast_tokenize(file_contents, length, events, scratch)) {
+        ret = xml_fast_apply(state, events, scratch, &error2);
     } else {
+        DBG("\"%s\" isn't plain perchannel-xml, parsing it with GMarkup", filename);
+
+        context = g_markup_parse_context_new(&parser, 0, state, NULL);
+        ret = g_markup_parse_context_parse(context, file_contents, length, &error2)
+              && g_markup_parse_context_end_parse(context, &error2);
+    }
+
+    g_array_free(events, TRUE);
+    g_string_free(scratch, TRUE);
+
+    if(!ret) {
         g_warning("Error parsing esconf config file \"%s\": %s", filename,
                   error2 ? error2->message : "(?)");
         if(error)
@@ -1626,7 +2842,428 @@ esconf_backend_perchannel_xml_merge_file(EsconfBackendPerchannelXml *xbpx,
     else
         g_free(file_contents);
 
-    return ret;
+    return ret;
+}
+
+static gboolean
+esconf_file_stamp_get(const gchar *path,
+                      EsconfFileStamp *stamp)
+{
+    struct stat st;
+
+    memset(stamp, 0, sizeof(*stamp));
+    if(!path || stat(path, &st))
+        return FALSE;
+
+    stamp->dev = st.st_dev;
+    stamp->ino = st.st_ino;
+    stamp->mtime = st.st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    stamp->mtime_nsec = st.st_mtim.tv_nsec;
+#endif
+    stamp->size = st.st_size;
+
+    return TRUE;
+}
+
+static inline gboolean
+esconf_file_stamp_equal(const EsconfFileStamp *a,
+                        const EsconfFileStamp *b)
+{
+    return a->dev == b->dev && a->ino == b->ino
+           && a->mtime == b->mtime && a->mtime_nsec == b->mtime_nsec
+           && a->size == b->size;
+}
+
+static void
+esconf_system_files_free(GArray *files)
+{
+    guint i;
+
+    for(i = 0; i < files->len; ++i)
+        g_free(g_array_index(files, EsconfFileStamp, i).path);
+    g_array_free(files, TRUE);
+}
+
+/* the system files of a channel other than |user_file|, in the order
+ * they have to be merged: reversed, to properly follow the xdg spec,
+ * see bug #6079 for more information */
+static GArray *
+esconf_system_layer_stat_files(gchar **filenames,
+                               const gchar *user_file)
+{
+    GArray *files = g_array_new(FALSE, FALSE, sizeof(EsconfFileStamp));
+    gint i;
+
+    for(i = filenames ? (gint)g_strv_length(filenames) - 1 : -1; i >= 0; --i) {
+        EsconfFileStamp file;
+
+        if(!g_strcmp0(user_file, filenames[i])
+           || !esconf_file_stamp_get(filenames[i], &file))
+        {
+            continue;
+        }
+
+        file.path = g_strdup(filenames[i]);
+        g_array_append_val(files, file);
+    }
+
+    return files;
+}
+
+static gboolean
+esconf_system_layer_is_current(EsconfSystemLayer *layer,
+                               GArray *files)
+{
+    guint i;
+
+    if(layer->files->len != files->len)
+        return FALSE;
+
+    for(i = 0; i < files->len; ++i) {
+        EsconfFileStamp *a = &g_array_index(layer->files, EsconfFileStamp, i);
+        EsconfFileStamp *b = &g_array_index(files, EsconfFileStamp, i);
+
+        if(!esconf_file_stamp_equal(a, b) || strcmp(a->path, b->path))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* parses and merges |files|, taking ownership of the array */
+static EsconfSystemLayer *
+esconf_system_layer_new(EsconfBackendPerchannelXml *xbpx,
+                        GArray *files)
+{
+    EsconfSystemLayer *layer;
+    EsconfChannel channel = { NULL, };
+    guint i;
+
+    channel.arena = esconf_arena_new();
+    channel.properties = esconf_arena_new_node(channel.arena,
+                                               esconf_arena_intern(channel.arena, "/"));
+
+    for(i = 0; i < files->len; ++i) {
+        esconf_backend_perchannel_xml_merge_file(xbpx,
+                                                 g_array_index(files, EsconfFileStamp, i).path,
+                                                 TRUE, &channel, NULL);
+    }
+
+    layer = g_slice_new0(EsconfSystemLayer);
+    layer->ref_count = 1;
+    layer->files = files;
+    layer->arena = channel.arena;
+    layer->properties = channel.properties;
+    layer->locked = channel.locked;
+
+    return layer;
+}
+
+static EsconfSystemLayer *
+esconf_system_layer_ref(EsconfSystemLayer *layer)
+{
+    ++layer->ref_count;
+    return layer;
+}
+
+static void
+esconf_system_layer_unref(EsconfSystemLayer *layer)
+{
+    if(--layer->ref_count > 0)
+        return;
+
+    esconf_system_files_free(layer->files);
+    if(layer->arena->owns_values)
+        esconf_proptree_clear_values(layer->properties);
+    esconf_arena_free(layer->arena);
+    g_slice_free(EsconfSystemLayer, layer);
+}
+
+static EsconfPropertyNode *
+esconf_system_layer_copy_node(EsconfArena *arena,
+                              EsconfPropertyNode *layer_node)
+{
+    const EsconfProperty *layer_prop = &layer_node->prop;
+    EsconfProperty *prop;
+    EsconfPropertyNode *node, *child, **link;
+
+    /* the layer outlives the channel, see esconf_channel_destroy(), so
+     * neither the name nor strings and arrays need to be copied */
+    node = esconf_arena_new_node(arena, layer_prop->name);
+    prop = &node->prop;
+    prop->locked = layer_prop->locked;
+    prop->system_value = layer_prop->system_value;
+    prop->system_value_type = layer_prop->system_value_type;
+    prop->system_borrowed = TRUE;
+
+    /* keeping the link to fill in saves walking the list of children
+     * for every one */
+    link = &node->children;
+    for(child = layer_node->children; child; child = child->next) {
+        *link = esconf_system_layer_copy_node(arena, child);
+        (*link)->parent = node;
+        link = &(*link)->next;
+    }
+
+    return node;
+}
+
+/* a new property tree for a channel, with the system values of |layer|,
+ * allocated from |arena|.  the channel has to keep a reference on
+ * |layer| as long as it uses the tree. */
+static EsconfPropertyNode *
+esconf_system_layer_instantiate(EsconfSystemLayer *layer,
+                                EsconfArena *arena)
+{
+    return esconf_system_layer_copy_node(arena, layer->properties);
+}
+
+/* looks up the system files and the user file of a channel, returns
+ * FALSE if there are none */
+static gboolean
+esconf_backend_perchannel_xml_find_files(const gchar *channel_name,
+                                         gchar ***filenames,
+                                         gchar **user_file)
+{
+    gchar *filename_stem;
+
+    filename_stem = g_strdup_printf(CONFIG_FILE_FMT, channel_name);
+    *filenames = expidus_resource_lookup_all(EXPIDUS_RESOURCE_CONFIG, filename_stem);
+    *user_file = expidus_resource_save_location(EXPIDUS_RESOURCE_CONFIG,
+                                             filename_stem, FALSE);
+    g_free(filename_stem);
+
+    if((!*filenames || !(*filenames)[0]) && !*user_file) {
+        g_strfreev(*filenames);
+        *filenames = NULL;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* builds a channel from its files.  with @share_layer, the system layer
+ * is taken from, or put in, xbpx->system_layers; otherwise a private
+ * one is parsed and nothing in xbpx is touched, so this can run off the
+ * main thread.  if the user file can't be read, the channel holds what
+ * could be read of it and @error is set. */
+static EsconfChannel *
+esconf_backend_perchannel_xml_build_channel(EsconfBackendPerchannelXml *xbpx,
+                                            const gchar *channel_name,
+                                            gchar **filenames,
+                                            const gchar *user_file,
+                                            gboolean share_layer,
+                                            GError **error)
+{
+    EsconfChannel *channel;
+    GArray *system_files;
+    EsconfSystemLayer *layer;
+    gchar *layer_key;
+
+    /* the system files rarely change, so they are only parsed again
+     * if one of them has been modified, added or removed since the
+     * last time this channel was loaded */
+    system_files = esconf_system_layer_stat_files(filenames, user_file);
+    if(share_layer) {
+        layer_key = g_ascii_strdown(channel_name, -1);
+        layer = g_hash_table_lookup(xbpx->system_layers, layer_key);
+        if(!layer || !esconf_system_layer_is_current(layer, system_files)) {
+            layer = esconf_system_layer_new(xbpx, system_files);
+            g_hash_table_replace(xbpx->system_layers, layer_key, layer);
+        } else {
+            esconf_system_files_free(system_files);
+            g_free(layer_key);
+        }
+        esconf_system_layer_ref(layer);
+    } else
+        layer = esconf_system_layer_new(xbpx, system_files);
+
+    channel = g_slice_new0(EsconfChannel);
+    channel->system_layer = layer;
+    channel->arena = esconf_arena_new();
+    channel->properties = esconf_system_layer_instantiate(layer, channel->arena);
+    channel->locked = layer->locked;
+
+    /* stat before reading, so a change made while the file is being
+     * parsed is not mistaken for what was read */
+    esconf_file_stamp_get(user_file, &channel->user_file);
+
+    if(!channel->locked && user_file) {
+        /* read in user file */
+        esconf_backend_perchannel_xml_merge_file(xbpx, user_file, FALSE,
+                                                 channel, error);
+    }
+
+    return channel;
+}
+
+/* reads a channel from disk without adding it to the loaded channels */
+static EsconfChannel *
+esconf_backend_perchannel_xml_read_channel(EsconfBackendPerchannelXml *xbpx,
+                                           const gchar *channel_name,
+                                           GError **error)
+{
+    EsconfChannel *channel;
+    gchar **filenames, *user_file;
+
+    TRACE("entering");
+
+    if(!esconf_backend_perchannel_xml_find_files(channel_name, &filenames,
+                                                 &user_file))
+    {
+        if(error) {
+            g_set_error(error, ESCONF_ERROR,
+                        ESCONF_ERROR_CHANNEL_NOT_FOUND,
+                        _("Channel \"%s\" does not exist"), channel_name);
+        }
+        return NULL;
+    }
+
+    channel = esconf_backend_perchannel_xml_build_channel(xbpx, channel_name,
+                                                          filenames, user_file,
+                                                          TRUE, NULL);
+
+    g_strfreev(filenames);
+    g_free(user_file);
+
+    return channel;
+}
+
+static void
+esconf_preload_free(EsconfPreload *preload)
+{
+    g_free(preload->channel_name);
+    g_strfreev(preload->filenames);
+    g_free(preload->user_file);
+    if(preload->channel)
+        esconf_channel_destroy(preload->channel);
+    g_slice_free(EsconfPreload, preload);
+}
+
+/* turns a finished preload into a loaded channel, unless the channel
+ * got loaded some other way in the meantime or its files changed while
+ * they were read, and forgets about it */
+static EsconfChannel *
+esconf_backend_perchannel_xml_publish_preload(EsconfBackendPerchannelXml *xbpx,
+                                              EsconfPreload *preload)
+{
+    EsconfChannel *channel;
+
+    channel = g_hash_table_lookup(xbpx->channels, preload->channel_name);
+    if(!channel && preload->channel && !preload->stale) {
+        channel = preload->channel;
+        preload->channel = NULL;
+
+        if(!g_hash_table_lookup(xbpx->system_layers, preload->channel_name)) {
+            g_hash_table_insert(xbpx->system_layers,
+                                g_strdup(preload->channel_name),
+                                esconf_system_layer_ref(channel->system_layer));
+        }
+        g_hash_table_insert(xbpx->channels, g_strdup(preload->channel_name),
+                            channel);
+    }
+
+    g_hash_table_remove(xbpx->preloads, preload->channel_name);
+
+    return channel;
+}
+
+static gboolean
+esconf_backend_perchannel_xml_publish_preloads(gpointer data)
+{
+    EsconfBackendPerchannelXml *xbpx = data;
+    GHashTableIter iter;
+    EsconfPreload *preload;
+    GSList *done = NULL, *l;
+
+    g_mutex_lock(&xbpx->preload_lock);
+    xbpx->preload_idle_id = 0;
+    g_hash_table_iter_init(&iter, xbpx->preloads);
+    while(g_hash_table_iter_next(&iter, NULL, (gpointer)&preload)) {
+        if(preload->done)
+            done = g_slist_prepend(done, preload);
+    }
+    g_mutex_unlock(&xbpx->preload_lock);
+
+    /* the pool is done with these, no need to hold the lock */
+    for(l = done; l; l = l->next)
+        esconf_backend_perchannel_xml_publish_preload(xbpx, l->data);
+    g_slist_free(done);
+
+    return FALSE;
+}
+
+static void
+esconf_backend_perchannel_xml_preload_thread(gpointer data,
+                                             gpointer user_data)
+{
+    EsconfPreload *preload = data;
+    EsconfBackendPerchannelXml *xbpx = user_data;
+    EsconfChannel *channel;
+
+    channel = esconf_backend_perchannel_xml_build_channel(xbpx,
+                                                          preload->channel_name,
+                                                          preload->filenames,
+                                                          preload->user_file,
+                                                          FALSE, NULL);
+
+    g_mutex_lock(&xbpx->preload_lock);
+    preload->channel = channel;
+    preload->done = TRUE;
+    g_cond_broadcast(&xbpx->preload_cond);
+    if(!xbpx->preload_idle_id) {
+        xbpx->preload_idle_id = g_idle_add(esconf_backend_perchannel_xml_publish_preloads,
+                                           xbpx);
+    }
+    g_mutex_unlock(&xbpx->preload_lock);
+}
+
+static void
+esconf_backend_perchannel_xml_start_preload(EsconfBackendPerchannelXml *xbpx)
+{
+    gint i;
+
+    /* these are registered on first use, which must not happen on
+     * several threads at once */
+    g_type_ensure(ESCONF_TYPE_UINT16);
+    g_type_ensure(ESCONF_TYPE_INT16);
+
+    xbpx->preloads = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+                                           (GDestroyNotify)esconf_preload_free);
+    xbpx->preload_pool = g_thread_pool_new(esconf_backend_perchannel_xml_preload_thread,
+                                           xbpx,
+                                           CLAMP(g_get_num_processors(), 1,
+                                                 PRELOAD_MAX_THREADS),
+                                           FALSE, NULL);
+
+    for(i = 0; xbpx->preload_channels[i]; ++i) {
+        EsconfPreload *preload;
+        gchar *channel_name = g_ascii_strdown(xbpx->preload_channels[i], -1);
+
+        if(g_hash_table_lookup(xbpx->preloads, channel_name)
+           || g_hash_table_lookup(xbpx->channels, channel_name))
+        {
+            g_free(channel_name);
+            continue;
+        }
+
+        preload = g_slice_new0(EsconfPreload);
+        preload->channel_name = channel_name;
+
+        /* the resource lookups aren't thread-safe, so they are done
+         * here and the pool only parses */
+        if(!esconf_backend_perchannel_xml_find_files(channel_name,
+                                                     &preload->filenames,
+                                                     &preload->user_file))
+        {
+            esconf_preload_free(preload);
+            continue;
+        }
+
+        g_hash_table_insert(xbpx->preloads, preload->channel_name, preload);
+        g_thread_pool_push(xbpx->preload_pool, preload, NULL);
+    }
 }
 
 static EsconfChannel *
@@ -1634,12 +3271,45 @@ esconf_backend_perchannel_xml_load_channel(EsconfBackendPerchannelXml *xbpx,
                                            const gchar *channel_name,
                                            GError **error)
 {
-    EsconfChannel *channel = NULL;
-    gchar *filename_stem, **filenames, *user_file;
-    gint i, length;
-    EsconfProperty *prop;
+    EsconfChannel *channel;
 
-    TRACE("entering");
+    if(xbpx->preloads && g_hash_table_size(xbpx->preloads)) {
+        gchar *key = g_ascii_strdown(channel_name, -1);
+        EsconfPreload *preload = g_hash_table_lookup(xbpx->preloads, key);
+
+        g_free(key);
+        if(preload) {
+            /* it is being read already, waiting for that is never
+             * slower than reading it again */
+            g_mutex_lock(&xbpx->preload_lock);
+            while(!preload->done)
+                g_cond_wait(&xbpx->preload_cond, &xbpx->preload_lock);
+            g_mutex_unlock(&xbpx->preload_lock);
+
+            channel = esconf_backend_perchannel_xml_publish_preload(xbpx, preload);
+            if(channel)
+                return channel;
+        }
+    }
+
+    channel = esconf_backend_perchannel_xml_read_channel(xbpx, channel_name,
+                                                         error);
+    if(channel)
+        g_hash_table_insert(xbpx->channels, g_ascii_strdown(channel_name, -1), channel);
+
+    return channel;
+}
+
+/* whether the files of a loaded channel differ from what it was read
+ * from or last written to */
+static gboolean
+esconf_backend_perchannel_xml_channel_is_stale(EsconfChannel *channel,
+                                               const gchar *channel_name)
+{
+    gchar *filename_stem, **filenames, *user_file;
+    GArray *system_files;
+    EsconfFileStamp user_stamp;
+    gboolean stale;
 
     filename_stem = g_strdup_printf(CONFIG_FILE_FMT, channel_name);
     filenames = expidus_resource_lookup_all(EXPIDUS_RESOURCE_CONFIG, filename_stem);
@@ -1647,105 +3317,493 @@ esconf_backend_perchannel_xml_load_channel(EsconfBackendPerchannelXml *xbpx,
                                             filename_stem, FALSE);
     g_free(filename_stem);
 
-    if((!filenames || !filenames[0]) && !user_file) {
-        if(error) {
-            g_set_error(error, ESCONF_ERROR,
-                        ESCONF_ERROR_CHANNEL_NOT_FOUND,
-                        _("Channel \"%s\" does not exist"), channel_name);
+    system_files = esconf_system_layer_stat_files(filenames, user_file);
+    if(channel->system_layer)
+        stale = !esconf_system_layer_is_current(channel->system_layer, system_files);
+    else
+        stale = system_files->len > 0;
+
+    if(!stale) {
+        esconf_file_stamp_get(user_file, &user_stamp);
+        stale = !esconf_file_stamp_equal(&channel->user_file, &user_stamp);
+    }
+
+    esconf_system_files_free(system_files);
+    g_strfreev(filenames);
+    g_free(user_file);
+
+    return stale;
+}
+
+/* appends the name of |child| to the property name |path| of its
+ * parent, which is |len| long.  returns the new length, or 0 if the
+ * name doesn't fit */
+static gsize
+esconf_proptree_path_append(gchar *path,
+                            gsize len,
+                            EsconfPropertyNode *child)
+{
+    const gchar *name = child->prop.name;
+    gsize name_len = strlen(name);
+
+    if(len + 1 + name_len >= MAX_PROP_PATH)
+        return 0;
+
+    path[len] = '/';
+    memcpy(path + len + 1, name, name_len + 1);
+
+    return len + 1 + name_len;
+}
+
+static EsconfPropertyNode *
+esconf_proptree_find_child(EsconfPropertyNode *node,
+                           const gchar *name)
+{
+    EsconfPropertyNode *child;
+
+    for(child = node->children; child; child = child->next) {
+        if(!strcmp(child->prop.name, name))
+            return child;
+    }
+
+    return NULL;
+}
+
+/* adds the names of all properties under |node| (included) that have
+ * a value to |changed| */
+static void
+esconf_proptree_collect_names(EsconfPropertyNode *node,
+                              gchar *path,
+                              gsize len,
+                              GSList **changed)
+{
+    EsconfProperty *prop = &node->prop;
+    EsconfPropertyNode *child;
+    gsize child_len;
+
+    if(len > 0 && (prop->value_type || prop->system_value_type))
+        *changed = g_slist_prepend(*changed, g_strndup(path, len));
+
+    for(child = node->children; child; child = child->next) {
+        child_len = esconf_proptree_path_append(path, len, child);
+        if(child_len)
+            esconf_proptree_collect_names(child, path, child_len, changed);
+    }
+}
+
+/* adds the names of the properties whose value differs between the
+ * trees under |old_node| and |new_node| to |changed|, including the
+ * ones that only exist on one side */
+static void
+esconf_proptree_diff(EsconfPropertyNode *old_node,
+                     EsconfPropertyNode *new_node,
+                     gchar *path,
+                     gsize len,
+                     GSList **changed)
+{
+    const GValue *old_value, *new_value;
+    GValue old_view = { 0, }, new_view = { 0, };
+    EsconfPropertyNode *old_child, *new_child;
+    GHashTable *new_children = NULL;
+    gsize child_len;
+
+    if(len > 0) {
+        old_value = esconf_property_peek_effective_value(&old_node->prop, &old_view);
+        new_value = esconf_property_peek_effective_value(&new_node->prop, &new_view);
+        if(!_esconf_gvalue_is_equal(old_value, new_value))
+            *changed = g_slist_prepend(*changed, g_strndup(path, len));
+    }
+
+    /* match the children up by name; a table is only worth it for
+     * wide levels */
+    if(esconf_proptree_n_children(new_node) > 16) {
+        new_children = g_hash_table_new(g_str_hash, g_str_equal);
+        for(new_child = new_node->children;
+            new_child;
+            new_child = new_child->next)
+        {
+            g_hash_table_insert(new_children,
+                                new_child->prop.name,
+                                new_child);
         }
-        goto out;
     }
 
-    channel = g_slice_new0(EsconfChannel);
-    prop = g_slice_new0(EsconfProperty);
-    prop->name = g_strdup("/");
-    channel->properties = g_node_new(prop);
-
-    /* read in system files, we do this in reversed order to properly 
-     * follow the xdg spec, see bug #6079 for more information */
-    length = g_strv_length(filenames);
-    for(i = length - 1; i >= 0; --i) {
-        if(!g_strcmp0(user_file, filenames[i]))
+    for(old_child = old_node->children;
+        old_child;
+        old_child = old_child->next)
+    {
+        const gchar *name = old_child->prop.name;
+
+        child_len = esconf_proptree_path_append(path, len, old_child);
+        if(!child_len)
             continue;
-        esconf_backend_perchannel_xml_merge_file(xbpx, filenames[i], TRUE,
-                                                 channel, NULL);
+
+        if(new_children) {
+            new_child = g_hash_table_lookup(new_children, name);
+            if(new_child)
+                g_hash_table_remove(new_children, name);
+        } else
+            new_child = esconf_proptree_find_child(new_node, name);
+
+        if(new_child)
+            esconf_proptree_diff(old_child, new_child, path, child_len, changed);
+        else
+            esconf_proptree_collect_names(old_child, path, child_len, changed);
     }
 
-    if(!channel->locked && user_file) {
-        /* read in user file */
-        esconf_backend_perchannel_xml_merge_file(xbpx, user_file, FALSE,
-                                                 channel, NULL);
+    /* whatever is left has no counterpart in the old tree */
+    if(new_children) {
+        GHashTableIter iter;
+
+        g_hash_table_iter_init(&iter, new_children);
+        while(g_hash_table_iter_next(&iter, NULL, (gpointer *)&new_child)) {
+            child_len = esconf_proptree_path_append(path, len, new_child);
+            if(child_len)
+                esconf_proptree_collect_names(new_child, path, child_len, changed);
+        }
+        g_hash_table_destroy(new_children);
+    } else {
+        for(new_child = new_node->children;
+            new_child;
+            new_child = new_child->next)
+        {
+            const gchar *name = new_child->prop.name;
+
+            if(esconf_proptree_find_child(old_node, name))
+                continue;
+
+            child_len = esconf_proptree_path_append(path, len, new_child);
+            if(child_len)
+                esconf_proptree_collect_names(new_child, path, child_len, changed);
+        }
     }
+}
 
-    g_hash_table_insert(xbpx->channels, g_ascii_strdown(channel_name, -1), channel);
+/* reads a loaded channel again after its files changed on disk, and
+ * notifies about the properties that ended up with a different value.
+ * the files win over changes that haven't been saved yet: those are
+ * dropped, and notified about like any other change. */
+static void
+esconf_backend_perchannel_xml_reload_channel(EsconfBackendPerchannelXml *xbpx,
+                                             const gchar *channel_name)
+{
+    EsconfChannel *old_channel, *channel;
+    GSList *changed = NULL, *l;
+    gchar path[MAX_PROP_PATH];
+    gchar **filenames, *user_file;
+    GError *error = NULL;
+
+    old_channel = g_hash_table_lookup(xbpx->channels, channel_name);
+    if(!old_channel
+       || !esconf_backend_perchannel_xml_channel_is_stale(old_channel, channel_name))
+    {
+        return;
+    }
 
-out:
-    g_strfreev(filenames);
-    g_free(user_file);
+    DBG("Reloading channel \"%s\"", channel_name);
 
-    return channel;
+    if(!esconf_backend_perchannel_xml_find_files(channel_name, &filenames,
+                                                 &user_file))
+    {
+        /* all of its files are gone */
+        channel = esconf_channel_new();
+    } else {
+        channel = esconf_backend_perchannel_xml_build_channel(xbpx, channel_name,
+                                                              filenames, user_file,
+                                                              TRUE, &error);
+        g_strfreev(filenames);
+        g_free(user_file);
+
+        /* a user file that is gone only leaves the system values, but
+         * one that can't be parsed is likely still being written; the
+         * old values and stamp stay, so the next change to it is picked
+         * up again */
+        if(error && !g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+            g_warning("Keeping the previous values of channel "%s": %s",
+                      channel_name, error->message);
+            g_error_free(error);
+            esconf_channel_destroy(channel);
+            return;
+        }
+        g_clear_error(&error);
+    }
+
+    path[0] = 0;
+    esconf_proptree_diff(old_channel->properties, channel->properties,
+                         path, 0, &changed);
+
+    /* destroys the old channel */
+    g_hash_table_replace(xbpx->channels, g_strdup(channel_name), channel);
+
+    /* the locks may have changed even if no value did */
+    if(xbpx->channel_reloaded_func) {
+        xbpx->channel_reloaded_func(ESCONF_BACKEND(xbpx), channel_name,
+                                    xbpx->channel_reloaded_data);
+    }
+
+    for(l = changed; l; l = l->next) {
+        if(xbpx->prop_changed_func) {
+            xbpx->prop_changed_func(ESCONF_BACKEND(xbpx), channel_name,
+                                    l->data, xbpx->prop_changed_data);
+        }
+    }
+    g_slist_free_full(changed, g_free);
+}
+
+static gboolean
+esconf_backend_perchannel_xml_reload_timeout(gpointer data)
+{
+    EsconfBackendPerchannelXml *xbpx = ESCONF_BACKEND_PERCHANNEL_XML(data);
+    GHashTable *pending = xbpx->pending_reloads;
+    GHashTableIter iter;
+    gpointer channel_name;
+
+    xbpx->reload_id = 0;
+    xbpx->pending_reloads = NULL;
+
+    g_hash_table_iter_init(&iter, pending);
+    while(g_hash_table_iter_next(&iter, &channel_name, NULL))
+        esconf_backend_perchannel_xml_reload_channel(xbpx, channel_name);
+    g_hash_table_destroy(pending);
+
+    return FALSE;
+}
+
+static void
+esconf_backend_perchannel_xml_queue_reload(EsconfBackendPerchannelXml *xbpx,
+                                           GFile *file)
+{
+    gchar *basename = g_file_get_basename(file);
+    gsize len = basename ? strlen(basename) : 0;
+    gchar *channel_name;
+    EsconfPreload *preload;
+
+    if(len > 4 && !strcmp(basename + len - 4, ".xml")) {
+        basename[len - 4] = 0;
+        channel_name = g_ascii_strdown(basename, -1);
+
+        /* channels that aren't in memory are read from disk anyway the
+         * next time they are used */
+        if(g_hash_table_lookup(xbpx->channels, channel_name)) {
+            if(!xbpx->pending_reloads) {
+                xbpx->pending_reloads = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                              g_free, NULL);
+            }
+            g_hash_table_add(xbpx->pending_reloads, channel_name);
+        } else {
+            /* a preload may have read the files before the change, it
+             * is read again when it is needed instead */
+            preload = xbpx->preloads
+                      ? g_hash_table_lookup(xbpx->preloads, channel_name)
+                      : NULL;
+            if(preload)
+                preload->stale = TRUE;
+            g_free(channel_name);
+        }
+    }
+
+    g_free(basename);
+}
+
+static void
+esconf_backend_perchannel_xml_file_changed(GFileMonitor *monitor,
+                                           GFile *file,
+                                           GFile *other_file,
+                                           GFileMonitorEvent event_type,
+                                           gpointer user_data)
+{
+    EsconfBackendPerchannelXml *xbpx = ESCONF_BACKEND_PERCHANNEL_XML(user_data);
+
+    switch(event_type) {
+        case G_FILE_MONITOR_EVENT_CHANGED:
+        case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+        case G_FILE_MONITOR_EVENT_DELETED:
+        case G_FILE_MONITOR_EVENT_CREATED:
+        case G_FILE_MONITOR_EVENT_RENAMED:
+        case G_FILE_MONITOR_EVENT_MOVED_IN:
+        case G_FILE_MONITOR_EVENT_MOVED_OUT:
+            break;
+
+        default:
+            return;
+    }
+
+    esconf_backend_perchannel_xml_queue_reload(xbpx, file);
+    if(other_file)
+        esconf_backend_perchannel_xml_queue_reload(xbpx, other_file);
+
+    /* reload once things have been quiet for a moment, so a file that
+     * is still being written, or a tool replacing many files, results
+     * in a single reload per channel */
+    if(xbpx->pending_reloads) {
+        if(xbpx->reload_id)
+            g_source_remove(xbpx->reload_id);
+        xbpx->reload_id = g_timeout_add(RELOAD_TIMEOUT,
+                                        esconf_backend_perchannel_xml_reload_timeout,
+                                        xbpx);
+    }
+}
+
+static void
+esconf_backend_perchannel_xml_watch_dirs(EsconfBackendPerchannelXml *xbpx)
+{
+    gchar **dirs;
+    gint i;
+
+    dirs = expidus_resource_dirs(EXPIDUS_RESOURCE_CONFIG);
+    for(i = 0; dirs && dirs[i]; ++i) {
+        gchar *path = g_build_filename(dirs[i], CONFIG_DIR_STEM, NULL);
+        GFile *dir = g_file_new_for_path(path);
+        GFileMonitor *monitor;
+        GError *error = NULL;
+
+        /* directories that don't exist (yet) are watched too */
+        monitor = g_file_monitor_directory(dir, G_FILE_MONITOR_WATCH_MOVES,
+                                           NULL, &error);
+        if(monitor) {
+            g_signal_connect(monitor, "changed",
+                             G_CALLBACK(esconf_backend_perchannel_xml_file_changed),
+                             xbpx);
+            xbpx->monitors = g_list_prepend(xbpx->monitors, monitor);
+        } else {
+            g_warning("Unable to monitor \"%s\": %s", path, error->message);
+            g_error_free(error);
+        }
+
+        g_object_unref(dir);
+        g_free(path);
+    }
+    g_strfreev(dirs);
+}
+
+
+/* appends |str| to |out| the way g_markup_escape_text() would escape
+ * it, without making an escaped copy first.  unlike there, tabs and
+ * line breaks are written as character references too, since they are
+ * only used in attribute values, where a parser turns them into
+ * spaces */
+static void
+esconf_xml_append_escaped(GString *out,
+                          const gchar *str)
+{
+    const guchar *p = (const guchar *)str, *run = p;
+
+    for(; *p; ++p) {
+        const gchar *entity = NULL;
+        gchar charref[8];
+
+        switch(*p) {
+            case '&':  entity = "&amp;"; break;
+            case '<':  entity = "&lt;"; break;
+            case '>':  entity = "&gt;"; break;
+            case '"':  entity = "&quot;"; break;
+            case '\'': entity = "&apos;"; break;
+            case '\t': entity = "&#x9;"; break;
+            case '\n': entity = "&#xA;"; break;
+            case '\r': entity = "&#xD;"; break;
+            default:
+                if(*p < 0x20 || *p == 0x7f) {
+                    g_snprintf(charref, sizeof(charref), "&#x%x;", *p);
+                    entity = charref;
+                } else if(*p == 0xc2 && p[1] >= 0x80 && p[1] <= 0x9f && p[1] != 0x85) {
+                    /* C1 control characters */
+                    g_string_append_len(out, (const gchar *)run, p - run);
+                    g_string_append_printf(out, "&#x%x;", p[1]);
+                    run = p + 2;
+                    ++p;
+                }
+                break;
+        }
+
+        if(entity) {
+            g_string_append_len(out, (const gchar *)run, p - run);
+            g_string_append(out, entity);
+            run = p + 1;
+        }
+    }
+
+    g_string_append_len(out, (const gchar *)run, p - run);
+}
+
+static inline void
+esconf_xml_append_indent(GString *out,
+                         gint depth)
+{
+    static const gchar spaces[] = "                                ";
+    gsize len = depth * 2;
+
+    while(len > sizeof(spaces) - 1) {
+        g_string_append_len(out, spaces, sizeof(spaces) - 1);
+        len -= sizeof(spaces) - 1;
+    }
+    g_string_append_len(out, spaces, len);
 }
 
+/* appends ' type="..." value="..."' for |value| to |out|, and for arrays
+ * the closing '>' and the <value> elements */
 static gboolean
-esconf_format_xml_tag(GString *elem_str,
-                      GValue *value,
+esconf_format_xml_tag(GString *out,
+                      const GValue *value,
                       gboolean is_array_value,
-                      gchar spaces[MAX_PROP_PATH],
+                      gint depth,
                       gboolean *is_array)
 {
-    gchar *tmp;
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+    const gchar *type = NULL;
 
     switch(G_VALUE_TYPE(value)) {
         case G_TYPE_STRING:
-            tmp = g_markup_escape_text(g_value_get_string(value), -1);
-            g_string_append_printf(elem_str, " type=\"string\" value=\"%s\"",
-                                   tmp);
-            g_free(tmp);
-            break;
+            g_string_append(out, " type=\"string\" value=\"");
+            esconf_xml_append_escaped(out, g_value_get_string(value));
+            g_string_append_c(out, '"');
+            return TRUE;
 
         case G_TYPE_UCHAR:
-            g_string_append_printf(elem_str, " type=\"uchar\" value=\"%hhu\"",
-                                   g_value_get_uchar(value));
+            type = "uchar";
+            g_snprintf(buf, sizeof(buf), "%hhu", g_value_get_uchar(value));
             break;
 
         case G_TYPE_CHAR:
-            g_string_append_printf(elem_str, " type=\"char\" value=\"%hhd\"",
-                                   g_value_get_uchar(value));
+            type = "char";
+            g_snprintf(buf, sizeof(buf), "%hhd", g_value_get_uchar(value));
             break;
 
         case G_TYPE_UINT:
-            g_string_append_printf(elem_str, " type=\"uint\" value=\"%u\"",
-                                   g_value_get_uint(value));
+            type = "uint";
+            g_snprintf(buf, sizeof(buf), "%u", g_value_get_uint(value));
             break;
 
         case G_TYPE_INT:
-            g_string_append_printf(elem_str, " type=\"int\" value=\"%d\"",
-                                   g_value_get_int(value));
+            type = "int";
+            g_snprintf(buf, sizeof(buf), "%d", g_value_get_int(value));
             break;
 
         case G_TYPE_UINT64:
-            g_string_append_printf(elem_str, " type=\"uint64\" value=\"%" G_GUINT64_FORMAT "\"",
-                                   g_value_get_uint64(value));
+            type = "uint64";
+            g_snprintf(buf, sizeof(buf), "%" G_GUINT64_FORMAT,
+                       g_value_get_uint64(value));
             break;
 
         case G_TYPE_INT64:
-            g_string_append_printf(elem_str, " type=\"int64\" value=\"%" G_GINT64_FORMAT "\"",
-                                   g_value_get_int64(value));
+            type = "int64";
+            g_snprintf(buf, sizeof(buf), "%" G_GINT64_FORMAT,
+                       g_value_get_int64(value));
             break;
 
         case G_TYPE_FLOAT:
-            g_string_append_printf(elem_str, " type=\"float\" value=\"%f\"",
-                                   (gdouble)g_value_get_float(value));
+            type = "float";
+            _esconf_format_float(buf, g_value_get_float(value));
             break;
 
         case G_TYPE_DOUBLE:
-            g_string_append_printf(elem_str, " type=\"double\" value=\"%f\"",
-                                   g_value_get_double(value));
+            type = "double";
+            _esconf_format_double(buf, g_value_get_double(value));
             break;
 
         case G_TYPE_BOOLEAN:
-            g_string_append_printf(elem_str, " type=\"bool\" value=\"%s\"",
-                                   g_value_get_boolean(value) ? "true" : "false");
+            type = "bool";
+            g_strlcpy(buf, g_value_get_boolean(value) ? "true" : "false",
+                      sizeof(buf));
             break;
 
         default:
@@ -1759,15 +3817,14 @@ esconf_format_xml_tag(GString *elem_str,
                 if(is_array_value)
                     return FALSE;
 
-                g_string_append(elem_str, " type=\"array\">\n");
+                g_string_append(out, " type=\"array\">\n");
 
                 strlist = g_value_get_boxed(value);
                 for(i = 0; strlist[i]; ++i) {
-                    gchar *value_str = g_markup_escape_text(strlist[i], -1);
-                    g_string_append_printf(elem_str,
-                                           "%s  <value type=\"string\" value=\"%s\"/>\n",
-                                           spaces, value_str);
-                    g_free(value_str);
+                    esconf_xml_append_indent(out, depth + 1);
+                    g_string_append(out, "<value type=\"string\" value=\"");
+                    esconf_xml_append_escaped(out, strlist[i]);
+                    g_string_append(out, "\"/>\n");
                 }
 
                 *is_array = TRUE;
@@ -1778,20 +3835,21 @@ esconf_format_xml_tag(GString *elem_str,
                 if(is_array_value)
                     return FALSE;
 
-                g_string_append(elem_str, " type=\"array\">\n");
+                g_string_append(out, " type=\"array\">\n");
 
                 arr = g_value_get_boxed(value);
                 for(i = 0; i < arr->len; ++i) {
                     GValue *value1 = g_ptr_array_index(arr, i);
                     gboolean dummy;
 
-                    g_string_append_printf(elem_str, "%s  <value", spaces);
-                    if(!esconf_format_xml_tag(elem_str, value1, TRUE, spaces,
+                    esconf_xml_append_indent(out, depth + 1);
+                    g_string_append(out, "<value");
+                    if(!esconf_format_xml_tag(out, value1, TRUE, depth + 1,
                                               &dummy))
                     {
                         return FALSE;
                     }
-                    g_string_append(elem_str, "/>\n");
+                    g_string_append(out, "/>\n");
                 }
 
                 *is_array = TRUE;
@@ -1802,70 +3860,59 @@ esconf_format_xml_tag(GString *elem_str,
                 if(G_VALUE_TYPE(value) != G_TYPE_INVALID) {
                     g_warning("Unknown value type %d (\"%s\"), treating as branch",
                               (int)G_VALUE_TYPE(value), G_VALUE_TYPE_NAME(value));
-                    g_value_unset(value);
                 }
 
-                is_array = FALSE;
-                g_string_append(elem_str, " type=\"empty\"");
+                g_string_append(out, " type=\"empty\"");
             }
-            break;
+            return TRUE;
     }
 
+    g_string_append(out, " type=\"");
+    g_string_append(out, type);
+    g_string_append(out, "\" value=\"");
+    g_string_append(out, buf);
+    g_string_append_c(out, '"');
+
     return TRUE;
 }
 
 static gboolean
 esconf_backend_perchannel_xml_write_node(EsconfBackendPerchannelXml *xbpx,
-                                         FILE *fp,
-                                         GNode *node,
+                                         GString *out,
+                                         EsconfPropertyNode *node,
                                          gint depth,
                                          GError **error)
 {
-    EsconfProperty *prop = node->data;
-    GValue *value = &prop->value;
-    GString *elem_str;
-    gchar spaces[MAX_PROP_PATH];
-    GNode *child;
-    gchar *escaped_name;
+    EsconfProperty *prop = &node->prop;
+    GValue view = { 0, };
+    const GValue *value;
+    EsconfPropertyNode *child;
     gboolean is_array = FALSE;
-    
-    if(depth * 2 > (gint) sizeof(spaces) + 1)
-        depth = sizeof(spaces) / 2 - 1;
-
-    memset(spaces, ' ', depth * 2);
-    spaces[depth * 2] = 0;
-
-    escaped_name = g_markup_escape_text(prop->name, strlen(prop->name));
 
-    elem_str = g_string_sized_new(128);
-    g_string_append_printf(elem_str, "%s<property name=\"%s\"", spaces,
-                           escaped_name);
+    value = esconf_value_data_peek(&prop->value, prop->value_type, &view);
+    if(!value)
+        value = &view;  /* an empty property */
 
-    g_free (escaped_name);
+    esconf_xml_append_indent(out, depth);
+    g_string_append(out, "<property name=\"");
+    esconf_xml_append_escaped(out, prop->name);
+    g_string_append_c(out, '"');
 
-    if(!esconf_format_xml_tag(elem_str, value, FALSE, spaces, &is_array)) {
+    if(!esconf_format_xml_tag(out, value, FALSE, depth, &is_array)) {
         /* _flush_channel() will handle |error| */
-        g_string_free(elem_str, TRUE);
         return FALSE;
     }
 
-    child = g_node_first_child(node);
+    child = node->children;
     if(!is_array) {
         if(child)
-            g_string_append(elem_str, ">\n");
+            g_string_append(out, ">\n");
         else
-            g_string_append(elem_str, "/>\n");
+            g_string_append(out, "/>\n");
     }
 
-    if(fputs(elem_str->str, fp) == EOF) {
-        /* _flush_channel() will handle |error| */
-        g_string_free(elem_str, TRUE);
-        return FALSE;
-    }
-    g_string_free(elem_str, TRUE);
-
-    for(; child; child = g_node_next_sibling(child)) {
-        if(!esconf_backend_perchannel_xml_write_node(xbpx, fp, child,
+    for(; child; child = child->next) {
+        if(!esconf_backend_perchannel_xml_write_node(xbpx, out, child,
                                                      depth + 1, error))
         {
             /* _flush_channel() will handle |error| */
@@ -1873,30 +3920,51 @@ esconf_backend_perchannel_xml_write_node(EsconfBackendPerchannelXml *xbpx,
         }
     }
 
-    if(is_array || g_node_first_child(node)) {
-        if(fputs(spaces, fp) == EOF || fputs("</property>\n", fp) == EOF) {
-            /* _flush_channel() will handle |error| */
-            return FALSE;
-        }
+    if(is_array || node->children) {
+        esconf_xml_append_indent(out, depth);
+        g_string_append(out, "</property>\n");
     }
 
     return TRUE;
 }
 
+static void
+esconf_channel_write_set_error(const gchar *channel_name,
+                               gint errnum,
+                               GError **error)
+{
+    if(error && !*error) {
+        g_set_error(error, ESCONF_ERROR,
+                    ESCONF_ERROR_WRITE_FAILURE,
+                    _("Unable to write channel \"%s\": %s"),
+                    channel_name, strerror(errnum));
+    }
+}
+
+/* renders a channel and writes it to a temporary file next to the real
+ * one.  on success, the file is still open and has to be put in place
+ * with esconf_channel_write_commit(); either way |cw| has to be
+ * released with esconf_channel_write_finish() */
 static gboolean
-esconf_backend_perchannel_xml_flush_channel(EsconfBackendPerchannelXml *xbpx,
+esconf_backend_perchannel_xml_write_channel(EsconfBackendPerchannelXml *xbpx,
                                             const gchar *channel_name,
+                                            EsconfChannelWrite *cw,
                                             GError **error)
 {
     gboolean ret = FALSE;
-    EsconfChannel *channel = g_hash_table_lookup(xbpx->channels, channel_name);
-    GNode *child;
-    gchar *filename = NULL, *filename_tmp = NULL;
-    FILE *fp = NULL;
+    EsconfPropertyNode *child;
+    GString *out = NULL;
+    const gchar *p;
+    gsize left;
 
     DBG("Flushed dirty channel \"%s\"", channel_name);
 
-    if(!channel) {
+    memset(cw, 0, sizeof(*cw));
+    cw->channel_name = channel_name;
+    cw->channel = g_hash_table_lookup(xbpx->channels, channel_name);
+    cw->fd = -1;
+
+    if(!cw->channel) {
         if(error) {
             g_set_error(error, ESCONF_ERROR,
                         ESCONF_ERROR_CHANNEL_NOT_FOUND,
@@ -1905,70 +3973,195 @@ esconf_backend_perchannel_xml_flush_channel(EsconfBackendPerchannelXml *xbpx,
         return FALSE;
     }
 
-    filename = g_strdup_printf("%s/%s.xml", xbpx->config_save_path, channel_name);
-    filename_tmp = g_strconcat(filename, ".new", NULL);
+    /* render the whole file into one buffer, then write it out in one
+     * go; the buffer is kept around between flushes */
+    out = xbpx->write_buf;
+    xbpx->write_buf = NULL;
+    if(out)
+        g_string_truncate(out, 0);
+    else
+        out = g_string_sized_new(4096);
 
-    fp = fopen(filename_tmp, "w");
-    if(!fp)
-        goto out;
+    g_string_append(out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n"
+                         "<channel name=\"");
+    esconf_xml_append_escaped(out, channel_name);
+    g_string_append(out, "\" version=\"" FILE_VERSION_MAJOR "." FILE_VERSION_MINOR "\">\n");
 
-    if(fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n", fp) == EOF
-       || fprintf(fp, "<channel name=\"%s\" version=\"%s.%s\">\n", channel_name,
-                  FILE_VERSION_MAJOR, FILE_VERSION_MINOR) < 0)
-    {
-        goto out;
+    for(child = cw->channel->properties->children; child; child = child->next) {
+        if(!esconf_backend_perchannel_xml_write_node(xbpx, out, child, 1, error))
+            goto out;
     }
 
-    for(child = g_node_first_child(channel->properties);
-        child;
-        child = g_node_next_sibling(child))
-    {
-        if(!esconf_backend_perchannel_xml_write_node(xbpx, fp, child, 1, error))
+    g_string_append(out, "</channel>\n");
+
+    cw->filename = g_strdup_printf("%s/%s.xml", xbpx->config_save_path, channel_name);
+    cw->filename_tmp = g_strconcat(cw->filename, ".new", NULL);
+
+    cw->fd = open(cw->filename_tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if(cw->fd < 0)
+        goto out;
+
+    for(p = out->str, left = out->len; left > 0;) {
+        gssize written = write(cw->fd, p, left);
+
+        if(written < 0) {
+            if(errno == EINTR)
+                continue;
             goto out;
+        }
+        p += written;
+        left -= written;
     }
 
-    if(fputs("</channel>\n", fp) == EOF)
-        goto out;
+    ret = TRUE;
 
-    if(fflush(fp))
-        goto out;
+out:
+    if(!ret)
+        esconf_channel_write_set_error(channel_name, errno, error);
+
+    /* don't hold on to the buffer of an unusually big channel */
+    if(out->allocated_len > WRITE_BUF_KEEP_SIZE)
+        g_string_free(out, TRUE);
+    else
+        xbpx->write_buf = out;
+
+    return ret;
+}
 
+static gboolean
+esconf_channel_write_sync(EsconfChannelWrite *cw)
+{
 #if defined(HAVE_FDATASYNC)
-    if(fdatasync(fileno(fp)))
-        goto out;
+    return fdatasync(cw->fd) == 0;
 #elif defined(HAVE_FSYNC)
-    if(fsync(fileno(fp)))
-        goto out;
+    return fsync(cw->fd) == 0;
 #else
     sync();
+    return TRUE;
 #endif
+}
 
-    if(fclose(fp)) {
-        fp = NULL;
-        goto out;
+static gboolean
+esconf_channel_write_commit(EsconfChannelWrite *cw)
+{
+    gint fd = cw->fd;
+
+    cw->fd = -1;
+    if(close(fd) || rename(cw->filename_tmp, cw->filename))
+        return FALSE;
+
+    /* remember what we wrote, so the monitor doesn't reload it */
+    esconf_file_stamp_get(cw->filename, &cw->channel->user_file);
+
+    return TRUE;
+}
+
+static void
+esconf_channel_write_finish(EsconfChannelWrite *cw,
+                            gboolean committed)
+{
+    if(cw->fd >= 0)
+        close(cw->fd);
+    if(!committed && cw->filename_tmp)
+        unlink(cw->filename_tmp);
+
+    g_free(cw->filename);
+    g_free(cw->filename_tmp);
+
+    if(cw->channel)
+        cw->channel->dirty = FALSE;
+
+    memset(cw, 0, sizeof(*cw));
+    cw->fd = -1;
+}
+
+static gboolean
+esconf_backend_perchannel_xml_flush_channel(EsconfBackendPerchannelXml *xbpx,
+                                            const gchar *channel_name,
+                                            GError **error)
+{
+    EsconfChannelWrite cw;
+    gboolean ret;
+
+    ret = esconf_backend_perchannel_xml_write_channel(xbpx, channel_name,
+                                                      &cw, error);
+    if(ret) {
+        if(xbpx->durability != ESCONF_BACKEND_DURABILITY_RELAXED
+           && !esconf_channel_write_sync(&cw))
+        {
+            ret = FALSE;
+        } else
+            ret = esconf_channel_write_commit(&cw);
+
+        if(!ret)
+            esconf_channel_write_set_error(channel_name, errno, error);
     }
-    fp = NULL;
 
-    if(rename(filename_tmp, filename))
-        goto out;
+    esconf_channel_write_finish(&cw, ret);
 
-    ret = TRUE;
+    return ret;
+}
 
-out:
-    if(!ret && error && !*error) {
-        g_set_error(error, ESCONF_ERROR,
-                    ESCONF_ERROR_WRITE_FAILURE,
-                    _("Unable to write channel \"%s\": %s"),
-                    channel_name, strerror(errno));
+/* writes all of |channel_names| out first, syncs them and only then
+ * renames them into place.  the files all live in the same directory,
+ * so where syncfs() is available a single call commits all of them;
+ * otherwise they are synced one by one and the gain is only that the
+ * renames happen after the last sync */
+static gboolean
+esconf_backend_perchannel_xml_flush_channels_grouped(EsconfBackendPerchannelXml *xbpx,
+                                                     GSList *channel_names,
+                                                     GError **error)
+{
+    GArray *writes = g_array_new(FALSE, FALSE, sizeof(EsconfChannelWrite));
+    gboolean ret = TRUE, synced = FALSE;
+    GSList *l;
+    guint i;
+
+    for(l = channel_names; l; l = l->next) {
+        EsconfChannelWrite cw;
+
+        if(esconf_backend_perchannel_xml_write_channel(xbpx, l->data, &cw, error))
+            g_array_append_val(writes, cw);
+        else {
+            esconf_channel_write_finish(&cw, FALSE);
+            ret = FALSE;
+        }
     }
 
-    if(fp)
-        fclose(fp);
+#ifdef HAVE_SYNCFS
+    /* on failure, fall back to the per-file syncs to find out which
+     * channels are affected */
+    if(writes->len > 0)
+        synced = syncfs(g_array_index(writes, EsconfChannelWrite, 0).fd) == 0;
+#endif
+
+    for(i = 0; !synced && i < writes->len; ++i) {
+        EsconfChannelWrite *cw = &g_array_index(writes, EsconfChannelWrite, i);
 
-    g_free(filename);
-    g_free(filename_tmp);
+        if(!esconf_channel_write_sync(cw)) {
+            esconf_channel_write_set_error(cw->channel_name, errno, error);
+            esconf_channel_write_finish(cw, FALSE);
+            ret = FALSE;
+        }
+    }
+
+    for(i = 0; i < writes->len; ++i) {
+        EsconfChannelWrite *cw = &g_array_index(writes, EsconfChannelWrite, i);
+        gboolean committed;
+
+        /* already given up on in the sync pass */
+        if(!cw->channel)
+            continue;
+
+        committed = esconf_channel_write_commit(cw);
+        if(!committed) {
+            esconf_channel_write_set_error(cw->channel_name, errno, error);
+            ret = FALSE;
+        }
+        esconf_channel_write_finish(cw, committed);
+    }
 
-    channel->dirty = FALSE;
+    g_array_free(writes, TRUE);
 
     return ret;
 }
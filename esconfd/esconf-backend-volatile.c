@@ -0,0 +1,577 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "esconf-backend-volatile.h"
+#include "esconf-backend.h"
+#include "common/esconf-gvaluefuncs.h"
+
+/* a backend that keeps everything in memory and never writes it out.
+ * it starts out empty, or with the contents of a snapshot file: a
+ * GVariant of type a{sa{sv}}, in text form, mapping channel names to
+ * their properties, e.g.
+ *
+ *   {'xsettings': {'/Net/ThemeName': <'Adwaita'>}}
+ *
+ * the snapshot is only read once, at startup. */
+
+struct _EsconfBackendVolatile
+{
+    GObject parent;
+
+    gchar *snapshot;
+
+    /* lowercased channel name -> (property name -> GValue) */
+    GHashTable *channels;
+
+    EsconfPropertyChangedFunc prop_changed_func;
+    gpointer prop_changed_data;
+};
+
+typedef struct _EsconfBackendVolatileClass
+{
+    GObjectClass parent;
+} EsconfBackendVolatileClass;
+
+enum
+{
+    PROP0 = 0,
+    PROP_SNAPSHOT,
+};
+
+static void esconf_backend_volatile_set_property(GObject *object,
+                                                 guint property_id,
+                                                 const GValue *value,
+                                                 GParamSpec *pspec);
+static void esconf_backend_volatile_get_property(GObject *object,
+                                                 guint property_id,
+                                                 GValue *value,
+                                                 GParamSpec *pspec);
+static void esconf_backend_volatile_finalize(GObject *obj);
+
+static void esconf_backend_volatile_backend_init(EsconfBackendInterface *iface);
+
+static gboolean esconf_backend_volatile_initialize(EsconfBackend *backend,
+                                                   GError **error);
+static gboolean esconf_backend_volatile_set(EsconfBackend *backend,
+                                            const gchar *channel_name,
+                                            const gchar *property,
+                                            const GValue *value,
+                                            GError **error);
+static gboolean esconf_backend_volatile_get(EsconfBackend *backend,
+                                            const gchar *channel_name,
+                                            const gchar *property,
+                                            GValue *value,
+                                            GError **error);
+static gboolean esconf_backend_volatile_get_all(EsconfBackend *backend,
+                                                const gchar *channel_name,
+                                                const gchar *property_base,
+                                                GHashTable *properties,
+                                                GError **error);
+static gboolean esconf_backend_volatile_exists(EsconfBackend *backend,
+                                               const gchar *channel_name,
+                                               const gchar *property,
+                                               gboolean *exists,
+                                               GError **error);
+static gboolean esconf_backend_volatile_reset(EsconfBackend *backend,
+                                              const gchar *channel_name,
+                                              const gchar *property,
+                                              gboolean recursive,
+                                              GError **error);
+static gboolean esconf_backend_volatile_list_channels(EsconfBackend *backend,
+                                                      GSList **channels,
+                                                      GError **error);
+static gboolean esconf_backend_volatile_is_property_locked(EsconfBackend *backend,
+                                                           const gchar *channel_name,
+                                                           const gchar *property,
+                                                           gboolean *locked,
+                                                           GError **error);
+static gboolean esconf_backend_volatile_get_locks(EsconfBackend *backend,
+                                                  const gchar *channel_name,
+                                                  gboolean *channel_locked,
+                                                  GSList **locked_properties,
+                                                  GError **error);
+static gboolean esconf_backend_volatile_flush(EsconfBackend *backend,
+                                              GError **error);
+static void esconf_backend_volatile_register_property_changed_func(EsconfBackend *backend,
+                                                                   EsconfPropertyChangedFunc func,
+                                                                   gpointer user_data);
+
+
+G_DEFINE_TYPE_WITH_CODE(EsconfBackendVolatile, esconf_backend_volatile, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(ESCONF_TYPE_BACKEND,
+                                              esconf_backend_volatile_backend_init))
+
+
+static void
+esconf_backend_volatile_class_init(EsconfBackendVolatileClass *klass)
+{
+    GObjectClass *object_class = (GObjectClass *)klass;
+
+    object_class->set_property = esconf_backend_volatile_set_property;
+    object_class->get_property = esconf_backend_volatile_get_property;
+    object_class->finalize = esconf_backend_volatile_finalize;
+
+    /* file the channels are seeded from */
+    g_object_class_install_property(object_class, PROP_SNAPSHOT,
+                                    g_param_spec_string("snapshot",
+                                                        "Snapshot",
+                                                        "File to read the initial channels from",
+                                                        NULL,
+                                                        G_PARAM_READWRITE
+                                                        | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+esconf_backend_volatile_init(EsconfBackendVolatile *instance)
+{
+    instance->channels = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                               (GDestroyNotify)g_free,
+                                               (GDestroyNotify)g_hash_table_destroy);
+}
+
+static void
+esconf_backend_volatile_set_property(GObject *object,
+                                     guint property_id,
+                                     const GValue *value,
+                                     GParamSpec *pspec)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(object);
+
+    switch(property_id) {
+        case PROP_SNAPSHOT:
+            g_free(xbv->snapshot);
+            xbv->snapshot = g_value_dup_string(value);
+            break;
+
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+esconf_backend_volatile_get_property(GObject *object,
+                                     guint property_id,
+                                     GValue *value,
+                                     GParamSpec *pspec)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(object);
+
+    switch(property_id) {
+        case PROP_SNAPSHOT:
+            g_value_set_string(value, xbv->snapshot);
+            break;
+
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+esconf_backend_volatile_finalize(GObject *obj)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(obj);
+
+    g_hash_table_destroy(xbv->channels);
+    g_free(xbv->snapshot);
+
+    G_OBJECT_CLASS(esconf_backend_volatile_parent_class)->finalize(obj);
+}
+
+static void
+esconf_backend_volatile_backend_init(EsconfBackendInterface *iface)
+{
+    iface->initialize = esconf_backend_volatile_initialize;
+    iface->set = esconf_backend_volatile_set;
+    iface->get = esconf_backend_volatile_get;
+    iface->get_all = esconf_backend_volatile_get_all;
+    iface->exists = esconf_backend_volatile_exists;
+    iface->reset = esconf_backend_volatile_reset;
+    iface->list_channels = esconf_backend_volatile_list_channels;
+    iface->is_property_locked = esconf_backend_volatile_is_property_locked;
+    iface->flush = esconf_backend_volatile_flush;
+    iface->register_property_changed_func = esconf_backend_volatile_register_property_changed_func;
+    iface->get_locks = esconf_backend_volatile_get_locks;
+}
+
+
+
+static GHashTable *
+esconf_backend_volatile_lookup_channel(EsconfBackendVolatile *xbv,
+                                       const gchar *channel_name,
+                                       gboolean create)
+{
+    GHashTable *channel;
+    gchar *key = g_ascii_strdown(channel_name, -1);
+
+    channel = g_hash_table_lookup(xbv->channels, key);
+    if(!channel && create) {
+        channel = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                        (GDestroyNotify)g_free,
+                                        (GDestroyNotify)_esconf_gvalue_free);
+        g_hash_table_insert(xbv->channels, key, channel);
+    } else
+        g_free(key);
+
+    return channel;
+}
+
+/* whether @property is @property_base or below it; "" and "/" are
+ * above everything */
+static inline gboolean
+esconf_property_is_below(const gchar *property,
+                         const gchar *property_base)
+{
+    gsize len;
+
+    if(!property_base[0] || (property_base[0] == '/' && !property_base[1]))
+        return TRUE;
+
+    len = strlen(property_base);
+    return !strncmp(property, property_base, len)
+           && (!property[len] || property[len] == '/');
+}
+
+static void
+esconf_backend_volatile_set_error_channel(GError **error,
+                                          const gchar *channel_name)
+{
+    if(error) {
+        g_set_error(error, ESCONF_ERROR, ESCONF_ERROR_CHANNEL_NOT_FOUND,
+                    _("Channel \"%s\" does not exist"), channel_name);
+    }
+}
+
+static void
+esconf_backend_volatile_set_error_property(GError **error,
+                                           const gchar *channel_name,
+                                           const gchar *property)
+{
+    if(error) {
+        g_set_error(error, ESCONF_ERROR, ESCONF_ERROR_PROPERTY_NOT_FOUND,
+                    _("Property \"%s\" does not exist on channel \"%s\""),
+                    property, channel_name);
+    }
+}
+
+static gboolean
+esconf_backend_volatile_load_snapshot(EsconfBackendVolatile *xbv,
+                                      GError **error)
+{
+    gchar *contents = NULL;
+    GVariant *snapshot, *properties, *variant;
+    GVariantIter iter, prop_iter;
+    const gchar *channel_name, *property;
+    GError *error1 = NULL;
+
+    if(!g_file_get_contents(xbv->snapshot, &contents, NULL, &error1))
+        goto failed;
+
+    snapshot = g_variant_parse(G_VARIANT_TYPE("a{sa{sv}}"), contents,
+                               NULL, NULL, &error1);
+    g_free(contents);
+    if(!snapshot)
+        goto failed;
+
+    g_variant_iter_init(&iter, snapshot);
+    while(g_variant_iter_next(&iter, "{&s@a{sv}}", &channel_name, &properties)) {
+        GHashTable *channel = esconf_backend_volatile_lookup_channel(xbv,
+                                                                     channel_name,
+                                                                     TRUE);
+
+        g_variant_iter_init(&prop_iter, properties);
+        while(g_variant_iter_next(&prop_iter, "{&sv}", &property, &variant)) {
+            GValue *value = esconf_gvariant_to_gvalue(variant);
+
+            if(value && G_VALUE_TYPE(value)) {
+                g_hash_table_replace(channel, g_strdup(property), value);
+            } else {
+                g_warning("Ignoring property \"%s\" on channel \"%s\" in %s: unsupported type \"%s\"",
+                          property, channel_name, xbv->snapshot,
+                          g_variant_get_type_string(variant));
+                g_free(value);
+            }
+            g_variant_unref(variant);
+        }
+        g_variant_unref(properties);
+    }
+    g_variant_unref(snapshot);
+
+    return TRUE;
+
+failed:
+    if(error) {
+        g_set_error(error, ESCONF_ERROR, ESCONF_ERROR_READ_FAILURE,
+                    _("Unable to read snapshot \"%s\": %s"),
+                    xbv->snapshot, error1->message);
+    }
+    g_error_free(error1);
+
+    return FALSE;
+}
+
+static gboolean
+esconf_backend_volatile_initialize(EsconfBackend *backend,
+                                   GError **error)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(backend);
+
+    if(xbv->snapshot)
+        return esconf_backend_volatile_load_snapshot(xbv, error);
+
+    return TRUE;
+}
+
+static gboolean
+esconf_backend_volatile_set(EsconfBackend *backend,
+                            const gchar *channel_name,
+                            const gchar *property,
+                            const GValue *value,
+                            GError **error)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(backend);
+    GHashTable *channel;
+    GValue *cur_value, *new_value;
+
+    channel = esconf_backend_volatile_lookup_channel(xbv, channel_name, TRUE);
+
+    cur_value = g_hash_table_lookup(channel, property);
+    if(cur_value && _esconf_gvalue_is_equal(cur_value, value))
+        return TRUE;
+
+    new_value = g_new0(GValue, 1);
+    g_value_init(new_value, G_VALUE_TYPE(value));
+    g_value_copy(value, new_value);
+    g_hash_table_replace(channel, g_strdup(property), new_value);
+
+    if(xbv->prop_changed_func)
+        xbv->prop_changed_func(backend, channel_name, property, xbv->prop_changed_data);
+
+    return TRUE;
+}
+
+static gboolean
+esconf_backend_volatile_get(EsconfBackend *backend,
+                            const gchar *channel_name,
+                            const gchar *property,
+                            GValue *value,
+                            GError **error)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(backend);
+    GHashTable *channel;
+    GValue *cur_value;
+
+    channel = esconf_backend_volatile_lookup_channel(xbv, channel_name, FALSE);
+    if(!channel) {
+        esconf_backend_volatile_set_error_channel(error, channel_name);
+        return FALSE;
+    }
+
+    cur_value = g_hash_table_lookup(channel, property);
+    if(!cur_value) {
+        esconf_backend_volatile_set_error_property(error, channel_name, property);
+        return FALSE;
+    }
+
+    g_value_copy(cur_value, g_value_init(value, G_VALUE_TYPE(cur_value)));
+
+    return TRUE;
+}
+
+static gboolean
+esconf_backend_volatile_get_all(EsconfBackend *backend,
+                                const gchar *channel_name,
+                                const gchar *property_base,
+                                GHashTable *properties,
+                                GError **error)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(backend);
+    GHashTable *channel;
+    GHashTableIter iter;
+    const gchar *property;
+    GValue *cur_value;
+    gboolean found = FALSE;
+
+    channel = esconf_backend_volatile_lookup_channel(xbv, channel_name, FALSE);
+    if(!channel) {
+        esconf_backend_volatile_set_error_channel(error, channel_name);
+        return FALSE;
+    }
+
+    g_hash_table_iter_init(&iter, channel);
+    while(g_hash_table_iter_next(&iter, (gpointer)&property, (gpointer)&cur_value)) {
+        if(esconf_property_is_below(property, property_base)) {
+            GValue *value = g_new0(GValue, 1);
+
+            g_value_init(value, G_VALUE_TYPE(cur_value));
+            g_value_copy(cur_value, value);
+            g_hash_table_insert(properties, g_strdup(property), value);
+            found = TRUE;
+        }
+    }
+
+    if(!found && property_base[0] && property_base[1]) {
+        esconf_backend_volatile_set_error_property(error, channel_name,
+                                                   property_base);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+esconf_backend_volatile_exists(EsconfBackend *backend,
+                               const gchar *channel_name,
+                               const gchar *property,
+                               gboolean *exists,
+                               GError **error)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(backend);
+    GHashTable *channel;
+
+    channel = esconf_backend_volatile_lookup_channel(xbv, channel_name, FALSE);
+    *exists = channel && g_hash_table_contains(channel, property);
+
+    return TRUE;
+}
+
+static gboolean
+esconf_backend_volatile_reset(EsconfBackend *backend,
+                              const gchar *channel_name,
+                              const gchar *property,
+                              gboolean recursive,
+                              GError **error)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(backend);
+    GHashTable *channel;
+    GHashTableIter iter;
+    gchar *name;
+    GSList *removed = NULL, *l;
+
+    channel = esconf_backend_volatile_lookup_channel(xbv, channel_name, FALSE);
+    if(!channel) {
+        esconf_backend_volatile_set_error_channel(error, channel_name);
+        return FALSE;
+    }
+
+    if(!recursive) {
+        if(!g_hash_table_remove(channel, property)) {
+            esconf_backend_volatile_set_error_property(error, channel_name,
+                                                       property);
+            return FALSE;
+        }
+        removed = g_slist_prepend(removed, g_strdup(property));
+    } else {
+        g_hash_table_iter_init(&iter, channel);
+        while(g_hash_table_iter_next(&iter, (gpointer)&name, NULL)) {
+            if(esconf_property_is_below(name, property)) {
+                removed = g_slist_prepend(removed, g_strdup(name));
+                g_hash_table_iter_remove(&iter);
+            }
+        }
+
+        if(!removed && property[0] && property[1]) {
+            esconf_backend_volatile_set_error_property(error, channel_name,
+                                                       property);
+            return FALSE;
+        }
+    }
+
+    /* channels only exist as long as they have properties */
+    if(!g_hash_table_size(channel)) {
+        gchar *key = g_ascii_strdown(channel_name, -1);
+        g_hash_table_remove(xbv->channels, key);
+        g_free(key);
+    }
+
+    for(l = removed; l; l = l->next) {
+        if(xbv->prop_changed_func)
+            xbv->prop_changed_func(backend, channel_name, l->data, xbv->prop_changed_data);
+    }
+    g_slist_free_full(removed, g_free);
+
+    return TRUE;
+}
+
+static gboolean
+esconf_backend_volatile_list_channels(EsconfBackend *backend,
+                                      GSList **channels,
+                                      GError **error)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(backend);
+    GHashTableIter iter;
+    const gchar *channel_name;
+
+    g_hash_table_iter_init(&iter, xbv->channels);
+    while(g_hash_table_iter_next(&iter, (gpointer)&channel_name, NULL))
+        *channels = g_slist_prepend(*channels, g_strdup(channel_name));
+
+    return TRUE;
+}
+
+static gboolean
+esconf_backend_volatile_is_property_locked(EsconfBackend *backend,
+                                           const gchar *channel_name,
+                                           const gchar *property,
+                                           gboolean *locked,
+                                           GError **error)
+{
+    /* there is no system policy to lock anything */
+    *locked = FALSE;
+    return TRUE;
+}
+
+static gboolean
+esconf_backend_volatile_get_locks(EsconfBackend *backend,
+                                  const gchar *channel_name,
+                                  gboolean *channel_locked,
+                                  GSList **locked_properties,
+                                  GError **error)
+{
+    *channel_locked = FALSE;
+    return TRUE;
+}
+
+static gboolean
+esconf_backend_volatile_flush(EsconfBackend *backend,
+                              GError **error)
+{
+    /* nowhere to flush to */
+    return TRUE;
+}
+
+static void
+esconf_backend_volatile_register_property_changed_func(EsconfBackend *backend,
+                                                       EsconfPropertyChangedFunc func,
+                                                       gpointer user_data)
+{
+    EsconfBackendVolatile *xbv = ESCONF_BACKEND_VOLATILE(backend);
+
+    xbv->prop_changed_func = func;
+    xbv->prop_changed_data = user_data;
+}
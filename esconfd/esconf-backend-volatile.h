@@ -0,0 +1,42 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __ESCONF_BACKEND_VOLATILE_H__
+#define __ESCONF_BACKEND_VOLATILE_H__
+
+#include <glib-object.h>
+
+#define ESCONF_TYPE_BACKEND_VOLATILE             (esconf_backend_volatile_get_type())
+#define ESCONF_BACKEND_VOLATILE(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj), ESCONF_TYPE_BACKEND_VOLATILE, EsconfBackendVolatile))
+#define ESCONF_IS_BACKEND_VOLATILE(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj), ESCONF_TYPE_BACKEND_VOLATILE))
+#define ESCONF_BACKEND_VOLATILE_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass), ESCONF_TYPE_BACKEND_VOLATILE, EsconfBackendVolatileClass))
+#define ESCONF_IS_BACKEND_VOLATILE_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE((klass), ESCONF_TYPE_BACKEND_VOLATILE))
+#define ESCONF_BACKEND_VOLATILE_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj), ESCONF_TYPE_BACKEND_VOLATILE, EsconfBackendVolatileClass))
+
+#define ESCONF_BACKEND_VOLATILE_TYPE_ID          "expidus-volatile"
+
+G_BEGIN_DECLS
+
+typedef struct _EsconfBackendVolatile         EsconfBackendVolatile;
+
+GType esconf_backend_volatile_get_type(void) G_GNUC_CONST;
+
+G_END_DECLS
+
+#endif  /* __ESCONF_BACKEND_VOLATILE_H__ */
@@ -22,6 +22,7 @@
 #endif
 
 #include "esconf-backend.h"
+#include "common/esconf-gvaluefuncs.h"
 
 
 static void esconf_backend_base_init(gpointer g_class);
@@ -30,6 +31,11 @@ static gboolean esconf_property_is_valid(const gchar *property,
                                          GError **error);
 static gboolean esconf_channel_is_valid(const gchar *channel,
                                         GError **error);
+static gboolean esconf_property_base_is_valid(const gchar *property_base,
+                                              GError **error);
+static gboolean esconf_reset_property_is_valid(const gchar *property,
+                                               gboolean recursive,
+                                               GError **error);
 
 /**
  * SECTION:esconf-backend
@@ -55,7 +61,18 @@ static gboolean esconf_channel_is_valid(const gchar *channel,
  * @is_property_locked: See esconf_backend_is_property_locked().
  * @flush: See esconf_backend_flush().
  * @register_property_changed_func: See esconf_backend_register_property_changed_func().
- * @_xb_reserved0: Reserved for future expansion.
+ * @get_locks: See esconf_backend_get_locks().
+ * @get_async: See esconf_backend_get_async().
+ * @get_finish: See esconf_backend_get_finish().
+ * @get_all_async: See esconf_backend_get_all_async().
+ * @get_all_finish: See esconf_backend_get_all_finish().
+ * @set_async: See esconf_backend_set_async().
+ * @set_finish: See esconf_backend_set_finish().
+ * @reset_async: See esconf_backend_reset_async().
+ * @reset_finish: See esconf_backend_reset_finish().
+ * @flush_async: See esconf_backend_flush_async().
+ * @flush_finish: See esconf_backend_flush_finish().
+ * @register_channel_reloaded_func: See esconf_backend_register_channel_reloaded_func().
  * @_xb_reserved1: Reserved for future expansion.
  * @_xb_reserved2: Reserved for future expansion.
  * @_xb_reserved3: Reserved for future expansion.
@@ -65,6 +82,11 @@ static gboolean esconf_channel_is_valid(const gchar *channel,
  *
  * See the #EsconfBackend function documentation for a description of what
  * each virtual function in #EsconfBackendInterface should do.
+ *
+ * The asynchronous virtual functions are optional, and come in pairs: a
+ * backend that implements one of them has to implement its _finish()
+ * counterpart as well.  For a backend that leaves them out, the
+ * asynchronous calls run the synchronous ones.
  **/
 
 
@@ -74,6 +96,25 @@ static gboolean esconf_channel_is_valid(const gchar *channel,
  * An instance of a class implementing a #EsconfBackendInterface.
  **/
 
+/**
+ * EsconfBackendDurability:
+ * @ESCONF_BACKEND_DURABILITY_STRICT: Every channel is synced to disk
+ *                                    before it replaces the old one.
+ * @ESCONF_BACKEND_DURABILITY_GROUPED: When several channels are flushed
+ *                                     at once, they are all written
+ *                                     first, synced together with one
+ *                                     filesystem sync where the system
+ *                                     supports it, and then put in
+ *                                     place.
+ * @ESCONF_BACKEND_DURABILITY_RELAXED: Channels are never explicitly
+ *                                     synced; a crash shortly after a
+ *                                     flush may lose the latest changes.
+ *
+ * How hard a backend that stores data on disk should try to make sure
+ * it is there after a flush.  Backends that support it have an integer
+ * "durability" property.
+ **/
+
 
 GType
 esconf_backend_get_type(void)
@@ -210,6 +251,33 @@ esconf_channel_is_valid(const gchar *channel,
     return TRUE;
 }
 
+/* "" and "/" stand for the whole channel */
+static gboolean
+esconf_property_base_is_valid(const gchar *property_base,
+                              GError **error)
+{
+    if(!*property_base || (property_base[0] == '/' && !property_base[1]))
+        return TRUE;
+
+    return esconf_property_is_valid(property_base, error);
+}
+
+static gboolean
+esconf_reset_property_is_valid(const gchar *property,
+                               gboolean recursive,
+                               GError **error)
+{
+    if(!recursive && (!*property || (property[0] == '/' && !property[1]))) {
+        if(error) {
+            g_set_error(error, ESCONF_ERROR, ESCONF_ERROR_INVALID_PROPERTY,
+                        _("The property name can only be empty or \"/\" if a recursive reset was specified"));
+        }
+        return FALSE;
+    }
+
+    return esconf_property_base_is_valid(property, error);
+}
+
 
 
 /**
@@ -338,11 +406,8 @@ esconf_backend_get_all(EsconfBackend *backend,
                                       && (!error || !*error), FALSE);
     if(!esconf_channel_is_valid(channel, error))
         return FALSE;
-    if(*property_base && !(property_base[0] == '/' && !property_base[1])
-       && !esconf_property_is_valid(property_base, error))
-    {
+    if(!esconf_property_base_is_valid(property_base, error))
         return FALSE;
-    }
 
     return iface->get_all(backend, channel, property_base, properties, error);
 }
@@ -418,19 +483,8 @@ esconf_backend_reset(EsconfBackend *backend,
                                       && (!error || !*error), FALSE);
     if(!esconf_channel_is_valid(channel, error))
         return FALSE;
-
-    if(!recursive && (!*property || (property[0] == '/' && !property[1]))) {
-        if(error) {
-            g_set_error(error, ESCONF_ERROR, ESCONF_ERROR_INVALID_PROPERTY,
-                        _("The property name can only be empty or \"/\" if a recursive reset was specified"));
-        }
-        return FALSE;
-    }
-    if(*property && !(property[0] == '/' && !property[1])
-       && !esconf_property_is_valid(property, error))
-    {
+    if(!esconf_reset_property_is_valid(property, recursive, error))
         return FALSE;
-    }
 
     return iface->reset(backend, channel, property, recursive, error);
 }
@@ -495,6 +549,45 @@ esconf_backend_is_property_locked(EsconfBackend *backend,
     return iface->is_property_locked(backend, channel, property, locked, error);
 }
 
+/**
+ * esconf_backend_get_locks:
+ * @backend: The #EsconfBackend.
+ * @channel: A channel name.
+ * @channel_locked: A boolean return.
+ * @locked_properties: A return location for a list of property names.
+ * @error: An error return.
+ *
+ * Lists everything on @channel that is locked by system policy:
+ * @channel_locked is set to whether the whole channel is locked, and
+ * the names of the locked properties, newly allocated, are added to
+ * @locked_properties.  A channel that does not exist has no locks.
+ *
+ * This lets the daemon check writes against all its backends without
+ * asking each of them about every property.
+ *
+ * Return value: The backend should return %TRUE if the operation
+ *               was successful, or %FALSE otherwise.  On %FALSE,
+ *               @error should be set to a description of the failure.
+ **/
+gboolean
+esconf_backend_get_locks(EsconfBackend *backend,
+                         const gchar *channel,
+                         gboolean *channel_locked,
+                         GSList **locked_properties,
+                         GError **error)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+
+    esconf_backend_return_val_if_fail(iface && iface->get_locks
+                                      && channel_locked && locked_properties
+                                      && (!error || !*error), FALSE);
+    if(!esconf_channel_is_valid(channel, error))
+        return FALSE;
+
+    return iface->get_locks(backend, channel, channel_locked,
+                            locked_properties, error);
+}
+
 /**
  * esconf_backend_flush
  * @backend: The #EsconfBackend.
@@ -542,3 +635,429 @@ esconf_backend_register_property_changed_func(EsconfBackend *backend,
 
     iface->register_property_changed_func(backend, func, user_data);
 }
+
+/**
+ * esconf_backend_register_channel_reloaded_func:
+ * @backend: The #EsconfBackend.
+ * @func: A function of type #EsconfChannelReloadedFunc.
+ * @user_data: Arbitrary caller-supplied data.
+ *
+ * Registers a function to be called when the backend read a channel
+ * again, for example because its files were changed by someone else.
+ * Anything besides the property values may have changed along with
+ * it, like which properties are locked, so callers should drop what
+ * they derived from the channel.  Changed property values are still
+ * reported through the #EsconfPropertyChangedFunc.
+ *
+ * Backends that never reload channels don't need to implement this.
+ **/
+void
+esconf_backend_register_channel_reloaded_func(EsconfBackend *backend,
+                                              EsconfChannelReloadedFunc func,
+                                              gpointer user_data)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+
+    g_return_if_fail(iface);
+    if(!iface->register_channel_reloaded_func)
+        return;
+
+    iface->register_channel_reloaded_func(backend, func, user_data);
+}
+
+
+
+/* for backends without asynchronous support: the synchronous call is
+ * made right away, and its result delivered from the main loop */
+static GTask *
+esconf_backend_task_new(EsconfBackend *backend,
+                        GCancellable *cancellable,
+                        GAsyncReadyCallback callback,
+                        gpointer user_data,
+                        gpointer source_tag)
+{
+    GTask *task = g_task_new(backend, cancellable, callback, user_data);
+
+    g_task_set_source_tag(task, source_tag);
+
+    return task;
+}
+
+static void
+esconf_backend_task_return(GTask *task,
+                           gboolean succeed,
+                           GError *error)
+{
+    if(succeed)
+        g_task_return_boolean(task, TRUE);
+    else if(error)
+        g_task_return_error(task, error);
+    else {
+        g_task_return_new_error(task, ESCONF_ERROR, ESCONF_ERROR_INTERNAL_ERROR,
+                                _("An internal error occurred; this is probably a bug"));
+    }
+    g_object_unref(task);
+}
+
+/**
+ * esconf_backend_get_async:
+ * @backend: The #EsconfBackend.
+ * @channel: A channel name.
+ * @property: A property name.
+ * @cancellable: A #GCancellable, or %NULL.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: Data for @callback.
+ *
+ * Starts getting the value of @property on @channel.  @callback is
+ * called when done; it should call esconf_backend_get_finish().
+ **/
+void
+esconf_backend_get_async(EsconfBackend *backend,
+                         const gchar *channel,
+                         const gchar *property,
+                         GCancellable *cancellable,
+                         GAsyncReadyCallback callback,
+                         gpointer user_data)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+    GTask *task;
+    GValue *value;
+    GError *error = NULL;
+
+    g_return_if_fail(iface && channel && property);
+
+    if(iface->get_async) {
+        if(!esconf_channel_is_valid(channel, &error)
+           || !esconf_property_is_valid(property, &error))
+        {
+            g_task_report_error(backend, callback, user_data,
+                                esconf_backend_get_async, error);
+            return;
+        }
+        iface->get_async(backend, channel, property, cancellable,
+                         callback, user_data);
+        return;
+    }
+
+    task = esconf_backend_task_new(backend, cancellable, callback, user_data,
+                                   esconf_backend_get_async);
+    value = g_new0(GValue, 1);
+    if(esconf_backend_get(backend, channel, property, value, &error)) {
+        g_task_return_pointer(task, value, (GDestroyNotify)_esconf_gvalue_free);
+        g_object_unref(task);
+    } else {
+        g_free(value);
+        esconf_backend_task_return(task, FALSE, error);
+    }
+}
+
+/**
+ * esconf_backend_get_finish:
+ * @backend: The #EsconfBackend.
+ * @result: The #GAsyncResult passed to the callback.
+ * @value: A #GValue return.
+ * @error: An error return.
+ *
+ * Finishes an operation started with esconf_backend_get_async().
+ *
+ * Return value: %TRUE if the value was stored in @value, %FALSE if
+ *               @error was set instead.
+ **/
+gboolean
+esconf_backend_get_finish(EsconfBackend *backend,
+                          GAsyncResult *result,
+                          GValue *value,
+                          GError **error)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+    GValue *result_value;
+
+    if(!g_async_result_is_tagged(result, esconf_backend_get_async))
+        return iface->get_finish(backend, result, value, error);
+
+    result_value = g_task_propagate_pointer(G_TASK(result), error);
+    if(!result_value)
+        return FALSE;
+
+    /* hand the contents over */
+    *value = *result_value;
+    g_free(result_value);
+
+    return TRUE;
+}
+
+/**
+ * esconf_backend_get_all_async:
+ * @backend: The #EsconfBackend.
+ * @channel: A channel name.
+ * @property_base: The base of properties to return.
+ * @properties: A #GHashTable.
+ * @cancellable: A #GCancellable, or %NULL.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: Data for @callback.
+ *
+ * Starts getting the properties below @property_base on @channel into
+ * @properties, like esconf_backend_get_all().  @properties has to stay
+ * around until @callback, which should call
+ * esconf_backend_get_all_finish(), is called.
+ **/
+void
+esconf_backend_get_all_async(EsconfBackend *backend,
+                             const gchar *channel,
+                             const gchar *property_base,
+                             GHashTable *properties,
+                             GCancellable *cancellable,
+                             GAsyncReadyCallback callback,
+                             gpointer user_data)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+    GTask *task;
+    GError *error = NULL;
+    gboolean succeed;
+
+    g_return_if_fail(iface && channel && property_base && properties);
+
+    if(iface->get_all_async) {
+        if(!esconf_channel_is_valid(channel, &error)
+           || !esconf_property_base_is_valid(property_base, &error))
+        {
+            g_task_report_error(backend, callback, user_data,
+                                esconf_backend_get_all_async, error);
+            return;
+        }
+        iface->get_all_async(backend, channel, property_base, properties,
+                             cancellable, callback, user_data);
+        return;
+    }
+
+    task = esconf_backend_task_new(backend, cancellable, callback, user_data,
+                                   esconf_backend_get_all_async);
+    succeed = esconf_backend_get_all(backend, channel, property_base,
+                                     properties, &error);
+    esconf_backend_task_return(task, succeed, error);
+}
+
+/**
+ * esconf_backend_get_all_finish:
+ * @backend: The #EsconfBackend.
+ * @result: The #GAsyncResult passed to the callback.
+ * @error: An error return.
+ *
+ * Finishes an operation started with esconf_backend_get_all_async().
+ *
+ * Return value: %TRUE on success, %FALSE if @error was set.
+ **/
+gboolean
+esconf_backend_get_all_finish(EsconfBackend *backend,
+                              GAsyncResult *result,
+                              GError **error)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+
+    if(!g_async_result_is_tagged(result, esconf_backend_get_all_async))
+        return iface->get_all_finish(backend, result, error);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+/**
+ * esconf_backend_set_async:
+ * @backend: The #EsconfBackend.
+ * @channel: A channel name.
+ * @property: A property name.
+ * @value: A value.
+ * @cancellable: A #GCancellable, or %NULL.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: Data for @callback.
+ *
+ * Starts setting @value for @property on @channel.  The backend makes
+ * its own copy of @value if it needs one.  @callback should call
+ * esconf_backend_set_finish().
+ **/
+void
+esconf_backend_set_async(EsconfBackend *backend,
+                         const gchar *channel,
+                         const gchar *property,
+                         const GValue *value,
+                         GCancellable *cancellable,
+                         GAsyncReadyCallback callback,
+                         gpointer user_data)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+    GTask *task;
+    GError *error = NULL;
+    gboolean succeed;
+
+    g_return_if_fail(iface && channel && property && value);
+
+    if(iface->set_async) {
+        if(!esconf_channel_is_valid(channel, &error)
+           || !esconf_property_is_valid(property, &error))
+        {
+            g_task_report_error(backend, callback, user_data,
+                                esconf_backend_set_async, error);
+            return;
+        }
+        iface->set_async(backend, channel, property, value, cancellable,
+                         callback, user_data);
+        return;
+    }
+
+    task = esconf_backend_task_new(backend, cancellable, callback, user_data,
+                                   esconf_backend_set_async);
+    succeed = esconf_backend_set(backend, channel, property, value, &error);
+    esconf_backend_task_return(task, succeed, error);
+}
+
+/**
+ * esconf_backend_set_finish:
+ * @backend: The #EsconfBackend.
+ * @result: The #GAsyncResult passed to the callback.
+ * @error: An error return.
+ *
+ * Finishes an operation started with esconf_backend_set_async().
+ *
+ * Return value: %TRUE on success, %FALSE if @error was set.
+ **/
+gboolean
+esconf_backend_set_finish(EsconfBackend *backend,
+                          GAsyncResult *result,
+                          GError **error)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+
+    if(!g_async_result_is_tagged(result, esconf_backend_set_async))
+        return iface->set_finish(backend, result, error);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+/**
+ * esconf_backend_reset_async:
+ * @backend: The #EsconfBackend.
+ * @channel: A channel name.
+ * @property: A property name.
+ * @recursive: Whether or not the reset is recursive.
+ * @cancellable: A #GCancellable, or %NULL.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: Data for @callback.
+ *
+ * Starts resetting @property on @channel, like esconf_backend_reset().
+ * @callback should call esconf_backend_reset_finish().
+ **/
+void
+esconf_backend_reset_async(EsconfBackend *backend,
+                           const gchar *channel,
+                           const gchar *property,
+                           gboolean recursive,
+                           GCancellable *cancellable,
+                           GAsyncReadyCallback callback,
+                           gpointer user_data)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+    GTask *task;
+    GError *error = NULL;
+    gboolean succeed;
+
+    g_return_if_fail(iface && channel && property);
+
+    if(iface->reset_async) {
+        if(!esconf_channel_is_valid(channel, &error)
+           || !esconf_reset_property_is_valid(property, recursive, &error))
+        {
+            g_task_report_error(backend, callback, user_data,
+                                esconf_backend_reset_async, error);
+            return;
+        }
+        iface->reset_async(backend, channel, property, recursive,
+                           cancellable, callback, user_data);
+        return;
+    }
+
+    task = esconf_backend_task_new(backend, cancellable, callback, user_data,
+                                   esconf_backend_reset_async);
+    succeed = esconf_backend_reset(backend, channel, property, recursive,
+                                   &error);
+    esconf_backend_task_return(task, succeed, error);
+}
+
+/**
+ * esconf_backend_reset_finish:
+ * @backend: The #EsconfBackend.
+ * @result: The #GAsyncResult passed to the callback.
+ * @error: An error return.
+ *
+ * Finishes an operation started with esconf_backend_reset_async().
+ *
+ * Return value: %TRUE on success, %FALSE if @error was set.
+ **/
+gboolean
+esconf_backend_reset_finish(EsconfBackend *backend,
+                            GAsyncResult *result,
+                            GError **error)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+
+    if(!g_async_result_is_tagged(result, esconf_backend_reset_async))
+        return iface->reset_finish(backend, result, error);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+/**
+ * esconf_backend_flush_async:
+ * @backend: The #EsconfBackend.
+ * @cancellable: A #GCancellable, or %NULL.
+ * @callback: A #GAsyncReadyCallback.
+ * @user_data: Data for @callback.
+ *
+ * Starts saving what the backend holds in memory, like
+ * esconf_backend_flush().  @callback should call
+ * esconf_backend_flush_finish().
+ **/
+void
+esconf_backend_flush_async(EsconfBackend *backend,
+                           GCancellable *cancellable,
+                           GAsyncReadyCallback callback,
+                           gpointer user_data)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+    GTask *task;
+    GError *error = NULL;
+    gboolean succeed;
+
+    g_return_if_fail(iface);
+
+    if(iface->flush_async) {
+        iface->flush_async(backend, cancellable, callback, user_data);
+        return;
+    }
+
+    task = esconf_backend_task_new(backend, cancellable, callback, user_data,
+                                   esconf_backend_flush_async);
+    succeed = esconf_backend_flush(backend, &error);
+    esconf_backend_task_return(task, succeed, error);
+}
+
+/**
+ * esconf_backend_flush_finish:
+ * @backend: The #EsconfBackend.
+ * @result: The #GAsyncResult passed to the callback.
+ * @error: An error return.
+ *
+ * Finishes an operation started with esconf_backend_flush_async().
+ *
+ * Return value: %TRUE on success, %FALSE if @error was set.
+ **/
+gboolean
+esconf_backend_flush_finish(EsconfBackend *backend,
+                            GAsyncResult *result,
+                            GError **error)
+{
+    EsconfBackendInterface *iface = ESCONF_BACKEND_GET_INTERFACE(backend);
+
+    if(!g_async_result_is_tagged(result, esconf_backend_flush_async))
+        return iface->flush_finish(backend, result, error);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
@@ -21,6 +21,7 @@
 #define __ESCONF_BACKEND_H__
 
 #include <glib-object.h>
+#include <gio/gio.h>
 
 #if defined(GETTEXT_PACKAGE)
 #include <glib/gi18n-lib.h>
@@ -53,11 +54,22 @@ G_BEGIN_DECLS
 typedef struct _EsconfBackend           EsconfBackend;
 typedef struct _EsconfBackendInterface  EsconfBackendInterface;
 
+typedef enum
+{
+    ESCONF_BACKEND_DURABILITY_STRICT = 0,
+    ESCONF_BACKEND_DURABILITY_GROUPED,
+    ESCONF_BACKEND_DURABILITY_RELAXED,
+} EsconfBackendDurability;
+
 typedef void (*EsconfPropertyChangedFunc)(EsconfBackend *backend,
                                           const gchar *channel,
                                           const gchar *property,
                                           gpointer user_data);
 
+typedef void (*EsconfChannelReloadedFunc)(EsconfBackend *backend,
+                                          const gchar *channel,
+                                          gpointer user_data);
+
 struct _EsconfBackendInterface
 {
     GTypeInterface parent;
@@ -111,9 +123,71 @@ struct _EsconfBackendInterface
     void (*register_property_changed_func)(EsconfBackend *backend,
                                            EsconfPropertyChangedFunc func,
                                            gpointer user_data);
+
+    gboolean (*get_locks)(EsconfBackend *backend,
+                          const gchar *channel,
+                          gboolean *channel_locked,
+                          GSList **locked_properties,
+                          GError **error);
+
+    /* asynchronous variants; all optional */
+    void (*get_async)(EsconfBackend *backend,
+                      const gchar *channel,
+                      const gchar *property,
+                      GCancellable *cancellable,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data);
+    gboolean (*get_finish)(EsconfBackend *backend,
+                           GAsyncResult *result,
+                           GValue *value,
+                           GError **error);
+
+    void (*get_all_async)(EsconfBackend *backend,
+                          const gchar *channel,
+                          const gchar *property_base,
+                          GHashTable *properties,
+                          GCancellable *cancellable,
+                          GAsyncReadyCallback callback,
+                          gpointer user_data);
+    gboolean (*get_all_finish)(EsconfBackend *backend,
+                               GAsyncResult *result,
+                               GError **error);
+
+    void (*set_async)(EsconfBackend *backend,
+                      const gchar *channel,
+                      const gchar *property,
+                      const GValue *value,
+                      GCancellable *cancellable,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data);
+    gboolean (*set_finish)(EsconfBackend *backend,
+                           GAsyncResult *result,
+                           GError **error);
+
+    void (*reset_async)(EsconfBackend *backend,
+                        const gchar *channel,
+                        const gchar *property,
+                        gboolean recursive,
+                        GCancellable *cancellable,
+                        GAsyncReadyCallback callback,
+                        gpointer user_data);
+    gboolean (*reset_finish)(EsconfBackend *backend,
+                             GAsyncResult *result,
+                             GError **error);
+
+    void (*flush_async)(EsconfBackend *backend,
+                        GCancellable *cancellable,
+                        GAsyncReadyCallback callback,
+                        gpointer user_data);
+    gboolean (*flush_finish)(EsconfBackend *backend,
+                             GAsyncResult *result,
+                             GError **error);
+
+    void (*register_channel_reloaded_func)(EsconfBackend *backend,
+                                           EsconfChannelReloadedFunc func,
+                                           gpointer user_data);
     
     /*< reserved for future expansion >*/
-    void (*_xb_reserved0)();
     void (*_xb_reserved1)();
     void (*_xb_reserved2)();
     void (*_xb_reserved3)();
@@ -164,6 +238,12 @@ gboolean esconf_backend_is_property_locked(EsconfBackend *backend,
                                            gboolean *locked,
                                            GError **error);
 
+gboolean esconf_backend_get_locks(EsconfBackend *backend,
+                                  const gchar *channel,
+                                  gboolean *channel_locked,
+                                  GSList **locked_properties,
+                                  GError **error);
+
 gboolean esconf_backend_flush(EsconfBackend *backend,
                               GError **error);
 
@@ -171,6 +251,62 @@ void esconf_backend_register_property_changed_func(EsconfBackend *backend,
                                                    EsconfPropertyChangedFunc func,
                                                    gpointer user_data);
 
+void esconf_backend_register_channel_reloaded_func(EsconfBackend *backend,
+                                                   EsconfChannelReloadedFunc func,
+                                                   gpointer user_data);
+
+void esconf_backend_get_async(EsconfBackend *backend,
+                              const gchar *channel,
+                              const gchar *property,
+                              GCancellable *cancellable,
+                              GAsyncReadyCallback callback,
+                              gpointer user_data);
+gboolean esconf_backend_get_finish(EsconfBackend *backend,
+                                   GAsyncResult *result,
+                                   GValue *value,
+                                   GError **error);
+
+void esconf_backend_get_all_async(EsconfBackend *backend,
+                                  const gchar *channel,
+                                  const gchar *property_base,
+                                  GHashTable *properties,
+                                  GCancellable *cancellable,
+                                  GAsyncReadyCallback callback,
+                                  gpointer user_data);
+gboolean esconf_backend_get_all_finish(EsconfBackend *backend,
+                                       GAsyncResult *result,
+                                       GError **error);
+
+void esconf_backend_set_async(EsconfBackend *backend,
+                              const gchar *channel,
+                              const gchar *property,
+                              const GValue *value,
+                              GCancellable *cancellable,
+                              GAsyncReadyCallback callback,
+                              gpointer user_data);
+gboolean esconf_backend_set_finish(EsconfBackend *backend,
+                                   GAsyncResult *result,
+                                   GError **error);
+
+void esconf_backend_reset_async(EsconfBackend *backend,
+                                const gchar *channel,
+                                const gchar *property,
+                                gboolean recursive,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data);
+gboolean esconf_backend_reset_finish(EsconfBackend *backend,
+                                     GAsyncResult *result,
+                                     GError **error);
+
+void esconf_backend_flush_async(EsconfBackend *backend,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data);
+gboolean esconf_backend_flush_finish(EsconfBackend *backend,
+                                     GAsyncResult *result,
+                                     GError **error);
+
 G_END_DECLS
 
 #endif  /* __ESCONF_BACKEND_H__ */
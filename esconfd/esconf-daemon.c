@@ -35,6 +35,17 @@
 #include "common/esconf-common-private.h"
 #include "common/esconf-gdbus-bindings.h"
 
+/* which channels clients asked for shortly after startup; read on the
+ * next start to preload those channels */
+#define ACCESS_PROFILE_FILE     "expidus1/esconf/access-profile"
+#define ACCESS_PROFILE_GROUP    "Warmup"
+#define ACCESS_PROFILE_PERIOD   (30)  /* seconds */
+#define ACCESS_PROFILE_MAX      (64)  /* channels */
+
+/* how many merged views are kept around, the least recently used one
+ * is dropped first */
+#define MERGED_VIEWS_MAX        (16)
+
 struct _EsconfDaemon
 {
     EsconfExportedSkeleton parent;
@@ -43,14 +54,88 @@ struct _EsconfDaemon
     GDBusConnection *conn;
 
     GList *backends;
+
+    /* the property an element-level array change is being written
+     * to; its change is announced with ArrayChanged, not with the
+     * full value */
+    const gchar *array_channel;
+    const gchar *array_property;
+
+    /* channels requested since startup, in the order they were first
+     * asked for, until the access profile is saved */
+    GPtrArray *profile_channels;
+    GHashTable *profile_seen;
+    guint profile_id;
+
+    /* channel name -> EsconfLockIndex, collected from the read-only
+     * backends when a channel is first written to */
+    GHashTable *lock_index;
+
+    /* channel name -> EsconfMergedView, with more than one backend,
+     * and their names, most recently used first */
+    GHashTable *merged_views;
+    GQueue merged_views_lru;
+    /* channel name -> EsconfMergedViewLoad, for the views being read */
+    GHashTable *merged_view_loads;
+
+    /* the array changes waiting, the first one is in progress; they go
+     * one at a time so none of them reads an array another one is
+     * about to replace */
+    GQueue array_requests;
 };
 
+/* the properties of a channel as clients see them, with each property
+ * taken from the first backend that has it */
+typedef struct
+{
+    /* property name -> GValue */
+    GHashTable *properties;
+    /* properties that changed in some backend since they were looked
+     * up, set of names */
+    GHashTable *stale;
+    /* in merged_views_lru, the data is the key in merged_views */
+    GList lru_link;
+} EsconfMergedView;
+
+typedef struct _EsconfDaemonRequest EsconfDaemonRequest;
+
+/* a merged view being read from the backends, or having its stale
+ * properties looked up again */
+typedef struct
+{
+    EsconfDaemon *esconfd;
+    gchar *key;
+    gchar *channel;
+    EsconfMergedView *view;
+    /* the backend asked now; for a refresh, the properties left to look
+     * up, starting with the one asked for now */
+    GList *backend;
+    GSList *properties;
+    gboolean succeed;
+    /* the channel was reloaded or reset meanwhile, so the view is only
+     * good for the requests already waiting */
+    gboolean invalid;
+    /* the EsconfDaemonRequests waiting, last one first */
+    GSList *waiters;
+} EsconfMergedViewLoad;
+
+/* everything the read-only backends lock on a channel */
+typedef struct
+{
+    gboolean channel_locked;
+    /* the names of the locked properties, as a set */
+    GHashTable *properties;
+} EsconfLockIndex;
+
 typedef struct _EsconfDaemonClass
 {
     EsconfExportedSkeletonClass parent;
 } EsconfDaemonClass;
 
 static void esconf_daemon_finalize(GObject *obj);
+static void esconf_daemon_stop_access_profile(EsconfDaemon *esconfd);
+static void esconf_lock_index_free(EsconfLockIndex *index);
+static void esconf_merged_view_free(EsconfMergedView *view);
 
 G_DEFINE_TYPE(EsconfDaemon, esconf_daemon, ESCONF_TYPE_EXPORTED_SKELETON)
   
@@ -66,6 +151,15 @@ static void
 esconf_daemon_init(EsconfDaemon *instance)
 {
     instance->filter_id = 0;
+    instance->lock_index = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                 (GDestroyNotify)g_free,
+                                                 (GDestroyNotify)esconf_lock_index_free);
+    instance->merged_views = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                   (GDestroyNotify)g_free,
+                                                   (GDestroyNotify)esconf_merged_view_free);
+    g_queue_init(&instance->merged_views_lru);
+    instance->merged_view_loads = g_hash_table_new(g_str_hash, g_str_equal);
+    g_queue_init(&instance->array_requests);
 }
 
 static void
@@ -73,8 +167,12 @@ esconf_daemon_finalize(GObject *obj)
 {
     EsconfDaemon *esconfd = ESCONF_DAEMON(obj);
     GList *l;
+
+    esconf_daemon_stop_access_profile(esconfd);
+
     for(l = esconfd->backends; l; l = l->next) {
         esconf_backend_register_property_changed_func(l->data, NULL, NULL);
+        esconf_backend_register_channel_reloaded_func(l->data, NULL, NULL);
         esconf_backend_flush(l->data, NULL);
         g_object_unref(l->data);
     }
@@ -84,9 +182,149 @@ esconf_daemon_finalize(GObject *obj)
         g_signal_handler_disconnect (esconfd->conn, esconfd->filter_id);
     }
 
+    g_hash_table_destroy(esconfd->lock_index);
+    g_hash_table_destroy(esconfd->merged_views);
+    g_hash_table_destroy(esconfd->merged_view_loads);
+
     G_OBJECT_CLASS(esconf_daemon_parent_class)->finalize(obj);
 }
 
+static gchar **
+esconf_daemon_load_access_profile(void)
+{
+    GKeyFile *key_file;
+    gchar *filename, **channels = NULL;
+
+    filename = expidus_resource_save_location(EXPIDUS_RESOURCE_CONFIG,
+                                           ACCESS_PROFILE_FILE, FALSE);
+    if(!filename)
+        return NULL;
+
+    key_file = g_key_file_new();
+    if(g_key_file_load_from_file(key_file, filename, G_KEY_FILE_NONE, NULL)) {
+        channels = g_key_file_get_string_list(key_file, ACCESS_PROFILE_GROUP,
+                                              "Channels", NULL, NULL);
+    }
+    g_key_file_free(key_file);
+    g_free(filename);
+
+    return channels;
+}
+
+static gboolean
+esconf_daemon_save_access_profile(gpointer data)
+{
+    EsconfDaemon *esconfd = ESCONF_DAEMON(data);
+    GKeyFile *key_file;
+    gchar *filename, *contents;
+    gsize length;
+    GError *error = NULL;
+
+    esconfd->profile_id = 0;
+
+    /* a session where nothing was asked for, like a single query from
+     * the command line, says nothing about the next login */
+    if(esconfd->profile_channels->len > 0) {
+        key_file = g_key_file_new();
+        g_key_file_set_string_list(key_file, ACCESS_PROFILE_GROUP, "Channels",
+                                   (const gchar * const *)esconfd->profile_channels->pdata,
+                                   esconfd->profile_channels->len);
+        contents = g_key_file_to_data(key_file, &length, NULL);
+        g_key_file_free(key_file);
+
+        filename = expidus_resource_save_location(EXPIDUS_RESOURCE_CONFIG,
+                                               ACCESS_PROFILE_FILE, TRUE);
+        if(!filename) {
+            g_warning("Unable to find a location for the access profile");
+        } else if(!g_file_set_contents(filename, contents, length, &error)) {
+            g_warning("Unable to save the access profile: %s", error->message);
+            g_error_free(error);
+        }
+
+        g_free(filename);
+        g_free(contents);
+    }
+
+    esconf_daemon_stop_access_profile(esconfd);
+
+    return FALSE;
+}
+
+static void
+esconf_daemon_start_access_profile(EsconfDaemon *esconfd)
+{
+    esconfd->profile_channels = g_ptr_array_new();
+    esconfd->profile_seen = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                  (GDestroyNotify)g_free, NULL);
+    esconfd->profile_id = g_timeout_add_seconds(ACCESS_PROFILE_PERIOD,
+                                                esconf_daemon_save_access_profile,
+                                                esconfd);
+}
+
+static void
+esconf_daemon_stop_access_profile(EsconfDaemon *esconfd)
+{
+    if(esconfd->profile_id) {
+        g_source_remove(esconfd->profile_id);
+        esconfd->profile_id = 0;
+    }
+    if(esconfd->profile_channels) {
+        g_ptr_array_free(esconfd->profile_channels, TRUE);
+        esconfd->profile_channels = NULL;
+        g_hash_table_destroy(esconfd->profile_seen);
+        esconfd->profile_seen = NULL;
+    }
+}
+
+static inline void
+esconf_daemon_note_access(EsconfDaemon *esconfd,
+                          const gchar *channel)
+{
+    gchar *channel_name;
+
+    if(!esconfd->profile_channels
+       || esconfd->profile_channels->len >= ACCESS_PROFILE_MAX)
+    {
+        return;
+    }
+
+    channel_name = g_ascii_strdown(channel, -1);
+    if(g_hash_table_contains(esconfd->profile_seen, channel_name)) {
+        g_free(channel_name);
+        return;
+    }
+
+    /* the strings are owned by the hash table */
+    g_hash_table_add(esconfd->profile_seen, channel_name);
+    g_ptr_array_add(esconfd->profile_channels, channel_name);
+}
+
+static void
+esconf_merged_view_free(EsconfMergedView *view)
+{
+    g_hash_table_destroy(view->properties);
+    g_hash_table_destroy(view->stale);
+    g_slice_free(EsconfMergedView, view);
+}
+
+/* drops the merged view of the lowercase channel name |key|, if any */
+static void
+esconf_daemon_drop_merged_view(EsconfDaemon *esconfd,
+                               const gchar *key)
+{
+    EsconfMergedView *view = g_hash_table_lookup(esconfd->merged_views, key);
+    EsconfMergedViewLoad *load;
+
+    if(view) {
+        g_queue_unlink(&esconfd->merged_views_lru, &view->lru_link);
+        g_hash_table_remove(esconfd->merged_views, key);
+    }
+
+    load = g_hash_table_lookup(esconfd->merged_view_loads, key);
+    if(load)
+        load->invalid = TRUE;
+}
+
 typedef struct
 {
     EsconfDaemon *esconfd;
@@ -95,14 +333,15 @@ typedef struct
     gchar *property;
 } EsconfPropChangedData;
 
-static gboolean
-esconf_daemon_emit_property_changed_idled(gpointer data)
+static void
+esconf_daemon_emit_property_changed_cb(GObject *source,
+                                       GAsyncResult *result,
+                                       gpointer data)
 {
     EsconfPropChangedData *pdata = data;
     GValue value = { 0, };
-    esconf_backend_get(pdata->backend, pdata->channel, pdata->property,
-                       &value, NULL);
-    if(G_VALUE_TYPE(&value)) {
+
+    if(esconf_backend_get_finish(ESCONF_BACKEND(source), result, &value, NULL)) {
         GVariant *val, *variant;
         val = esconf_gvalue_to_gvariant (&value);
         if (val) {
@@ -121,6 +360,16 @@ esconf_daemon_emit_property_changed_idled(gpointer data)
     g_free(pdata->property);
     g_object_unref(G_OBJECT(pdata->esconfd));
     g_slice_free(EsconfPropChangedData, pdata);
+}
+
+static gboolean
+esconf_daemon_emit_property_changed_idled(gpointer data)
+{
+    EsconfPropChangedData *pdata = data;
+
+    esconf_backend_get_async(pdata->backend, pdata->channel, pdata->property,
+                             NULL, esconf_daemon_emit_property_changed_cb,
+                             pdata);
 
     return FALSE;
 }
@@ -131,14 +380,388 @@ esconf_daemon_backend_property_changed(EsconfBackend *backend,
                                        const gchar *property,
                                        gpointer user_data)
 {
-    EsconfPropChangedData *pdata = g_slice_new0(EsconfPropChangedData);
-    pdata->esconfd = g_object_ref(ESCONF_DAEMON(user_data));
+    EsconfDaemon *esconfd = ESCONF_DAEMON(user_data);
+    EsconfPropChangedData *pdata;
+    EsconfMergedView *view;
+    EsconfMergedViewLoad *load;
+    gchar *key;
+
+    /* backends may be in the middle of changing things, so the property
+     * is only looked up again the next time it is read */
+    key = g_ascii_strdown(channel, -1);
+    view = g_hash_table_lookup(esconfd->merged_views, key);
+    if(!view) {
+        load = g_hash_table_lookup(esconfd->merged_view_loads, key);
+        if(load)
+            view = load->view;
+    }
+    if(view)
+        g_hash_table_add(view->stale, g_strdup(property));
+
+    if(esconfd->array_property
+       && !strcmp(esconfd->array_property, property)
+       && !strcmp(esconfd->array_channel, channel))
+    {
+        g_free(key);
+        return;
+    }
+
+    /* the read-only backends only change when their files do, and then
+     * their locks may have changed as well */
+    if(backend != esconfd->backends->data)
+        g_hash_table_remove(esconfd->lock_index, key);
+    g_free(key);
+
+    pdata = g_slice_new0(EsconfPropChangedData);
+    pdata->esconfd = g_object_ref(esconfd);
     pdata->backend = g_object_ref(ESCONF_BACKEND(backend));
     pdata->channel = g_strdup(channel);
     pdata->property = g_strdup(property);
     g_idle_add(esconf_daemon_emit_property_changed_idled, pdata);
 }
 
+static void
+esconf_daemon_backend_channel_reloaded(EsconfBackend *backend,
+                                       const gchar *channel,
+                                       gpointer user_data)
+{
+    EsconfDaemon *esconfd = ESCONF_DAEMON(user_data);
+    gchar *key;
+
+    /* a file edit may have locked or unlocked something without
+     * changing any value; the view is read again in one go, instead
+     * of property by property */
+    key = g_ascii_strdown(channel, -1);
+    g_hash_table_remove(esconfd->lock_index, key);
+    esconf_daemon_drop_merged_view(esconfd, key);
+    g_free(key);
+}
+
+static void
+esconf_lock_index_free(EsconfLockIndex *index)
+{
+    g_hash_table_destroy(index->properties);
+    g_slice_free(EsconfLockIndex, index);
+}
+
+static EsconfLockIndex *
+esconf_daemon_get_lock_index(EsconfDaemon *esconfd,
+                             const gchar *channel,
+                             GError **error)
+{
+    EsconfLockIndex *index;
+    GList *l;
+    gchar *key;
+
+    key = g_ascii_strdown(channel, -1);
+    index = g_hash_table_lookup(esconfd->lock_index, key);
+    if(index) {
+        g_free(key);
+        return index;
+    }
+
+    index = g_slice_new0(EsconfLockIndex);
+    index->properties = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                              (GDestroyNotify)g_free, NULL);
+
+    for(l = esconfd->backends->next; l; l = l->next) {
+        gboolean locked = FALSE;
+        GSList *locked_properties = NULL, *lp;
+
+        if(!esconf_backend_get_locks(l->data, channel, &locked,
+                                     &locked_properties, error))
+        {
+            g_slist_free_full(locked_properties, g_free);
+            esconf_lock_index_free(index);
+            g_free(key);
+            return NULL;
+        }
+
+        index->channel_locked = index->channel_locked || locked;
+        for(lp = locked_properties; lp; lp = lp->next)
+            g_hash_table_add(index->properties, lp->data);
+        g_slist_free(locked_properties);
+    }
+
+    g_hash_table_insert(esconfd->lock_index, key, index);
+
+    return index;
+}
+
+static gboolean
+esconf_daemon_check_writable(EsconfDaemon *esconfd,
+                             const gchar *channel,
+                             const gchar *property,
+                             GError **error)
+{
+    EsconfLockIndex *index;
+
+    /* if there's more than one backend, we need to make sure the
+     * property isn't locked on ANY of them; the first backend checks
+     * its own locks when writing */
+    if(G_UNLIKELY(esconfd->backends->next)) {
+        index = esconf_daemon_get_lock_index(esconfd, channel, error);
+        if(!index)
+            return FALSE;
+
+        if(index->channel_locked
+           || g_hash_table_contains(index->properties, property))
+        {
+            g_set_error(error, ESCONF_ERROR,
+                        ESCONF_ERROR_PERMISSION_DENIED,
+                        _("Permission denied while modifying property \"%s\" on channel \"%s\""),
+                        property, channel);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* a D-Bus call in progress, going through the backends one at a time */
+struct _EsconfDaemonRequest
+{
+    EsconfDaemon *esconfd;
+    GDBusMethodInvocation *invocation;
+    GList *backend;
+    gchar *channel;
+    gchar *property;
+    gboolean recursive;
+    GHashTable *properties;
+    gboolean succeed;
+    GError *error;
+
+    /* for the array changes */
+    EsconfArrayChange change;
+    guint index;
+    GValue *value;
+
+    /* called with the merged view of the channel once it is read, or
+     * with NULL if no backend has it */
+    void (*view_ready)(EsconfDaemonRequest *request,
+                       EsconfMergedView *view);
+};
+
+static EsconfDaemonRequest *
+esconf_daemon_request_new(EsconfDaemon *esconfd,
+                          GDBusMethodInvocation *invocation,
+                          const gchar *channel,
+                          const gchar *property)
+{
+    EsconfDaemonRequest *request = g_slice_new0(EsconfDaemonRequest);
+
+    request->esconfd = g_object_ref(esconfd);
+    request->invocation = invocation;
+    request->backend = esconfd->backends;
+    request->channel = g_strdup(channel);
+    request->property = g_strdup(property);
+
+    return request;
+}
+
+static void
+esconf_daemon_request_free(EsconfDaemonRequest *request)
+{
+    if(request->properties)
+        g_hash_table_destroy(request->properties);
+    if(request->error)
+        g_error_free(request->error);
+    if(request->value)
+        _esconf_gvalue_free(request->value);
+    g_free(request->channel);
+    g_free(request->property);
+    g_object_unref(request->esconfd);
+    g_slice_free(EsconfDaemonRequest, request);
+}
+
+static void
+esconf_merged_view_load_done(EsconfMergedViewLoad *load)
+{
+    EsconfDaemon *esconfd = load->esconfd;
+    EsconfMergedView *view = load->succeed ? load->view : NULL;
+    GSList *waiters, *l;
+
+    g_hash_table_remove(esconfd->merged_view_loads, load->key);
+
+    if(view && !load->invalid) {
+        if(esconfd->merged_views_lru.length >= MERGED_VIEWS_MAX) {
+            esconf_daemon_drop_merged_view(esconfd,
+                                           esconfd->merged_views_lru.tail->data);
+        }
+
+        /* the name now belongs to merged_views */
+        g_hash_table_insert(esconfd->merged_views, load->key, view);
+        view->lru_link.data = load->key;
+        g_queue_push_head_link(&esconfd->merged_views_lru, &view->lru_link);
+        load->key = NULL;
+    }
+
+    waiters = g_slist_reverse(load->waiters);
+    for(l = waiters; l; l = l->next) {
+        EsconfDaemonRequest *request = l->data;
+        request->view_ready(request, view);
+    }
+    g_slist_free(waiters);
+
+    if(!view || load->invalid)
+        esconf_merged_view_free(load->view);
+    g_free(load->key);
+    g_free(load->channel);
+    g_object_unref(esconfd);
+    g_slice_free(EsconfMergedViewLoad, load);
+}
+
+static void
+esconf_merged_view_load_cb(GObject *source,
+                           GAsyncResult *result,
+                           gpointer data)
+{
+    EsconfMergedViewLoad *load = data;
+
+    if(esconf_backend_get_all_finish(ESCONF_BACKEND(source), result, NULL))
+        load->succeed = TRUE;
+
+    if(load->backend->prev) {
+        load->backend = load->backend->prev;
+        esconf_backend_get_all_async(load->backend->data, load->channel, "/",
+                                     load->view->properties, NULL,
+                                     esconf_merged_view_load_cb, load);
+        return;
+    }
+
+    esconf_merged_view_load_done(load);
+}
+
+/* looks the stale properties up again in each backend in turn */
+static void
+esconf_merged_view_refresh_cb(GObject *source,
+                              GAsyncResult *result,
+                              gpointer data)
+{
+    EsconfMergedViewLoad *load = data;
+    gchar *property = load->properties->data;
+    GValue *value = g_new0(GValue, 1);
+
+    if(esconf_backend_get_finish(ESCONF_BACKEND(source), result, value, NULL)) {
+        /* the name now belongs to view->properties */
+        g_hash_table_replace(load->view->properties, property, value);
+    } else if(load->backend->next) {
+        g_free(value);
+        load->backend = load->backend->next;
+        esconf_backend_get_async(load->backend->data, load->channel, property,
+                                 NULL, esconf_merged_view_refresh_cb, load);
+        return;
+    } else {
+        g_hash_table_remove(load->view->properties, property);
+        g_free(value);
+        g_free(property);
+    }
+
+    load->properties = g_slist_delete_link(load->properties, load->properties);
+    if(load->properties) {
+        load->backend = load->esconfd->backends;
+        esconf_backend_get_async(load->backend->data, load->channel,
+                                 load->properties->data, NULL,
+                                 esconf_merged_view_refresh_cb, load);
+        return;
+    }
+
+    esconf_merged_view_load_done(load);
+}
+
+/* calls request->view_ready with the merged view of the request's
+ * channel, reading it from the backends first if needed */
+static void
+esconf_daemon_request_merged_view(EsconfDaemonRequest *request)
+{
+    EsconfDaemon *esconfd = request->esconfd;
+    EsconfMergedViewLoad *load;
+    EsconfMergedView *view = NULL;
+    gchar *key, *view_key;
+
+    key = g_ascii_strdown(request->channel, -1);
+
+    load = g_hash_table_lookup(esconfd->merged_view_loads, key);
+    if(load) {
+        g_free(key);
+        load->waiters = g_slist_prepend(load->waiters, request);
+        return;
+    }
+
+    if(g_hash_table_lookup_extended(esconfd->merged_views, key,
+                                    (gpointer)&view_key, (gpointer)&view))
+    {
+        g_queue_unlink(&esconfd->merged_views_lru, &view->lru_link);
+        if(!g_hash_table_size(view->stale)) {
+            g_free(key);
+            g_queue_push_head_link(&esconfd->merged_views_lru, &view->lru_link);
+            request->view_ready(request, view);
+            return;
+        }
+
+        /* the view is out of merged_views until it is up to date */
+        g_hash_table_steal(esconfd->merged_views, key);
+        g_free(key);
+        key = view_key;
+    }
+
+    load = g_slice_new0(EsconfMergedViewLoad);
+    load->esconfd = g_object_ref(esconfd);
+    load->key = key;
+    load->channel = g_strdup(request->channel);
+    load->waiters = g_slist_prepend(NULL, request);
+    g_hash_table_insert(esconfd->merged_view_loads, key, load);
+
+    if(view) {
+        GHashTableIter iter;
+        gchar *property;
+
+        load->view = view;
+        load->succeed = TRUE;
+
+        /* whatever changes from now on is stale again */
+        g_hash_table_iter_init(&iter, view->stale);
+        while(g_hash_table_iter_next(&iter, (gpointer)&property, NULL)) {
+            load->properties = g_slist_prepend(load->properties, property);
+            g_hash_table_iter_steal(&iter);
+        }
+
+        load->backend = esconfd->backends;
+        esconf_backend_get_async(load->backend->data, load->channel,
+                                 load->properties->data, NULL,
+                                 esconf_merged_view_refresh_cb, load);
+    } else {
+        load->view = g_slice_new0(EsconfMergedView);
+        load->view->properties = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                       (GDestroyNotify)g_free,
+                                                       (GDestroyNotify)_esconf_gvalue_free);
+        load->view->stale = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                  (GDestroyNotify)g_free, NULL);
+
+        /* the backends that come first win, so they go last */
+        load->backend = g_list_last(esconfd->backends);
+        esconf_backend_get_all_async(load->backend->data, load->channel, "/",
+                                     load->view->properties, NULL,
+                                     esconf_merged_view_load_cb, load);
+    }
+}
+
+static void
+esconf_daemon_set_property_cb(GObject *source,
+                              GAsyncResult *result,
+                              gpointer data)
+{
+    EsconfDaemonRequest *request = data;
+
+    if(esconf_backend_set_finish(ESCONF_BACKEND(source), result, &request->error))
+        esconf_exported_complete_set_property((EsconfExported *)request->esconfd,
+                                              request->invocation);
+    else
+        g_dbus_method_invocation_return_gerror(request->invocation, request->error);
+
+    esconf_daemon_request_free(request);
+}
+
 static gboolean
 esconf_set_property(EsconfExported *skeleton,
                     GDBusMethodInvocation *invocation,
@@ -147,127 +770,476 @@ esconf_set_property(EsconfExported *skeleton,
                     GVariant *variant,
                     EsconfDaemon *esconfd)
 {
-    GList *l;
     GError *error = NULL;
     GValue *value;
 
-    /* if there's more than one backend, we need to make sure the
-     * property isn't locked on ANY of them */
-    if(G_UNLIKELY(esconfd->backends->next)) {
-        for(l = esconfd->backends; l; l = l->next) {
-            gboolean locked = FALSE;
-
-            if(!esconf_backend_is_property_locked(l->data, channel, property,
-                                                  &locked, &error))
-                break;
-
-            if(locked) {
-                g_set_error(&error, ESCONF_ERROR,
-                            ESCONF_ERROR_PERMISSION_DENIED,
-                            _("Permission denied while modifying property \"%s\" on channel \"%s\""),
-                            property, channel);
-                break;
-            }
+    esconf_daemon_note_access(esconfd, channel);
+
+    if(!esconf_daemon_check_writable(esconfd, channel, property, &error)) {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
+        return FALSE;
+    }
+
+
+    value = esconf_gvariant_to_gvalue (variant);
+    /* only write to first backend */
+    esconf_backend_set_async(esconfd->backends->data, channel, property,
+                             value, NULL, esconf_daemon_set_property_cb,
+                             esconf_daemon_request_new(esconfd, invocation,
+                                                       channel, property));
+
+    g_value_unset (value);
+    g_free (value);
+    return TRUE;
+}
+
+static void esconf_daemon_array_change_next(EsconfDaemon *esconfd);
+
+static void
+esconf_daemon_array_change_done(EsconfDaemonRequest *request)
+{
+    EsconfDaemon *esconfd = g_object_ref(request->esconfd);
+    EsconfExported *skeleton = (EsconfExported *)esconfd;
+
+    if(request->error)
+        g_dbus_method_invocation_return_gerror(request->invocation, request->error);
+    else if(request->change == ESCONF_ARRAY_CHANGE_SET)
+        esconf_exported_complete_array_set_index(skeleton, request->invocation);
+    else if(request->change == ESCONF_ARRAY_CHANGE_INSERT)
+        esconf_exported_complete_array_insert(skeleton, request->invocation);
+    else
+        esconf_exported_complete_array_remove(skeleton, request->invocation);
+
+    g_queue_pop_head(&esconfd->array_requests);
+    esconf_daemon_request_free(request);
+
+    esconf_daemon_array_change_next(esconfd);
+    g_object_unref(esconfd);
+}
+
+static void
+esconf_daemon_array_set_cb(GObject *source,
+                           GAsyncResult *result,
+                           gpointer data)
+{
+    EsconfDaemonRequest *request = data;
+    EsconfDaemon *esconfd = request->esconfd;
+
+    esconfd->array_channel = esconfd->array_property = NULL;
+
+    if(esconf_backend_set_finish(ESCONF_BACKEND(source), result, &request->error)) {
+        GVariant *val;
+
+        val = request->value ? esconf_gvalue_to_gvariant(request->value)
+                             : g_variant_ref_sink(g_variant_new_boolean(FALSE));
+        esconf_exported_emit_array_changed((EsconfExported *)esconfd,
+                                           request->channel, request->property,
+                                           request->change, request->index,
+                                           g_variant_new_variant(val));
+        g_variant_unref(val);
+    }
+
+    esconf_daemon_array_change_done(request);
+}
+
+static void
+esconf_daemon_array_get_cb(GObject *source,
+                           GAsyncResult *result,
+                           gpointer data)
+{
+    EsconfDaemonRequest *request = data;
+    EsconfDaemon *esconfd = request->esconfd;
+    GValue cur_value = { 0, }, new_value = { 0, };
+    GPtrArray *arr;
+
+    if(!esconf_backend_get_finish(ESCONF_BACKEND(source), result, &cur_value,
+                                  &request->error))
+    {
+        /* inserting the first element creates the array */
+        if(request->change != ESCONF_ARRAY_CHANGE_INSERT
+           || !g_error_matches(request->error, ESCONF_ERROR,
+                               ESCONF_ERROR_PROPERTY_NOT_FOUND))
+        {
+            esconf_daemon_array_change_done(request);
+            return;
         }
+        g_clear_error(&request->error);
+    } else if(G_VALUE_TYPE(&cur_value) != G_TYPE_PTR_ARRAY) {
+        g_set_error(&request->error, ESCONF_ERROR, ESCONF_ERROR_INVALID_PROPERTY,
+                    _("Property \"%s\" on channel \"%s\" is not an array"),
+                    request->property, request->channel);
+        g_value_unset(&cur_value);
+        esconf_daemon_array_change_done(request);
+        return;
+    }
 
-        /* there is always an error set if something failed or the
-         * property is locked */
-        if(error) {
-            g_dbus_method_invocation_return_gerror(invocation, error);
-            g_error_free(error);
+    arr = esconf_value_array_apply_change(G_IS_VALUE(&cur_value)
+                                          ? g_value_get_boxed(&cur_value) : NULL,
+                                          request->change, request->index,
+                                          request->value);
+    if(!arr) {
+        g_set_error(&request->error, ESCONF_ERROR, ESCONF_ERROR_INVALID_PROPERTY,
+                    _("Index %u is out of range for property \"%s\" on channel \"%s\""),
+                    request->index, request->property, request->channel);
+        if(G_IS_VALUE(&cur_value))
+            g_value_unset(&cur_value);
+        esconf_daemon_array_change_done(request);
+        return;
+    }
+
+    g_value_init(&new_value, G_TYPE_PTR_ARRAY);
+    g_value_take_boxed(&new_value, arr);
+
+    /* the change is announced as one ArrayChanged in the end, not as
+     * a PropertyChanged for the whole array */
+    esconfd->array_channel = request->channel;
+    esconfd->array_property = request->property;
+    esconf_backend_set_async(esconfd->backends->data, request->channel,
+                             request->property, &new_value, NULL,
+                             esconf_daemon_array_set_cb, request);
+
+    g_value_unset(&new_value);
+    if(G_IS_VALUE(&cur_value))
+        g_value_unset(&cur_value);
+}
+
+static void
+esconf_daemon_array_change_next(EsconfDaemon *esconfd)
+{
+    EsconfDaemonRequest *request = g_queue_peek_head(&esconfd->array_requests);
+
+    if(!request)
+        return;
+
+    /* the array is taken from the backend we write to, like the
+     * values set with SetProperty */
+    esconf_backend_get_async(esconfd->backends->data, request->channel,
+                             request->property, NULL,
+                             esconf_daemon_array_get_cb, request);
+}
+
+/* queues an array change, which completes @invocation when done */
+static gboolean
+esconf_daemon_array_change(EsconfDaemon *esconfd,
+                           GDBusMethodInvocation *invocation,
+                           const gchar *channel,
+                           const gchar *property,
+                           EsconfArrayChange change,
+                           guint index,
+                           GVariant *variant,
+                           GError **error)
+{
+    EsconfDaemonRequest *request;
+    GValue *value = NULL;
+
+    esconf_daemon_note_access(esconfd, channel);
+
+    if(!esconf_daemon_check_writable(esconfd, channel, property, error))
+        return FALSE;
+
+    if(variant) {
+        value = esconf_gvariant_to_gvalue(variant);
+        if(!value
+           || G_VALUE_TYPE(value) == G_TYPE_PTR_ARRAY
+           || G_VALUE_TYPE(value) == G_TYPE_STRV)
+        {
+            g_set_error(error, ESCONF_ERROR, ESCONF_ERROR_INTERNAL_ERROR,
+                        _("Array elements of property \"%s\" on channel \"%s\" must be simple values"),
+                        property, channel);
+            if(value)
+                _esconf_gvalue_free(value);
             return FALSE;
         }
     }
-    
-    value = esconf_gvariant_to_gvalue (variant);
-    /* only write to first backend */
-    if(esconf_backend_set(esconfd->backends->data, channel, property,
-                          value, &error))
+
+    request = esconf_daemon_request_new(esconfd, invocation, channel, property);
+    request->change = change;
+    request->index = index;
+    request->value = value;
+
+    g_queue_push_tail(&esconfd->array_requests, request);
+    if(esconfd->array_requests.length == 1)
+        esconf_daemon_array_change_next(esconfd);
+
+    return TRUE;
+}
+
+static gboolean
+esconf_array_set_index(EsconfExported *skeleton,
+                       GDBusMethodInvocation *invocation,
+                       const gchar *channel,
+                       const gchar *property,
+                       guint index,
+                       GVariant *variant,
+                       EsconfDaemon *esconfd)
+{
+    GError *error = NULL;
+
+    if(!esconf_daemon_array_change(esconfd, invocation, channel, property,
+                                   ESCONF_ARRAY_CHANGE_SET, index, variant,
+                                   &error))
     {
-        esconf_exported_complete_set_property(skeleton, invocation);
-    } else {
         g_dbus_method_invocation_return_gerror(invocation, error);
         g_error_free(error);
     }
 
-    g_value_unset (value);
-    g_free (value);
     return TRUE;
 }
 
+static gboolean
+esconf_array_insert(EsconfExported *skeleton,
+                    GDBusMethodInvocation *invocation,
+                    const gchar *channel,
+                    const gchar *property,
+                    guint index,
+                    GVariant *variant,
+                    EsconfDaemon *esconfd)
+{
+    GError *error = NULL;
+
+    if(!esconf_daemon_array_change(esconfd, invocation, channel, property,
+                                   ESCONF_ARRAY_CHANGE_INSERT, index, variant,
+                                   &error))
+    {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
+    }
+
+    return TRUE;
+}
 
 static gboolean
-esconf_get_property(EsconfExported *skeleton,
+esconf_array_remove(EsconfExported *skeleton,
                     GDBusMethodInvocation *invocation,
                     const gchar *channel,
                     const gchar *property,
+                    guint index,
                     EsconfDaemon *esconfd)
 {
-    GList *l;
-    GValue value = { 0, };
     GError *error = NULL;
 
-    /* check each backend until we find a value */
-    for(l = esconfd->backends; l; l = l->next) {
-        if(esconf_backend_get(l->data, channel, property, &value, &error)) {
-            GVariant *variant, *val;
-            val = esconf_gvalue_to_gvariant (&value);
-            if (val){
-                variant = g_variant_new_variant (val);
-                esconf_exported_complete_get_property(skeleton, invocation, variant);
-                g_variant_unref (val);
-            }
-            else {
-                g_set_error (&error, ESCONF_ERROR, 
-                             ESCONF_ERROR_INTERNAL_ERROR, _("GType transformation failed \"%s\""),
-                             G_VALUE_TYPE_NAME(&value));
-                g_dbus_method_invocation_return_gerror(invocation, error);
-                g_error_free(error);
-            }
-            g_value_unset(&value);
-            return TRUE;
-        } else if(l->next)
-            g_clear_error(&error);
+    if(!esconf_daemon_array_change(esconfd, invocation, channel, property,
+                                   ESCONF_ARRAY_CHANGE_REMOVE, index, NULL,
+                                   &error))
+    {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
     }
-    g_dbus_method_invocation_return_gerror(invocation, error);
-    g_error_free(error);
+
     return TRUE;
 }
 
+static void
+esconf_daemon_complete_get_property(EsconfExported *skeleton,
+                                    GDBusMethodInvocation *invocation,
+                                    const GValue *value)
+{
+    GVariant *variant, *val;
+    GError *error = NULL;
+
+    val = esconf_gvalue_to_gvariant (value);
+    if (val){
+        variant = g_variant_new_variant (val);
+        esconf_exported_complete_get_property(skeleton, invocation, variant);
+        g_variant_unref (val);
+    }
+    else {
+        g_set_error (&error, ESCONF_ERROR, 
+                     ESCONF_ERROR_INTERNAL_ERROR, _("GType transformation failed \"%s\""),
+                     G_VALUE_TYPE_NAME(value));
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
+    }
+}
+
+static void
+esconf_daemon_get_property_cb(GObject *source,
+                              GAsyncResult *result,
+                              gpointer data)
+{
+    EsconfDaemonRequest *request = data;
+    GValue value = { 0, };
+
+    g_clear_error(&request->error);
+    if(esconf_backend_get_finish(ESCONF_BACKEND(source), result, &value,
+                                 &request->error))
+    {
+        esconf_daemon_complete_get_property((EsconfExported *)request->esconfd,
+                                            request->invocation, &value);
+        g_value_unset(&value);
+    } else if(request->backend->next) {
+        /* check each backend until we find a value */
+        request->backend = request->backend->next;
+        esconf_backend_get_async(request->backend->data, request->channel,
+                                 request->property, NULL,
+                                 esconf_daemon_get_property_cb, request);
+        return;
+    } else
+        g_dbus_method_invocation_return_gerror(request->invocation, request->error);
+
+    esconf_daemon_request_free(request);
+}
+
+static void
+esconf_daemon_get_property_view_ready(EsconfDaemonRequest *request,
+                                      EsconfMergedView *view)
+{
+    const GValue *merged_value = NULL;
+
+    if(view)
+        merged_value = g_hash_table_lookup(view->properties, request->property);
+    if(merged_value) {
+        esconf_daemon_complete_get_property((EsconfExported *)request->esconfd,
+                                            request->invocation, merged_value);
+        esconf_daemon_request_free(request);
+        return;
+    }
+
+    /* not there; let the backends come up with the right error */
+    esconf_backend_get_async(request->backend->data, request->channel,
+                             request->property, NULL,
+                             esconf_daemon_get_property_cb, request);
+}
+
 static gboolean
-esconf_get_all_properties(EsconfExported *skeleton,
-                          GDBusMethodInvocation *invocation,
-                          const gchar *channel,
-                          const gchar *property_base,
-                          EsconfDaemon *esconfd)
+esconf_get_property(EsconfExported *skeleton,
+                    GDBusMethodInvocation *invocation,
+                    const gchar *channel,
+                    const gchar *property,
+                    EsconfDaemon *esconfd)
 {
-    GList *l;
-    GHashTable *properties;
+    EsconfDaemonRequest *request;
+
+    esconf_daemon_note_access(esconfd, channel);
+
+    request = esconf_daemon_request_new(esconfd, invocation, channel, property);
+
+    if(G_UNLIKELY(esconfd->backends->next)) {
+        request->view_ready = esconf_daemon_get_property_view_ready;
+        esconf_daemon_request_merged_view(request);
+        return TRUE;
+    }
+
+    esconf_backend_get_async(esconfd->backends->data, channel, property, NULL,
+                             esconf_daemon_get_property_cb, request);
+    return TRUE;
+}
+
+static void
+esconf_daemon_get_all_properties_cb(GObject *source,
+                                    GAsyncResult *result,
+                                    gpointer data)
+{
+    EsconfDaemonRequest *request = data;
     GError *error = NULL;
-    gboolean succeed = FALSE;
-    properties = g_hash_table_new_full(g_str_hash, g_str_equal,
-                                        (GDestroyNotify)g_free,
-                                        (GDestroyNotify)_esconf_gvalue_free);
+
     /* get all properties from all backends.  if they all fail, return FALSE */
-    for(l = esconfd->backends; l; l = l->next) {
-        if(esconf_backend_get_all(l->data, channel, property_base,
-                                  properties, &error))
-            succeed = TRUE;
-        else if(l->next) {
-            g_clear_error(&error);
-        }
+    if(esconf_backend_get_all_finish(ESCONF_BACKEND(source), result, &error))
+        request->succeed = TRUE;
+    else {
+        g_clear_error(&request->error);
+        request->error = error;
+    }
+
+    if(request->backend->next) {
+        request->backend = request->backend->next;
+        esconf_backend_get_all_async(request->backend->data, request->channel,
+                                     request->property, request->properties,
+                                     NULL, esconf_daemon_get_all_properties_cb,
+                                     request);
+        return;
     }
-    if(succeed) {
+
+    if(request->succeed) {
         GVariant *variant;
-        variant = esconf_hash_to_gvariant (properties);
-        esconf_exported_complete_get_all_properties (skeleton, invocation, variant);
+        variant = esconf_hash_to_gvariant (request->properties);
+        esconf_exported_complete_get_all_properties ((EsconfExported *)request->esconfd,
+                                                     request->invocation, variant);
     }
     else
-        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_dbus_method_invocation_return_gerror(request->invocation, request->error);
 
-    if(error)
-        g_error_free(error);
+    esconf_daemon_request_free(request);
+}
+
+static void
+esconf_daemon_get_all_properties_start(EsconfDaemonRequest *request)
+{
+    request->properties = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                (GDestroyNotify)g_free,
+                                                (GDestroyNotify)_esconf_gvalue_free);
+    esconf_backend_get_all_async(request->backend->data, request->channel,
+                                 request->property, request->properties, NULL,
+                                 esconf_daemon_get_all_properties_cb, request);
+}
+
+static void
+esconf_daemon_get_all_properties_view_ready(EsconfDaemonRequest *request,
+                                            EsconfMergedView *view)
+{
+    GHashTable *properties;
+    GHashTableIter iter;
+    const gchar *name;
+    GValue *value;
+    gsize base_len;
+
+    if(!view) {
+        /* nothing there; let the backends come up with the answer */
+        esconf_daemon_get_all_properties_start(request);
+        return;
+    }
+
+    base_len = strlen(request->property);
+    if(base_len == 1)
+        base_len = 0;  /* "/" */
+
+    /* the values stay in the view */
+    properties = g_hash_table_new(g_str_hash, g_str_equal);
+    g_hash_table_iter_init(&iter, view->properties);
+    while(g_hash_table_iter_next(&iter, (gpointer)&name, (gpointer)&value)) {
+        if(!base_len
+           || (!strncmp(name, request->property, base_len)
+               && (!name[base_len] || name[base_len] == '/')))
+        {
+            g_hash_table_insert(properties, (gpointer)name, value);
+        }
+    }
+
+    if(g_hash_table_size(properties)) {
+        GVariant *variant = esconf_hash_to_gvariant(properties);
+        esconf_exported_complete_get_all_properties((EsconfExported *)request->esconfd,
+                                                    request->invocation, variant);
+        g_hash_table_destroy(properties);
+        esconf_daemon_request_free(request);
+        return;
+    }
     g_hash_table_destroy(properties);
+
+    esconf_daemon_get_all_properties_start(request);
+}
+
+static gboolean
+esconf_get_all_properties(EsconfExported *skeleton,
+                          GDBusMethodInvocation *invocation,
+                          const gchar *channel,
+                          const gchar *property_base,
+                          EsconfDaemon *esconfd)
+{
+    EsconfDaemonRequest *request;
+
+    esconf_daemon_note_access(esconfd, channel);
+
+    request = esconf_daemon_request_new(esconfd, invocation, channel,
+                                        property_base);
+
+    if(G_UNLIKELY(esconfd->backends->next)) {
+        request->view_ready = esconf_daemon_get_all_properties_view_ready;
+        esconf_daemon_request_merged_view(request);
+        return TRUE;
+    }
+
+    esconf_daemon_get_all_properties_start(request);
     return TRUE;
 }
 
@@ -282,6 +1254,9 @@ esconf_property_exists(EsconfExported *skeleton,
     gboolean succeed = FALSE;
     GList *l;
     GError *error = NULL;
+
+    esconf_daemon_note_access(esconfd, channel);
+
     /* if at least one backend returns TRUE (regardles if |*exists| gets set
      * to TRUE or FALSE), we'll return TRUE from this function */
     for(l = esconfd->backends; !exists && l; l = l->next) {
@@ -300,6 +1275,39 @@ esconf_property_exists(EsconfExported *skeleton,
     return TRUE;
 }
 
+static void
+esconf_daemon_reset_property_cb(GObject *source,
+                                GAsyncResult *result,
+                                gpointer data)
+{
+    EsconfDaemonRequest *request = data;
+    GError *error = NULL;
+
+    if(esconf_backend_reset_finish(ESCONF_BACKEND(source), result, &error))
+        request->succeed = TRUE;
+    else {
+        g_clear_error(&request->error);
+        request->error = error;
+    }
+
+    if(request->backend->next) {
+        request->backend = request->backend->next;
+        esconf_backend_reset_async(request->backend->data, request->channel,
+                                   request->property, request->recursive,
+                                   NULL, esconf_daemon_reset_property_cb,
+                                   request);
+        return;
+    }
+
+    if(request->succeed)
+        esconf_exported_complete_reset_property((EsconfExported *)request->esconfd,
+                                                request->invocation);
+    else
+        g_dbus_method_invocation_return_gerror(request->invocation, request->error);
+
+    esconf_daemon_request_free(request);
+}
+
 static gboolean
 esconf_reset_property(EsconfExported *skeleton,
                       GDBusMethodInvocation *invocation,
@@ -308,27 +1316,27 @@ esconf_reset_property(EsconfExported *skeleton,
                       gboolean recursive,
                       EsconfDaemon *esconfd)
 {
-    gboolean succeed = FALSE;
-    GList *l;
-    GError *error = NULL;
-    /* while technically all backends but the first should be opened read-only,
-     * we need to reset in all backends so the property doesn't reappear
-     * later */
+    EsconfDaemonRequest *request;
+    gchar *key;
 
-    for(l = esconfd->backends; l; l = l->next) {
-        if(esconf_backend_reset(l->data, channel, property, recursive, &error))
-            succeed = TRUE;
-        else if(l->next)
-            g_clear_error(&error);
-    }
+    esconf_daemon_note_access(esconfd, channel);
 
-    if(succeed)
-        esconf_exported_complete_reset_property(skeleton, invocation);
-    else
-        g_dbus_method_invocation_return_gerror(invocation, error);
+    /* most of a recursively reset channel is gone, no need to look
+     * every property up again */
+    if(recursive) {
+        key = g_ascii_strdown(channel, -1);
+        esconf_daemon_drop_merged_view(esconfd, key);
+        g_free(key);
+    }
 
-    if(error)
-        g_error_free(error);
+    /* while technically all backends but the first should be opened read-only,
+     * we need to reset in all backends so the property doesn't reappear
+     * later */
+    request = esconf_daemon_request_new(esconfd, invocation, channel, property);
+    request->recursive = recursive;
+    esconf_backend_reset_async(esconfd->backends->data, channel, property,
+                               recursive, NULL,
+                               esconf_daemon_reset_property_cb, request);
 
     return TRUE;
 }
@@ -383,6 +1391,9 @@ static gboolean esconf_is_property_locked(EsconfExported *skeleton,
     gboolean locked = FALSE;
     GError *error = NULL;
     gboolean succeed = FALSE;
+
+    esconf_daemon_note_access(esconfd, channel);
+
     for(l = esconfd->backends; !locked && l; l = l->next) {
         if(esconf_backend_is_property_locked(l->data, channel, property,
                                              &locked, &error))
@@ -459,8 +1470,16 @@ esconf_daemon_load_config(EsconfDaemon *esconfd,
                           gchar * const *backend_ids,
                           GError **error)
 {
+    gchar **profile_channels;
     gint i;
 
+    /* warm up whatever was needed right after the last start */
+    profile_channels = esconf_daemon_load_access_profile();
+    if(profile_channels) {
+        esconf_backend_factory_add_preload_channels(profile_channels);
+        g_strfreev(profile_channels);
+    }
+
     for(i = 0; backend_ids[i]; ++i) {
         GError *error1 = NULL;
         EsconfBackend *backend = esconf_backend_factory_get_backend(backend_ids[i],
@@ -474,6 +1493,9 @@ esconf_daemon_load_config(EsconfDaemon *esconfd,
             esconf_backend_register_property_changed_func(backend,
                                                           esconf_daemon_backend_property_changed,
                                                           esconfd);
+            esconf_backend_register_channel_reloaded_func(backend,
+                                                          esconf_daemon_backend_channel_reloaded,
+                                                          esconfd);
         }
     }
 
@@ -508,6 +1530,8 @@ esconf_daemon_new_unique(gchar * const *backend_ids,
         return NULL;
     }
 
+    esconf_daemon_start_access_profile(esconfd);
+
     g_signal_connect (esconfd, "handle-get-all-properties",
                       G_CALLBACK(esconf_get_all_properties), esconfd);
     
@@ -528,6 +1552,15 @@ esconf_daemon_new_unique(gchar * const *backend_ids,
     
     g_signal_connect (esconfd, "handle-set-property",
                       G_CALLBACK(esconf_set_property), esconfd);
+
+    g_signal_connect (esconfd, "handle-array-set-index",
+                      G_CALLBACK(esconf_array_set_index), esconfd);
+
+    g_signal_connect (esconfd, "handle-array-insert",
+                      G_CALLBACK(esconf_array_insert), esconfd);
+
+    g_signal_connect (esconfd, "handle-array-remove",
+                      G_CALLBACK(esconf_array_remove), esconfd);
     
     return esconfd;
 }
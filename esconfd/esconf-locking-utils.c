@@ -25,109 +25,224 @@
 #include <sys/types.h>
 #endif
 
-#ifdef HAVE_SYS_STAT_H
-#include <sys/stat.h>
-#endif
-
 #ifdef HAVE_GRP_H
 #include <grp.h>
 #endif
 
+#ifdef HAVE_PWD_H
+#include <pwd.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
 
 #include "esconf-locking-utils.h"
 
-/* group cache stuff */
+/* a "locked" or "unlocked" attribute, compiled: whether the current
+ * user is named in it, and a bitset of the groups it names, indexed
+ * like group_indices */
+struct _EsconfLockPolicy
+{
+    gboolean names_user;
+    guint n_words;
+    guint32 groups[];
+};
+
+/* the lock attributes are parsed on the preload threads as well */
+G_LOCK_DEFINE_STATIC(lock_policies);
 
-static time_t etc_group_mtime = 0;
-static GHashTable *group_cache = NULL;
+/* list string -> EsconfLockPolicy, never freed */
+static GHashTable *lock_policies = NULL;
+/* group name -> index + 1 */
+static GHashTable *group_indices = NULL;
+/* bitset of the interned groups the current user is in */
+static GArray *user_groups = NULL;
+/* the groups of the current user, looked up once */
+static gid_t *user_gids = NULL;
+static gint n_user_gids = 0;
 
 static void
-esconf_ensure_group_cache(void)
+esconf_ensure_user_gids(void)
 {
-    gboolean needs_rebuild = FALSE;
-    struct stat st;
-    struct group *gr;
-    GHashTable *members;
-        
-    if(!stat("/etc/group", &st)) {
-        if(st.st_mtime > etc_group_mtime) {
-            etc_group_mtime = st.st_mtime;
-            needs_rebuild = TRUE;
-        }
-    } else
-        needs_rebuild = TRUE;        
-    
-    if(!needs_rebuild && group_cache)
+    const gchar *user_name = g_get_user_name();
+    gid_t gid = getgid();
+#ifdef HAVE_PWD_H
+    struct passwd *pw;
+#endif
+
+    if(user_gids)
         return;
-    
-    if(group_cache)
-        g_hash_table_destroy(group_cache);
-    
-    group_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
-                                        (GDestroyNotify)g_free,
-                                        (GDestroyNotify)g_hash_table_destroy);
-    
-    for(setgrent(), gr = getgrent(); gr; gr = getgrent()) {
-        gint i;
-        
-        members = g_hash_table_new_full(g_str_hash, g_str_equal,
-                                        (GDestroyNotify)g_free, NULL);
-        
-        for(i = 0; gr->gr_mem[i]; ++i) {
-            g_hash_table_replace(members, g_strdup(gr->gr_mem[i]),
-                                 GINT_TO_POINTER(1));
+
+#ifdef HAVE_PWD_H
+    pw = getpwnam(user_name);
+    if(pw)
+        gid = pw->pw_gid;
+#endif
+
+#ifdef HAVE_GETGROUPLIST
+    n_user_gids = 32;
+    user_gids = g_new(gid_t, n_user_gids);
+    for(;;) {
+        gint n = n_user_gids;
+
+        if(getgrouplist(user_name, gid, user_gids, &n) >= 0) {
+            n_user_gids = n;
+            break;
         }
-        
-        g_hash_table_replace(group_cache, g_strdup(gr->gr_name), members);
+
+        /* some systems report the size needed, others don't */
+        n_user_gids = MAX(n, n_user_gids * 2);
+        user_gids = g_renew(gid_t, user_gids, n_user_gids);
     }
+#else
+    {
+        GArray *gids = g_array_new(FALSE, FALSE, sizeof(gid_t));
+        struct group *gr;
+
+        g_array_append_val(gids, gid);
+        for(setgrent(), gr = getgrent(); gr; gr = getgrent()) {
+            gint i;
+
+            for(i = 0; gr->gr_mem[i]; ++i) {
+                if(!strcmp(gr->gr_mem[i], user_name)) {
+                    g_array_append_val(gids, gr->gr_gid);
+                    break;
+                }
+            }
+        }
+        endgrent();
+
+        n_user_gids = gids->len;
+        user_gids = (gid_t *)g_array_free(gids, FALSE);
+    }
+#endif
 }
 
-static gboolean
-esconf_user_is_in_group(const gchar *user,
-                        const gchar *group)
+static guint
+esconf_intern_group(const gchar *group)
 {
-    GHashTable *members;
-    
-    esconf_ensure_group_cache();
-    
-    members = g_hash_table_lookup(group_cache, group);
-    
-    if(G_UNLIKELY(!members))
-        return FALSE;
-    
-    return g_hash_table_lookup(members, user) ? TRUE : FALSE;
+    guint index;
+    struct group *gr;
+    gint i;
+
+    index = GPOINTER_TO_UINT(g_hash_table_lookup(group_indices, group));
+    if(index)
+        return index - 1;
+
+    index = g_hash_table_size(group_indices);
+    g_hash_table_insert(group_indices, g_strdup(group), GUINT_TO_POINTER(index + 1));
+
+    if(user_groups->len <= index / 32)
+        g_array_set_size(user_groups, index / 32 + 1);
+
+    /* only groups that are named in a lock policy are ever resolved */
+    gr = getgrnam(group);
+    if(gr) {
+        for(i = 0; i < n_user_gids; ++i) {
+            if(user_gids[i] == gr->gr_gid) {
+                g_array_index(user_groups, guint32, index / 32) |= 1u << (index % 32);
+                break;
+            }
+        }
+    }
+
+    return index;
 }
 
-gboolean
-esconf_user_is_in_list(const gchar *list)
+static EsconfLockPolicy *
+esconf_lock_policy_compile(const gchar *list)
 {
-    gboolean ret = FALSE;
+    EsconfLockPolicy *policy;
     const gchar *user_name = g_get_user_name();
     gchar **tokens;
+    GArray *groups;
     gint i;
-    
+
+    groups = g_array_new(FALSE, TRUE, sizeof(guint32));
+
     tokens = g_strsplit(list, ";", -1);
-    
     for(i = 0; tokens[i]; ++i) {
-        if(!*tokens[i])
-            continue;
-        else if(*tokens[i] == '@') {
-            if(esconf_user_is_in_group(user_name, tokens[i]+1)) {
-                ret = TRUE;
-                break;
-            }
-        } else {
-            if(!strcmp(user_name, tokens[i])) {
+        if(*tokens[i] == '@') {
+            guint index = esconf_intern_group(tokens[i] + 1);
+
+            if(groups->len <= index / 32)
+                g_array_set_size(groups, index / 32 + 1);
+            g_array_index(groups, guint32, index / 32) |= 1u << (index % 32);
+        }
+    }
+
+    policy = g_malloc0(sizeof(EsconfLockPolicy) + groups->len * sizeof(guint32));
+    for(i = 0; tokens[i]; ++i) {
+        if(*tokens[i] && *tokens[i] != '@' && !strcmp(user_name, tokens[i])) {
+            policy->names_user = TRUE;
+            break;
+        }
+    }
+    policy->n_words = groups->len;
+    if(groups->len)
+        memcpy(policy->groups, groups->data, groups->len * sizeof(guint32));
+
+    g_strfreev(tokens);
+    g_array_free(groups, TRUE);
+
+    return policy;
+}
+
+/* returns the compiled form of the value of a "locked" or "unlocked"
+ * attribute, a ';'-separated list of user names and of group names
+ * prefixed with '@'.  a list is compiled the first time it is seen, and
+ * kept around afterwards. */
+const EsconfLockPolicy *
+esconf_lock_policy_lookup(const gchar *list)
+{
+    EsconfLockPolicy *policy;
+
+    G_LOCK(lock_policies);
+
+    if(G_UNLIKELY(!lock_policies)) {
+        lock_policies = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                              (GDestroyNotify)g_free,
+                                              (GDestroyNotify)g_free);
+        group_indices = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                              (GDestroyNotify)g_free, NULL);
+        user_groups = g_array_new(FALSE, TRUE, sizeof(guint32));
+        esconf_ensure_user_gids();
+    }
+
+    policy = g_hash_table_lookup(lock_policies, list);
+    if(!policy) {
+        policy = esconf_lock_policy_compile(list);
+        g_hash_table_insert(lock_policies, g_strdup(list), policy);
+    }
+
+    G_UNLOCK(lock_policies);
+
+    return policy;
+}
+
+/* whether a policy names the current user, either directly or through
+ * one of the user's groups */
+gboolean
+esconf_lock_policy_applies(const EsconfLockPolicy *policy)
+{
+    gboolean ret = policy->names_user;
+    guint i;
+
+    if(!ret && policy->n_words) {
+        G_LOCK(lock_policies);
+        for(i = 0; i < policy->n_words && i < user_groups->len; ++i) {
+            if(policy->groups[i] & g_array_index(user_groups, guint32, i)) {
                 ret = TRUE;
                 break;
             }
         }
+        G_UNLOCK(lock_policies);
     }
-    
-    g_strfreev(tokens);
-    
+
     return ret;
 }
@@ -26,7 +26,10 @@ G_BEGIN_DECLS
 
 #define  ESCONF_DBUS_TYPE_G_DOUBLE_ARRAY  (dbus_g_type_get_collection("GArray", G_TYPE_DOUBLE))
 
-G_GNUC_INTERNAL gboolean esconf_user_is_in_list(const gchar *list);
+typedef struct _EsconfLockPolicy EsconfLockPolicy;
+
+G_GNUC_INTERNAL const EsconfLockPolicy *esconf_lock_policy_lookup(const gchar *list);
+G_GNUC_INTERNAL gboolean esconf_lock_policy_applies(const EsconfLockPolicy *policy);
 
 G_END_DECLS
 
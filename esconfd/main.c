@@ -144,6 +144,9 @@ main(int argc,
     
     GOptionContext *opt_ctx;
     gchar **backends = NULL;
+    gchar *durability = NULL;
+    gchar **preload = NULL;
+    gchar *snapshot = NULL;
     gboolean print_version = FALSE;
     gboolean do_daemon = FALSE;
     GOptionEntry options[] = {
@@ -152,6 +155,22 @@ main(int argc,
         { "backends", 'b', G_OPTION_FLAG_IN_MAIN, G_OPTION_ARG_STRING_ARRAY, &backends,
             N_("Configuration backends to use.  The first backend specified " \
                "is opened read/write; the others, read-only."), NULL },
+        { "durability", 0, G_OPTION_FLAG_IN_MAIN, G_OPTION_ARG_STRING, &durability,
+            N_("How hard to try to get changes onto the disk when saving: " \
+               "\"strict\" syncs every channel on its own (the default), " \
+               "\"grouped\" syncs channels saved at the same time together, " \
+               "\"relaxed\" leaves it to the operating system."),
+            N_("MODE") },
+        { "preload", 0, G_OPTION_FLAG_IN_MAIN, G_OPTION_ARG_STRING_ARRAY, &preload,
+            N_("Channel to load in the background at startup, so the first " \
+               "request for it doesn't wait for the disk.  May be given " \
+               "more than once."),
+            N_("CHANNEL") },
+        { "snapshot", 0, G_OPTION_FLAG_IN_MAIN, G_OPTION_ARG_FILENAME, &snapshot,
+            N_("File the \"expidus-volatile\" backend takes its initial " \
+               "settings from.  That backend keeps everything in memory, " \
+               "and never writes to disk."),
+            N_("FILE") },
         { "daemon", 0, G_OPTION_FLAG_IN_MAIN, G_OPTION_ARG_NONE, &do_daemon,
             N_("Fork into background after starting; only useful for " \
                 "testing purposes"), NULL },
@@ -194,6 +213,31 @@ main(int argc,
         g_print("Esconfd " VERSION "\n");
         return EXIT_SUCCESS;
     }
+
+    if(durability) {
+        if(!strcmp(durability, "strict"))
+            esconf_backend_factory_set_durability(ESCONF_BACKEND_DURABILITY_STRICT);
+        else if(!strcmp(durability, "grouped"))
+            esconf_backend_factory_set_durability(ESCONF_BACKEND_DURABILITY_GROUPED);
+        else if(!strcmp(durability, "relaxed"))
+            esconf_backend_factory_set_durability(ESCONF_BACKEND_DURABILITY_RELAXED);
+        else {
+            g_printerr(_("Unknown durability mode \"%s\"\n"), durability);
+            g_free(durability);
+            return EXIT_FAILURE;
+        }
+        g_free(durability);
+    }
+
+    if(preload) {
+        esconf_backend_factory_add_preload_channels(preload);
+        g_strfreev(preload);
+    }
+
+    if(snapshot) {
+        esconf_backend_factory_set_snapshot(snapshot);
+        g_free(snapshot);
+    }
     
     mloop = g_main_loop_new(NULL, FALSE);
     
@@ -0,0 +1,126 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "tests-common.h"
+
+static const gchar *int_array_property = "/test/typedarray/ints";
+static const gchar *double_array_property = "/test/typedarray/doubles";
+static const gint test_ints[] = { 1, -2, 300000 };
+static const gdouble test_doubles[] = { 0.5, -1.25 };
+
+static GPtrArray *
+make_array(GType gtype,
+           guint n_values,
+           gconstpointer values)
+{
+    GPtrArray *arr = g_ptr_array_new();
+    guint i;
+
+    for(i = 0; i < n_values; ++i) {
+        GValue *val = g_new0(GValue, 1);
+
+        g_value_init(val, gtype);
+        if(gtype == G_TYPE_INT)
+            g_value_set_int(val, ((const gint *)values)[i]);
+        else
+            g_value_set_double(val, ((const gdouble *)values)[i]);
+        g_ptr_array_add(arr, val);
+    }
+
+    return arr;
+}
+
+static gboolean
+check_array(GPtrArray *arr,
+            GType gtype,
+            guint n_values,
+            gconstpointer values)
+{
+    guint i;
+
+    if(!arr || arr->len != n_values)
+        return FALSE;
+
+    for(i = 0; i < n_values; ++i) {
+        GValue *val = g_ptr_array_index(arr, i);
+
+        if(G_VALUE_TYPE(val) != gtype)
+            return FALSE;
+        if(gtype == G_TYPE_INT && g_value_get_int(val) != ((const gint *)values)[i])
+            return FALSE;
+        if(gtype == G_TYPE_DOUBLE && g_value_get_double(val) != ((const gdouble *)values)[i])
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    EsconfChannel *channel;
+    GPtrArray *arr;
+    GHashTable *properties;
+    GValue *val;
+
+    if(!esconf_tests_start())
+        return 1;
+
+    channel = esconf_channel_new(TEST_CHANNEL_NAME);
+
+    arr = make_array(G_TYPE_INT, G_N_ELEMENTS(test_ints), test_ints);
+    TEST_OPERATION(esconf_channel_set_arrayv(channel, int_array_property, arr));
+    esconf_array_free(arr);
+
+    arr = make_array(G_TYPE_DOUBLE, G_N_ELEMENTS(test_doubles), test_doubles);
+    TEST_OPERATION(esconf_channel_set_arrayv(channel, double_array_property, arr));
+    esconf_array_free(arr);
+
+    /* read back from the daemon, not from our own cache */
+    g_object_unref(G_OBJECT(channel));
+    channel = esconf_channel_new(TEST_CHANNEL_NAME);
+
+    arr = esconf_channel_get_arrayv(channel, int_array_property);
+    TEST_OPERATION(check_array(arr, G_TYPE_INT, G_N_ELEMENTS(test_ints), test_ints));
+    if(arr)
+        esconf_array_free(arr);
+
+    arr = esconf_channel_get_arrayv(channel, double_array_property);
+    TEST_OPERATION(check_array(arr, G_TYPE_DOUBLE, G_N_ELEMENTS(test_doubles), test_doubles));
+    if(arr)
+        esconf_array_free(arr);
+
+    /* and through GetAllProperties */
+    properties = esconf_channel_get_properties(channel, "/test/typedarray");
+    TEST_OPERATION(properties != NULL);
+    val = g_hash_table_lookup(properties, int_array_property);
+    TEST_OPERATION(val && G_VALUE_TYPE(val) == G_TYPE_PTR_ARRAY
+                   && check_array(g_value_get_boxed(val), G_TYPE_INT,
+                                  G_N_ELEMENTS(test_ints), test_ints));
+    g_hash_table_destroy(properties);
+
+    esconf_channel_reset_property(channel, "/test/typedarray", TRUE);
+
+    g_object_unref(G_OBJECT(channel));
+
+    esconf_tests_end();
+
+    return 0;
+}
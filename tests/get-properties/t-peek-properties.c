@@ -0,0 +1,62 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "tests-common.h"
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+int
+main(int argc,
+     char **argv)
+{
+    EsconfChannel *channel;
+    const gchar *str;
+    const gchar * const *strlist;
+    const GPtrArray *arr;
+    gint i;
+
+    if(!esconf_tests_start())
+        return 1;
+
+    channel = esconf_channel_new(TEST_CHANNEL_NAME);
+
+    str = esconf_channel_peek_string(channel, test_string_property, NULL);
+    TEST_OPERATION(str != NULL && !strcmp(str, test_string));
+    /* a second peek must return the very same cached string */
+    TEST_OPERATION(esconf_channel_peek_string(channel, test_string_property, NULL) == str);
+    TEST_OPERATION(esconf_channel_peek_string(channel, "/does/not/exist", "fallback") != NULL);
+
+    strlist = esconf_channel_peek_string_list(channel, test_strlist_property);
+    TEST_OPERATION(strlist != NULL);
+    for(i = 0; strlist[i] && test_strlist[i]; ++i)
+        TEST_OPERATION(!strcmp(strlist[i], test_strlist[i]));
+    TEST_OPERATION(strlist[i] == NULL && test_strlist[i] == NULL);
+    TEST_OPERATION(esconf_channel_peek_string_list(channel, test_strlist_property) == strlist);
+
+    arr = esconf_channel_peek_arrayv(channel, test_strlist_property);
+    TEST_OPERATION(arr != NULL && arr->len == g_strv_length((gchar **)test_strlist));
+
+    g_object_unref(G_OBJECT(channel));
+
+    esconf_tests_end();
+
+    return 0;
+}
@@ -113,6 +113,27 @@ test_object_set_property(GObject *object,
     }
 }
 
+/* removes the binding |user_data| points to, once */
+static void
+unbind_other_notify(GObject *object,
+                    GParamSpec *pspec,
+                    gpointer user_data)
+{
+    gulong *id = user_data;
+
+    if(*id) {
+        esconf_g_property_unbind(*id);
+        *id = 0;
+    }
+}
+
+static gboolean
+quit_loop(gpointer data)
+{
+    g_main_loop_quit(data);
+    return FALSE;
+}
+
 
 int
 main(int argc,
@@ -199,6 +220,143 @@ main(int argc,
         g_object_unref(G_OBJECT(object));
     }
 
+    {
+        GObject *objects[3];
+        EsconfGPropertyBindEntry entries[3];
+        gulong ids[3];
+        guint i, n_bound;
+
+        TEST_OPERATION(esconf_channel_set_bool(channel, "/bindings/many/a", TRUE));
+        TEST_OPERATION(esconf_channel_set_bool(channel, "/bindings/many/b", TRUE));
+
+        for(i = 0; i < G_N_ELEMENTS(entries); ++i) {
+            objects[i] = g_object_new(test_object_get_type(), NULL);
+            entries[i].esconf_property_type = G_TYPE_BOOLEAN;
+            entries[i].object = objects[i];
+            entries[i].object_property = "test";
+        }
+        entries[0].esconf_property = "/bindings/many/a";
+        entries[1].esconf_property = "/bindings/many/b";
+        entries[2].esconf_property = "/bindings/many/a";
+
+        /* initial values come from the channel */
+        n_bound = esconf_g_property_bind_many(channel, entries,
+                                              G_N_ELEMENTS(entries), ids);
+        TEST_OPERATION(n_bound == G_N_ELEMENTS(entries));
+        TEST_OPERATION(ids[0] != 0 && ids[1] != 0 && ids[2] != 0);
+        TEST_OPERATION(((TestObject *)objects[0])->test
+                       && ((TestObject *)objects[1])->test
+                       && ((TestObject *)objects[2])->test);
+
+        /* a change reaches every object bound to the property, and
+         * only those */
+        esconf_channel_set_bool(channel, "/bindings/many/a", FALSE);
+        TEST_OPERATION(!((TestObject *)objects[0])->test
+                       && ((TestObject *)objects[1])->test
+                       && !((TestObject *)objects[2])->test);
+
+        /* object to channel */
+        g_object_set(objects[1], "test", FALSE, NULL);
+        TEST_OPERATION(!esconf_channel_get_bool(channel, "/bindings/many/b", TRUE));
+
+        /* a write from one object reaches the other object bound to
+         * the same property */
+        g_object_set(objects[0], "test", TRUE, NULL);
+        TEST_OPERATION(esconf_channel_get_bool(channel, "/bindings/many/a", FALSE));
+        TEST_OPERATION(((TestObject *)objects[2])->test);
+
+        /* unbind one of the two bindings on the same property */
+        esconf_g_property_unbind(ids[0]);
+        esconf_channel_set_bool(channel, "/bindings/many/a", FALSE);
+        TEST_OPERATION(((TestObject *)objects[0])->test
+                       && !((TestObject *)objects[2])->test);
+
+        /* unbind all on channel drops the shared handler */
+        esconf_g_property_unbind_all(channel);
+        was_set = FALSE;
+        esconf_channel_set_bool(channel, "/bindings/many/a", FALSE);
+        esconf_channel_set_bool(channel, "/bindings/many/b", TRUE);
+        property_was_changed = was_set;
+        TEST_OPERATION(!property_was_changed);
+
+        for(i = 0; i < G_N_ELEMENTS(objects); ++i)
+            g_object_unref(objects[i]);
+    }
+
+    {
+        GObject *objects[2];
+        EsconfGPropertyBindEntry entries[2];
+        gulong ids[2], other_ids[2];
+        guint i;
+
+        TEST_OPERATION(esconf_channel_set_bool(channel, "/bindings/unbind", FALSE));
+
+        for(i = 0; i < G_N_ELEMENTS(entries); ++i) {
+            objects[i] = g_object_new(test_object_get_type(), NULL);
+            entries[i].esconf_property = "/bindings/unbind";
+            entries[i].esconf_property_type = G_TYPE_BOOLEAN;
+            entries[i].object = objects[i];
+            entries[i].object_property = "test";
+        }
+        TEST_OPERATION(esconf_g_property_bind_many(channel, entries,
+                                                   G_N_ELEMENTS(entries), ids) == 2);
+
+        /* whichever object is notified first unbinds the other one */
+        other_ids[0] = ids[1];
+        other_ids[1] = ids[0];
+        for(i = 0; i < G_N_ELEMENTS(objects); ++i) {
+            g_signal_connect(objects[i], "notify::test",
+                             G_CALLBACK(unbind_other_notify), &other_ids[i]);
+        }
+
+        esconf_channel_set_bool(channel, "/bindings/unbind", TRUE);
+
+        /* exactly one of them got the change */
+        TEST_OPERATION((other_ids[0] == 0) != (other_ids[1] == 0));
+        TEST_OPERATION(((TestObject *)objects[0])->test
+                       != ((TestObject *)objects[1])->test);
+
+        for(i = 0; i < G_N_ELEMENTS(objects); ++i)
+            g_object_unref(objects[i]);
+    }
+
+    {
+        GMainLoop *loop;
+
+        TEST_OPERATION(esconf_channel_set_bool(channel, "/bindings/throttle", FALSE));
+
+        object = g_object_new(test_object_get_type(), NULL);
+        id = esconf_g_property_bind(channel, "/bindings/throttle",
+                                    G_TYPE_BOOLEAN, object, "test");
+        esconf_g_property_set_throttle(id, 100);
+
+        /* the first change is written right away */
+        g_object_set(object, "test", TRUE, NULL);
+        TEST_OPERATION(esconf_channel_get_bool(channel, "/bindings/throttle", FALSE));
+
+        /* the following ones are held back... */
+        g_object_set(object, "test", FALSE, NULL);
+        g_object_set(object, "test", TRUE, NULL);
+        g_object_set(object, "test", FALSE, NULL);
+        TEST_OPERATION(esconf_channel_get_bool(channel, "/bindings/throttle", FALSE));
+
+        /* ...until the interval expires */
+        loop = g_main_loop_new(NULL, FALSE);
+        g_timeout_add(300, quit_loop, loop);
+        g_main_loop_run(loop);
+        g_main_loop_unref(loop);
+        TEST_OPERATION(!esconf_channel_get_bool(channel, "/bindings/throttle", TRUE));
+
+        /* the final value is written when unbinding */
+        g_object_set(object, "test", TRUE, NULL);
+        g_object_set(object, "test", FALSE, NULL);
+        g_object_set(object, "test", TRUE, NULL);
+        esconf_g_property_unbind(id);
+        TEST_OPERATION(esconf_channel_get_bool(channel, "/bindings/throttle", FALSE));
+
+        g_object_unref(object);
+    }
+
     g_object_unref(G_OBJECT(channel));
 
     esconf_tests_end();
@@ -0,0 +1,183 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* not a test: writes a large channel file, has esconfd load it, and
+ * reports how much the resident memory of esconfd grew per property.
+ * the properties only come from the file, so what is measured is the
+ * backend's in-memory tree and not D-Bus traffic.  build it with
+ * "make b-channel-memory" in the trees to compare and run it through
+ * the test driver in each:
+ *
+ *   ../tests-driver.sh ../../esconfd ./b-channel-memory
+ *   ../tests-driver.sh ../../esconfd t-tests-end
+ *
+ * the second line stops the daemon the driver started. */
+
+#include "tests-common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#define N_WORKSPACES  500
+#define N_MONITORS    20
+
+static glong
+esconfd_get_rss_kb(GDBusConnection *conn)
+{
+    GVariant *ret;
+    guint32 pid;
+    gchar *path, *contents = NULL, *p;
+    glong rss = -1;
+
+    ret = g_dbus_connection_call_sync(conn, "org.freedesktop.DBus",
+                                      "/org/freedesktop/DBus",
+                                      "org.freedesktop.DBus",
+                                      "GetConnectionUnixProcessID",
+                                      g_variant_new("(s)", "com.expidus.EsconfTest"),
+                                      G_VARIANT_TYPE("(u)"),
+                                      G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    if(!ret)
+        return -1;
+    g_variant_get(ret, "(u)", &pid);
+    g_variant_unref(ret);
+
+    path = g_strdup_printf("/proc/%u/status", pid);
+    if(g_file_get_contents(path, &contents, NULL, NULL)) {
+        p = strstr(contents, "VmRSS:");
+        if(p)
+            rss = strtol(p + 6, NULL, 10);
+    }
+    g_free(contents);
+    g_free(path);
+
+    return rss;
+}
+
+/* the same shape the backdrop settings have, four properties for every
+ * monitor of every workspace */
+static gchar *
+write_channel(const gchar *channel_name,
+              gint *n_props)
+{
+    gchar *dirname, *basename, *filename;
+    GString *out;
+    gboolean written;
+    gint i, j;
+
+    dirname = g_build_filename(g_get_user_config_dir(),
+                               "expidus1", "esconf", "expidus-perchannel-xml",
+                               NULL);
+    g_mkdir_with_parents(dirname, 0700);
+    basename = g_strconcat(channel_name, ".xml", NULL);
+    filename = g_build_filename(dirname, basename, NULL);
+    g_free(basename);
+    g_free(dirname);
+
+    out = g_string_new("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    g_string_append_printf(out,
+                           "<channel name=\"%s\" version=\"1.0\">\n"
+                           "  <property name=\"backdrop\" type=\"empty\">\n",
+                           channel_name);
+    *n_props = 0;
+    for(i = 0; i < N_WORKSPACES; ++i) {
+        g_string_append_printf(out, "    <property name=\"workspace%d\" type=\"empty\">\n", i);
+        for(j = 0; j < N_MONITORS; ++j) {
+            g_string_append_printf(out,
+                                   "      <property name=\"monitor%d\" type=\"empty\">\n"
+                                   "        <property name=\"image-path\" type=\"string\" value=\"/usr/share/backgrounds/default.png\"/>\n"
+                                   "        <property name=\"image-style\" type=\"int\" value=\"5\"/>\n"
+                                   "        <property name=\"last-image-valid\" type=\"bool\" value=\"true\"/>\n"
+                                   "        <property name=\"brightness\" type=\"double\" value=\"0.5\"/>\n"
+                                   "      </property>\n",
+                                   j);
+            *n_props += 4;
+        }
+        g_string_append(out, "    </property>\n");
+    }
+    g_string_append(out, "  </property>\n</channel>\n");
+
+    written = g_file_set_contents(filename, out->str, out->len, NULL);
+    g_string_free(out, TRUE);
+
+    if(!written) {
+        g_free(filename);
+        return NULL;
+    }
+
+    return filename;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    EsconfChannel *channel;
+    GDBusConnection *conn;
+    glong rss_before, rss_after;
+    gchar *channel_name, *filename;
+    gint n_props;
+    gboolean ret;
+
+    if(!esconf_tests_start())
+        return 2;
+
+    /* a new channel every run, the driver may reuse the daemon */
+    channel_name = g_strdup_printf("benchmark-channel-memory-%d", (gint)getpid());
+    filename = write_channel(channel_name, &n_props);
+    if(!filename) {
+        g_free(channel_name);
+        esconf_tests_end();
+        return 1;
+    }
+
+    conn = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+    channel = esconf_channel_new(channel_name);
+
+    rss_before = esconfd_get_rss_kb(conn);
+
+    /* the first call on a channel makes the daemon read its file; the
+     * reply is a single boolean, so nothing else is left behind */
+    ret = esconf_channel_has_property(channel, "/backdrop/workspace0/monitor0/brightness");
+
+    rss_after = esconfd_get_rss_kb(conn);
+
+    if(!ret)
+        g_critical("The channel was not loaded from \"%s\"", filename);
+    else if(rss_before >= 0 && rss_after >= 0) {
+        printf("%d properties: esconfd RSS %ld kB -> %ld kB, %.1f bytes/property\n",
+               n_props, rss_before, rss_after,
+               (rss_after - rss_before) * 1024.0 / n_props);
+    } else
+        printf("unable to read the RSS of esconfd\n");
+
+    g_unlink(filename);
+    g_free(filename);
+    g_free(channel_name);
+
+    g_object_unref(G_OBJECT(channel));
+    g_object_unref(G_OBJECT(conn));
+
+    esconf_tests_end();
+
+    return ret ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* checks that doubles and floats written by the perchannel-xml backend
+ * read back unchanged, and prints how long formatting and parsing take
+ * compared to the old "%f" + g_ascii_strtod() code. */
+
+#include "tests-common.h"
+#include "common/esconf-gvaluefuncs.h"
+
+#define N_RANDOM     100000
+#define N_BENCHMARK  200000
+
+static gdouble
+random_double(GRand *rand)
+{
+    union { guint64 bits; gdouble d; } u;
+
+    do {
+        u.bits = ((guint64)g_rand_int(rand) << 32) | g_rand_int(rand);
+    } while(u.d != u.d || u.d - u.d != 0.0);  /* no NaN or infinity */
+
+    return u.d;
+}
+
+static gboolean
+check_double(gdouble val)
+{
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+    gchar *endptr = NULL;
+    gdouble parsed;
+
+    _esconf_format_double(buf, val);
+    parsed = _esconf_ascii_strtod(buf, &endptr);
+
+    if(parsed != val || *endptr != 0 || parsed != g_ascii_strtod(buf, NULL)) {
+        g_critical("Test failed: %.17g was written as \"%s\" and read back as %.17g",
+                   val, buf, parsed);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+check_float(gfloat val)
+{
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+    gfloat parsed;
+
+    _esconf_format_float(buf, val);
+    parsed = (gfloat)_esconf_ascii_strtod(buf, NULL);
+
+    if(parsed != val) {
+        g_critical("Test failed: float %.9g was written as \"%s\" and read back as %.9g",
+                   (gdouble)val, buf, (gdouble)parsed);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+check_format(gdouble val,
+             const gchar *expected)
+{
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    if(g_strcmp0(_esconf_format_double(buf, val), expected)) {
+        g_critical("Test failed: %.17g should be written as \"%s\", not \"%s\"",
+                   val, expected, buf);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+benchmark(GRand *rand)
+{
+    gdouble *values = g_new(gdouble, N_BENCHMARK);
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+    gdouble sum = 0.0;
+    gint64 start, old_time, new_time;
+    guint i;
+
+    /* the kind of values settings actually hold */
+    for(i = 0; i < N_BENCHMARK; ++i)
+        values[i] = g_rand_int_range(rand, -100000, 100000) / 1000.0;
+
+    start = g_get_monotonic_time();
+    for(i = 0; i < N_BENCHMARK; ++i) {
+        g_snprintf(buf, sizeof(buf), "%f", values[i]);
+        sum += g_ascii_strtod(buf, NULL);
+    }
+    old_time = g_get_monotonic_time() - start;
+
+    start = g_get_monotonic_time();
+    for(i = 0; i < N_BENCHMARK; ++i) {
+        _esconf_format_double(buf, values[i]);
+        sum += _esconf_ascii_strtod(buf, NULL);
+    }
+    new_time = g_get_monotonic_time() - start;
+
+    g_print("%d doubles written and read back: \"%%f\" + g_ascii_strtod() %.1f ms, "
+            "shortest round-trip %.1f ms (%g)\n",
+            N_BENCHMARK, old_time / 1000.0, new_time / 1000.0, sum);
+
+    g_free(values);
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    static const gdouble values[] = {
+        0.0, -0.0, 1.0, -1.0, 0.1, 0.2, 0.3, 1e-9, 1.0 / 3.0, 2.0 / 3.0,
+        42.4242, 123456.789, 1e15, 1e16, 1e22, 1e23, 9007199254740993.0,
+        G_MINDOUBLE, G_MAXDOUBLE, 4.9406564584124654e-324,
+    };
+    GRand *rand;
+    guint i;
+
+    for(i = 0; i < G_N_ELEMENTS(values); ++i) {
+        if(!check_double(values[i]) || !check_double(-values[i]))
+            return 1;
+    }
+
+    if(!check_format(0.1, "0.1")
+       || !check_format(1e-9, "1e-09")
+       || !check_format(42.0, "42")
+       || !check_format(-2.5, "-2.5")
+       || !check_format(-0.0, "-0")
+       || !check_format(1.0 / 3.0, "0.3333333333333333"))
+    {
+        return 1;
+    }
+
+    rand = g_rand_new_with_seed(42);
+
+    for(i = 0; i < N_RANDOM; ++i) {
+        gdouble val = random_double(rand);
+        gfloat fval = (gfloat)g_rand_double_range(rand, -1e6, 1e6);
+
+        if(!check_double(val) || !check_float(fval))
+            return 1;
+    }
+
+    /* files written with "%f" still read the same */
+    for(i = 0; i < N_RANDOM; ++i) {
+        gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+        g_ascii_formatd(buf, sizeof(buf), "%f", g_rand_double_range(rand, -1e6, 1e6));
+        if(_esconf_ascii_strtod(buf, NULL) != g_ascii_strtod(buf, NULL)) {
+            g_critical("Test failed: \"%s\" parsed differently", buf);
+            return 1;
+        }
+    }
+
+    benchmark(rand);
+
+    g_rand_free(rand);
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "tests-common.h"
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+typedef struct
+{
+    gboolean done;
+    gboolean result;
+} InitData;
+
+static void
+init_ready(GObject *source,
+           GAsyncResult *res,
+           gpointer user_data)
+{
+    InitData *data = user_data;
+    GError *error = NULL;
+
+    data->result = esconf_init_finish(res, &error);
+    if(!data->result) {
+        g_critical("esconf_init_async() failed: %s", error->message);
+        g_error_free(error);
+    }
+    data->done = TRUE;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    EsconfChannel *channel;
+    InitData data = { FALSE, FALSE };
+
+    if(!esconf_tests_start())
+        return 1;
+
+    /* nested async init on top of the synchronous one */
+    esconf_init_async(NULL, init_ready, &data);
+    while(!data.done)
+        g_main_context_iteration(NULL, TRUE);
+
+    TEST_OPERATION(data.result);
+
+    channel = esconf_channel_new(TEST_CHANNEL_NAME);
+    TEST_OPERATION(esconf_channel_set_string(channel, test_string_property, test_string));
+    TEST_OPERATION(!strcmp(esconf_channel_peek_string(channel, test_string_property, ""), test_string));
+    g_object_unref(G_OBJECT(channel));
+
+    /* balance esconf_init_async() */
+    esconf_shutdown();
+
+    esconf_tests_end();
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* checks that the perchannel-xml backend reads a channel file the same
+ * whether its own parser handles it or it falls back to GMarkup.  each
+ * fixture is written twice, once as is and once with something only
+ * GMarkup accepts, and both channels have to end up the same. */
+
+#include "tests-common.h"
+#include "common/esconf-gvaluefuncs.h"
+
+#include <glib/gstdio.h>
+
+#define XML_HEADER  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+
+/* comments, entities, character references, both quotes, self-closing
+ * and empty elements, and whitespace in attribute values */
+#define FIXTURE_BASIC \
+    "<!-- before the root -->\n" \
+    "<channel name=\"%s\" version=\"1.0\">\n" \
+    "  <!-- a comment with <property> in it -->\n" \
+    "  <property name=\"entities\" type=\"string\" value=\"&amp;&lt;&gt;&quot;&apos;\"/>\n" \
+    "  <property name=\"charrefs\" type=\"string\" value=\"&#65;&#x42;&#xe9;&#x20AC;\"/>\n" \
+    "  <property name=\"escaped-space\" type=\"string\" value=\"a&#x9;b&#xA;c&#xD;d\"/>\n" \
+    "  <property name=\"raw-space\" type=\"string\" value=\"a\tb\nc\r\nd\re\"/>\n" \
+    "  <property name='quotes' type='string' value='it&apos;s \"quoted\"'/>\n" \
+    "  <property name=\"numbers\" type=\"empty\">\n" \
+    "    <property name=\"int\" type=\"int\" value=\"-42\"/>\n" \
+    "    <property name=\"uint\" type=\"uint\" value=\"42\" />\n" \
+    "    <property name=\"uint64\" type=\"uint64\" value=\"42000000000\"></property>\n" \
+    "    <property name=\"double\" type=\"double\" value=\"-0.5\"/>\n" \
+    "    <property name=\"bool\" type=\"bool\" value=\"true\"/>\n" \
+    "  </property>\n" \
+    "  <property name=\"array\" type=\"array\">\n" \
+    "    <value type=\"string\" value=\"one&#xA;two\"/>\n" \
+    "    <value type=\"int\" value=\"3\"></value>\n" \
+    "  </property>\n" \
+    "  <property\n\tname=\"spaced\"\r\n  type = \"string\"  value=\"x\"  ></property>\n" \
+    "</channel>\n"
+
+/* things the backend's parser gives up on, but GMarkup ignores */
+#define FIXTURE_FALLBACK_FAST \
+    "<channel name=\"%s\" version=\"1.0\">\n" \
+    "  <property name=\"text\" type=\"empty\">\n" \
+    "    <property name=\"a\" type=\"string\" value=\"1\"/>\n" \
+    "  </property>\n" \
+    "  <property name=\"cdata\" type=\"string\" value=\"2\"/>\n" \
+    "</channel>\n"
+#define FIXTURE_FALLBACK_MARKUP \
+    "<channel name=\"%s\" version=\"1.0\">\n" \
+    "  <property name=\"text\" type=\"empty\">some text\n" \
+    "    <property name=\"a\" type=\"string\" value=\"1\"/>\n" \
+    "  </property>\n" \
+    "  <property name=\"cdata\" type=\"string\" value=\"2\"><![CDATA[<x>]]></property>\n" \
+    "</channel>\n"
+
+/* a DOCTYPE is enough to make the backend use GMarkup */
+#define MARKUP_ONLY  "<!DOCTYPE channel>\n"
+
+static gchar *
+write_channel(const gchar *channel_name,
+              const gchar *prefix,
+              const gchar *format)
+{
+    gchar *dirname, *filename, *basename, *body, *contents;
+    gboolean written;
+
+    dirname = g_build_filename(g_get_user_config_dir(),
+                               "expidus1", "esconf", "expidus-perchannel-xml",
+                               NULL);
+    g_mkdir_with_parents(dirname, 0700);
+    basename = g_strconcat(channel_name, ".xml", NULL);
+    filename = g_build_filename(dirname, basename, NULL);
+    g_free(basename);
+    g_free(dirname);
+
+    body = g_strdup_printf(format, channel_name);
+    contents = g_strconcat(XML_HEADER, prefix, body, NULL);
+    written = g_file_set_contents(filename, contents, -1, NULL);
+    g_free(contents);
+    g_free(body);
+
+    if(!written) {
+        g_free(filename);
+        return NULL;
+    }
+
+    return filename;
+}
+
+/* reads the two channels through the daemon and compares them */
+static gboolean
+compare_channels(const gchar *fast_name,
+                 const gchar *markup_name)
+{
+    EsconfChannel *fast, *markup;
+    GHashTable *fast_props, *markup_props;
+    GHashTableIter iter;
+    const gchar *property;
+    const GValue *value;
+    gboolean same;
+
+    fast = esconf_channel_new(fast_name);
+    markup = esconf_channel_new(markup_name);
+    fast_props = esconf_channel_get_properties(fast, NULL);
+    markup_props = esconf_channel_get_properties(markup, NULL);
+
+    same = fast_props && markup_props
+           && g_hash_table_size(fast_props) > 0
+           && g_hash_table_size(fast_props) == g_hash_table_size(markup_props);
+
+    if(same) {
+        g_hash_table_iter_init(&iter, fast_props);
+        while(same && g_hash_table_iter_next(&iter, (gpointer)&property,
+                                             (gpointer)&value))
+        {
+            same = _esconf_gvalue_is_equal(value,
+                                           g_hash_table_lookup(markup_props,
+                                                               property));
+            if(!same)
+                g_critical("Property \"%s\" differs between the parsers", property);
+        }
+    }
+
+    if(fast_props)
+        g_hash_table_destroy(fast_props);
+    if(markup_props)
+        g_hash_table_destroy(markup_props);
+    g_object_unref(G_OBJECT(fast));
+    g_object_unref(G_OBJECT(markup));
+
+    return same;
+}
+
+static gboolean
+check_string(const gchar *channel_name,
+             const gchar *property,
+             const gchar *expected)
+{
+    EsconfChannel *channel = esconf_channel_new(channel_name);
+    gchar *value = esconf_channel_get_string(channel, property, NULL);
+    gboolean ret = !g_strcmp0(value, expected);
+
+    if(!ret)
+        g_critical("\"%s\" on \"%s\" is \"%s\"", property, channel_name, value);
+
+    g_free(value);
+    g_object_unref(G_OBJECT(channel));
+
+    return ret;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    gchar *files[4];
+    gboolean ret;
+    gint i;
+
+    if(!esconf_tests_start())
+        return 2;
+
+    /* the channels are read when they are first used, after this */
+    files[0] = write_channel("test-xml-basic-fast", "", FIXTURE_BASIC);
+    files[1] = write_channel("test-xml-basic-markup", MARKUP_ONLY, FIXTURE_BASIC);
+    files[2] = write_channel("test-xml-fallback-fast", "", FIXTURE_FALLBACK_FAST);
+    files[3] = write_channel("test-xml-fallback-markup", "", FIXTURE_FALLBACK_MARKUP);
+
+    ret = files[0] && files[1] && files[2] && files[3]
+          && compare_channels("test-xml-basic-fast", "test-xml-basic-markup")
+          && compare_channels("test-xml-fallback-fast", "test-xml-fallback-markup")
+          && check_string("test-xml-basic-fast", "/entities", "&<>\"'")
+          && check_string("test-xml-basic-fast", "/charrefs", "AB\xc3\xa9\xe2\x82\xac")
+          && check_string("test-xml-basic-fast", "/escaped-space", "a\tb\nc\rd")
+          && check_string("test-xml-basic-fast", "/raw-space", "a b c d e")
+          && check_string("test-xml-basic-fast", "/quotes", "it's \"quoted\"");
+
+    for(i = 0; i < 4; ++i) {
+        if(files[i]) {
+            g_unlink(files[i]);
+            g_free(files[i]);
+        }
+    }
+
+    esconf_tests_end();
+
+    return ret ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "tests-common.h"
+
+typedef struct
+{
+    GMainLoop *mloop;
+    gboolean got_signal;
+} SignalTestData;
+
+static void
+test_signal_changed(EsconfChannel *channel,
+                    const gchar *property,
+                    const GValue *value,
+                    gpointer user_data)
+{
+    SignalTestData *std = user_data;
+    if(!g_strcmp0(property, test_strlist_property))
+        std->got_signal = TRUE;
+}
+
+static gboolean
+test_watchdog(gpointer data)
+{
+    SignalTestData *std = data;
+    g_main_loop_quit(std->mloop);
+    return FALSE;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    EsconfChannel *channel;
+    SignalTestData std = { NULL, FALSE };
+    gulong handler;
+
+    std.mloop = g_main_loop_new(NULL, FALSE);
+
+    if(!esconf_tests_start())
+        return 2;
+
+    channel = esconf_channel_new(TEST_CHANNEL_NAME);
+
+    TEST_OPERATION(esconf_channel_set_string_list(channel, test_strlist_property,
+                                                  test_strlist));
+
+    /* let the daemon's notification for the first write arrive */
+    g_timeout_add(500, test_watchdog, &std);
+    g_main_loop_run(std.mloop);
+
+    handler = g_signal_connect(G_OBJECT(channel), "property-changed",
+                               G_CALLBACK(test_signal_changed), &std);
+
+    /* writing an identical array must not be reported as a change */
+    TEST_OPERATION(esconf_channel_set_string_list(channel, test_strlist_property,
+                                                  test_strlist));
+
+    g_timeout_add(1000, test_watchdog, &std);
+    g_main_loop_run(std.mloop);
+
+    g_signal_handler_disconnect(G_OBJECT(channel), handler);
+
+    g_main_loop_unref(std.mloop);
+    g_object_unref(G_OBJECT(channel));
+
+    esconf_tests_end();
+
+    return std.got_signal ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "tests-common.h"
+
+#define CHANGED_PROPERTY    "/reload/changed"
+#define UNCHANGED_PROPERTY  "/reload/unchanged"
+
+typedef struct
+{
+    GMainLoop *mloop;
+    gboolean got_changed;
+    gboolean got_unchanged;
+} SignalTestData;
+
+static void
+test_signal_changed(EsconfChannel *channel,
+                    const gchar *property,
+                    const GValue *value,
+                    gpointer user_data)
+{
+    SignalTestData *std = user_data;
+
+    if(!g_strcmp0(property, CHANGED_PROPERTY)) {
+        std->got_changed = G_VALUE_HOLDS_STRING(value)
+                           && !g_strcmp0(g_value_get_string(value), "new");
+        g_main_loop_quit(std->mloop);
+    } else if(!g_strcmp0(property, UNCHANGED_PROPERTY))
+        std->got_unchanged = TRUE;
+}
+
+static gboolean
+test_watchdog(gpointer data)
+{
+    SignalTestData *std = data;
+    g_main_loop_quit(std->mloop);
+    return FALSE;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    EsconfChannel *channel;
+    SignalTestData std = { NULL, FALSE, FALSE };
+    gchar *filename;
+    gulong handler;
+    gboolean written;
+
+    std.mloop = g_main_loop_new(NULL, FALSE);
+
+    if(!esconf_tests_start())
+        return 2;
+
+    channel = esconf_channel_new(TEST_CHANNEL_NAME);
+
+    TEST_OPERATION(esconf_channel_set_string(channel, CHANGED_PROPERTY, "old"));
+    TEST_OPERATION(esconf_channel_set_string(channel, UNCHANGED_PROPERTY, "same"));
+
+    g_timeout_add(500, test_watchdog, &std);
+    g_main_loop_run(std.mloop);
+
+    handler = g_signal_connect(G_OBJECT(channel), "property-changed",
+                               G_CALLBACK(test_signal_changed), &std);
+
+    /* edit the channel file behind the daemon's back; it has to pick
+     * up the change and only report the property that differs */
+    filename = g_build_filename(g_get_user_config_dir(),
+                                "expidus1", "esconf", "expidus-perchannel-xml",
+                                TEST_CHANNEL_NAME ".xml", NULL);
+    written = g_file_set_contents(filename,
+                                  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n"
+                                  "<channel name=\"" TEST_CHANNEL_NAME "\" version=\"1.0\">\n"
+                                  "  <property name=\"reload\" type=\"empty\">\n"
+                                  "    <property name=\"changed\" type=\"string\" value=\"new\"/>\n"
+                                  "    <property name=\"unchanged\" type=\"string\" value=\"same\"/>\n"
+                                  "  </property>\n"
+                                  "</channel>\n",
+                                  -1, NULL);
+    g_free(filename);
+
+    if(written) {
+        g_timeout_add_seconds(5, test_watchdog, &std);
+        g_main_loop_run(std.mloop);
+    }
+
+    g_signal_handler_disconnect(G_OBJECT(channel), handler);
+
+    g_main_loop_unref(std.mloop);
+    g_object_unref(G_OBJECT(channel));
+
+    esconf_tests_end();
+
+    return written && std.got_changed && !std.got_unchanged ? 0 : 1;
+}
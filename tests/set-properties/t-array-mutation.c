@@ -0,0 +1,92 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "tests-common.h"
+
+static gboolean
+check_strlist(EsconfChannel *channel,
+              const gchar *property,
+              const gchar **expected)
+{
+    gchar **strlist;
+    gboolean ret = FALSE;
+    guint i;
+
+    strlist = esconf_channel_get_string_list(channel, property);
+    if(strlist && g_strv_length(strlist) == g_strv_length((gchar **)expected)) {
+        for(i = 0; strlist[i] && !g_strcmp0(strlist[i], expected[i]); ++i);
+        ret = strlist[i] == NULL;
+    }
+    g_strfreev(strlist);
+
+    return ret;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    EsconfChannel *channel;
+    GValue value = { 0, };
+    const gchar *property = "/test/arraymutation/strlist";
+    const gchar *initial[] = { "one", "two", "three", NULL };
+    const gchar *after_set[] = { "one", "TWO", "three", NULL };
+    const gchar *after_insert[] = { "zero", "one", "TWO", "three", "four", NULL };
+    const gchar *after_remove[] = { "zero", "TWO", "three", "four", NULL };
+
+    if(!esconf_tests_start())
+        return 1;
+
+    channel = esconf_channel_new(TEST_CHANNEL_NAME);
+
+    TEST_OPERATION(esconf_channel_set_string_list(channel, property, initial));
+
+    g_value_init(&value, G_TYPE_STRING);
+
+    g_value_set_static_string(&value, "TWO");
+    TEST_OPERATION(esconf_channel_array_set_index(channel, property, 1, &value));
+    TEST_OPERATION(check_strlist(channel, property, after_set));
+
+    g_value_set_static_string(&value, "zero");
+    TEST_OPERATION(esconf_channel_array_insert(channel, property, 0, &value));
+    g_value_set_static_string(&value, "four");
+    TEST_OPERATION(esconf_channel_array_insert(channel, property, 4, &value));
+    TEST_OPERATION(check_strlist(channel, property, after_insert));
+
+    TEST_OPERATION(esconf_channel_array_remove(channel, property, 1));
+    TEST_OPERATION(check_strlist(channel, property, after_remove));
+
+    /* out of range */
+    TEST_OPERATION(!esconf_channel_array_remove(channel, property, 4));
+    TEST_OPERATION(!esconf_channel_array_set_index(channel, property, 4, &value));
+
+    /* the daemon ends up with the same array */
+    g_object_unref(G_OBJECT(channel));
+    channel = esconf_channel_new(TEST_CHANNEL_NAME);
+    TEST_OPERATION(check_strlist(channel, property, after_remove));
+
+    esconf_channel_reset_property(channel, property, FALSE);
+
+    g_value_unset(&value);
+    g_object_unref(G_OBJECT(channel));
+
+    esconf_tests_end();
+
+    return 0;
+}
@@ -18,17 +18,23 @@ ESCONFD_DIR=$1
 TEST=$2
 ESCONFD=$ESCONFD_DIR/esconfd
 
+# options for esconfd, e.g. to try another backend; a test directory
+# sets this through AM_TESTS_ENVIRONMENT
+ESCONFD_ARGS=${ESCONFD_ARGS:-}
+
 ESCONF_RUN_IN_TEST_MODE=1; export ESCONF_RUN_IN_TEST_MODE;
 
 exec_esconfd()
 {
 	rm $ESCONFD_DIR/.esconfd-test-pid >/dev/null 2>&1
 	rm $ESCONFD_DIR/.esconfd-sum >/dev/null 2>&1
+	rm $ESCONFD_DIR/.esconfd-args >/dev/null 2>&1
 
-	exec ${ESCONFD} &
+	exec ${ESCONFD} ${ESCONFD_ARGS} &
 	echo $! > $ESCONFD_DIR/.esconfd-test-pid
 	pid=`cat $ESCONFD_DIR/.esconfd-test-pid`
 	sum $ESCONFD > $ESCONFD_DIR/.esconfd-sum
+	echo "${ESCONFD_ARGS}" > $ESCONFD_DIR/.esconfd-args
 }
 
 cleanup()
@@ -37,6 +43,7 @@ cleanup()
 
 	rm $ESCONFD_DIR/.esconfd-test-pid >/dev/null 2>&1
 	rm $ESCONFD_DIR/.esconfd-sum >/dev/null 2>&1
+	rm $ESCONFD_DIR/.esconfd-args >/dev/null 2>&1
 
 	while kill -0 $pid >/dev/null 2>&1; do
 		kill -s TERM $pid >/dev/null 2>&1
@@ -59,9 +66,10 @@ prepare()
 	else
 		oldsum=`cat $ESCONFD_DIR/.esconfd-sum`
 		newsum=`sum ${ESCONFD}`
+		oldargs=`cat $ESCONFD_DIR/.esconfd-args 2>/dev/null`
 
-		# Did esconfd changes ?
-		if [ "$newsum" != "$oldsum" ]; then
+		# Did esconfd or its options change ?
+		if [ "$newsum" != "$oldsum" ] || [ "$ESCONFD_ARGS" != "$oldargs" ]; then
 			cleanup
 			exec_esconfd
 		else
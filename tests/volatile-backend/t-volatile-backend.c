@@ -0,0 +1,106 @@
+/*
+ *  esconf
+ *
+ *  Copyright (c) 2022 ExpidusOS contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* esconfd runs with "--backends expidus-volatile --snapshot
+ * snapshot.gvariant" here, see Makefile.am */
+
+#include "tests-common.h"
+
+#define VOLATILE_CHANNEL_NAME  "test-volatile"
+
+static gboolean
+channel_is_listed(void)
+{
+    gchar **channels = esconf_list_channels();
+    gboolean found = channels && g_strv_contains((const gchar * const *)channels,
+                                                 VOLATILE_CHANNEL_NAME);
+
+    g_strfreev(channels);
+
+    return found;
+}
+
+/* what the perchannel-xml backend would have written */
+static gboolean
+channel_file_exists(void)
+{
+    gchar *filename = g_build_filename(g_get_user_config_dir(),
+                                       "expidus1", "esconf",
+                                       "expidus-perchannel-xml",
+                                       VOLATILE_CHANNEL_NAME ".xml", NULL);
+    gboolean exists = g_file_test(filename, G_FILE_TEST_EXISTS);
+
+    g_free(filename);
+
+    return exists;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    EsconfChannel *channel;
+    gchar *str;
+    gboolean ok;
+
+    if(!esconf_tests_start())
+        return 1;
+
+    channel = esconf_channel_new(VOLATILE_CHANNEL_NAME);
+
+    /* seeded from the snapshot */
+    TEST_OPERATION(channel_is_listed());
+    str = esconf_channel_get_string(channel, "/seeded/string", NULL);
+    ok = !g_strcmp0(str, "seeded");
+    g_free(str);
+    TEST_OPERATION(ok);
+    TEST_OPERATION(esconf_channel_get_int(channel, "/seeded/int", 0) == 42);
+    TEST_OPERATION(esconf_channel_get_bool(channel, "/seeded/nested/bool", FALSE));
+
+    /* set and read back */
+    TEST_OPERATION(esconf_channel_set_string(channel, test_string_property, test_string));
+    TEST_OPERATION(esconf_channel_set_int(channel, test_int_property, test_int));
+    str = esconf_channel_get_string(channel, test_string_property, NULL);
+    ok = !g_strcmp0(str, test_string);
+    g_free(str);
+    TEST_OPERATION(ok);
+    TEST_OPERATION(esconf_channel_get_int(channel, test_int_property, 0) == test_int);
+
+    /* a recursive reset takes everything below the base with it */
+    esconf_channel_reset_property(channel, "/seeded", TRUE);
+    TEST_OPERATION(!esconf_channel_has_property(channel, "/seeded/string"));
+    TEST_OPERATION(!esconf_channel_has_property(channel, "/seeded/int"));
+    TEST_OPERATION(!esconf_channel_has_property(channel, "/seeded/nested/bool"));
+    TEST_OPERATION(esconf_channel_has_property(channel, test_int_property));
+
+    /* nothing may reach the disk */
+    TEST_OPERATION(!channel_file_exists());
+
+    /* the channel goes away with its last property */
+    esconf_channel_reset_property(channel, "/test", TRUE);
+    TEST_OPERATION(!esconf_channel_has_property(channel, test_string_property));
+    TEST_OPERATION(!channel_is_listed());
+    TEST_OPERATION(!channel_file_exists());
+
+    g_object_unref(G_OBJECT(channel));
+
+    esconf_tests_end();
+
+    return 0;
+}